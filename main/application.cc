@@ -8,6 +8,19 @@
 #include "websocket_protocol.h"
 #include "font_awesome_symbols.h"
 #include "iot/thing_manager.h"
+#include "memory_tracker.h"
+#include "debug_console.h"
+#include "boot_profiler.h"
+#include "boot_sequence.h"
+#if CONFIG_USE_TASK_PROFILER
+#include "task_profiler.h"
+#endif
+#if CONFIG_USE_ASSET_PARTITION
+#include "assets.h"
+#endif
+#if CONFIG_USE_BENCHMARK
+#include "benchmark.h"
+#endif
 #include "assets/lang_config.h"
 
 #include <cstring>
@@ -283,10 +296,7 @@ void Application::CheckNewVersion() {
                 auto codec = board.GetAudioCodec();
                 codec->EnableInput(false);
                 codec->EnableOutput(false);
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_decode_queue_.clear();
-                }
+                audio_mixer_.ResetAll();
                 background_task_->WaitForCompletion();
                 delete background_task_;
                 background_task_ = nullptr;
@@ -342,7 +352,7 @@ void Application::ShowActivationCode() {
 
     struct digit_sound {
         char digit;
-        const std::string_view& sound;
+        std::string_view sound;
     };
     static const std::array<digit_sound, 10> digit_sounds{{
         digit_sound{'0', Lang::Sounds::P3_0},
@@ -366,7 +376,8 @@ void Application::ShowActivationCode() {
         auto it = std::find_if(digit_sounds.begin(), digit_sounds.end(),
             [digit](const digit_sound& ds) { return ds.digit == digit; });
         if (it != digit_sounds.end()) {
-            PlaySound(it->sound);
+            // 和激活提示音在同一路排队，依次播放
+            PlaySound(it->sound, kAudioStreamNotification);
         }
     }
 }
@@ -378,8 +389,7 @@ void Application::Alert(const char* status, const char* message, const char* emo
     display->SetEmotion(emotion);
     display->SetChatMessage("system", message);
     if (!sound.empty()) {
-        ResetDecoder();
-        PlaySound(sound);
+        PlaySound(sound, kAudioStreamNotification);
     }
 }
 
@@ -392,24 +402,34 @@ void Application::DismissAlert() {
     }
 }
 
-void Application::PlaySound(const std::string_view& sound) {
+void Application::PlaySound(const std::string_view& sound, AudioStreamId stream) {
     // The assets are encoded at 16000Hz, 60ms frame duration
-    SetDecodeSampleRate(16000, 60);
+    // 提示音有独立的解码器，和 TTS 同时播放时不需要重建解码器
+    audio_mixer_.ConfigureStream(stream, 16000, 60);
     const char* data = sound.data();
-    size_t size = sound.size();
-    for (const char* p = data; p < data + size; ) {
-        auto p3 = (BinaryProtocol3*)p;
+    const char* end = data + sound.size();
+    // 整段提示音的包描述一次入队，包内容仍指向 flash 中的资源
+    std::vector<AudioPacket> packets;
+    for (const char* p = data; p + sizeof(BinaryProtocol3) <= end; ) {
+        auto p3 = (const BinaryProtocol3*)p;
         p += sizeof(BinaryProtocol3);
 
         auto payload_size = ntohs(p3->payload_size);
-        std::vector<uint8_t> opus;
-        opus.resize(payload_size);
-        memcpy(opus.data(), p3->payload, payload_size);
+        if (p + payload_size > end) {
+            ESP_LOGE(TAG, "Truncated P3 packet in sound asset");
+            break;
+        }
         p += payload_size;
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(opus));
+        AudioPacket packet;
+        packet.asset = p3->payload;
+        packet.asset_size = payload_size;
+        packets.emplace_back(std::move(packet));
     }
+    audio_mixer_.Push(stream, std::move(packets));
+
+    last_output_time_ = std::chrono::steady_clock::now();
+    Board::GetInstance().GetAudioCodec()->EnableOutput(true);
 }
 
 void Application::ToggleChatState() {
@@ -482,73 +502,34 @@ void Application::StopListening() {
     });
 }
 
-void Application::Start() {
+void Application::InitializeProtocol() {
     auto& board = Board::GetInstance();
-    SetDeviceState(kDeviceStateStarting);
-
-    /* Setup the display */
     auto display = board.GetDisplay();
-    avi_player_port_config_t config = {
-        .buffer_size = 50 * 1024,
-        .core_id = 1,
-        .display = display  // 传入LCD显示对象指针
-    };
-    avi_player_port_init(&config);
-    int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
-    int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
-    int free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    ESP_LOGI(TAG, "Free internal: %u minimal internal: %u free_psram: %u", free_sram, min_free_sram, free_psram);
-    /* Setup the audio codec */
     auto codec = board.GetAudioCodec();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
-    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
-    if (realtime_chat_enabled_) {
-        ESP_LOGI(TAG, "Realtime chat enabled, setting opus encoder complexity to 0");
-        opus_encoder_->SetComplexity(0);
-    } else if (board.GetBoardType() == "ml307") {
-        ESP_LOGI(TAG, "ML307 board detected, setting opus encoder complexity to 5");
-        opus_encoder_->SetComplexity(5);
-    } else {
-        ESP_LOGI(TAG, "WiFi board detected, setting opus encoder complexity to 3");
-        opus_encoder_->SetComplexity(3);
-    }
-
-    if (codec->input_sample_rate() != 16000) {
-        input_resampler_.Configure(codec->input_sample_rate(), 16000);
-        reference_resampler_.Configure(codec->input_sample_rate(), 16000);
-    }
-    codec->Start();
-
-    xTaskCreatePinnedToCore([](void* arg) {
-        Application* app = (Application*)arg;
-        app->AudioLoop();
-        vTaskDelete(NULL);
-    }, "audio_loop", 4096 * 2, this, 8, &audio_loop_task_handle_, realtime_chat_enabled_ ? 1 : 0);
-
-    /* Start the main loop */
-    xTaskCreatePinnedToCore([](void* arg) {
-        Application* app = (Application*)arg;
-        app->MainLoop();
-        vTaskDelete(NULL);
-    }, "main_loop", 4096 * 2, this, 4, &main_loop_task_handle_, 0);
-
-    /* Wait for the network to be ready */
-    board.StartNetwork();
 
     // Initialize the protocol
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+#if CONFIG_USE_SESSION_RECORD
+    // 通过 replay 命令重启时用回放协议代替网络协议
+    replay_ = ReplayProtocol::CreateFromSettings();
+    protocol_.reset(replay_);
+#endif
+    if (!protocol_) {
 #ifdef CONFIG_CONNECTION_TYPE_WEBSOCKET
-    protocol_ = std::make_unique<WebsocketProtocol>();
+        protocol_ = std::make_unique<WebsocketProtocol>();
 #else
-    protocol_ = std::make_unique<MqttProtocol>();
+        protocol_ = std::make_unique<MqttProtocol>();
 #endif
+    }
     protocol_->OnNetworkError([this](const std::string& message) {
         SetDeviceState(kDeviceStateIdle);
         Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
     });
     protocol_->OnIncomingAudio([this](std::vector<uint8_t>&& data) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(data));
+#if CONFIG_USE_SESSION_RECORD
+        SessionRecorder::GetInstance().Record(kSessionRecordDownlinkAudio, data.data(), data.size());
+#endif
+        audio_mixer_.Push(kAudioStreamTts, AudioPacket{std::move(data)});
     });
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
         board.SetPowerSaveMode(false);
@@ -557,6 +538,18 @@ void Application::Start() {
                 protocol_->server_sample_rate(), codec->output_sample_rate());
         }
         SetDecodeSampleRate(protocol_->server_sample_rate(), protocol_->server_frame_duration());
+#if CONFIG_USE_SESSION_RECORD
+        SessionRecorder::GetInstance().OnChannelOpened(codec->input_sample_rate(), codec->input_channels(),
+            protocol_->server_sample_rate(), protocol_->server_frame_duration());
+#endif
+#if CONFIG_USE_UPLINK_ADAPTATION
+        // 协议层已恢复默认帧长，编码器在下一个帧边界跟着恢复
+        uplink_adapter_->Reset();
+        background_task_->Schedule([this, complexity = uplink_adapter_->complexity()]() {
+            next_frame_duration_ = opus_encoder_->duration_ms() != OPUS_FRAME_DURATION_MS ? OPUS_FRAME_DURATION_MS : 0;
+            next_complexity_ = complexity;
+        });
+#endif
         auto& thing_manager = iot::ThingManager::GetInstance();
         protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson());
         std::string states;
@@ -565,6 +558,9 @@ void Application::Start() {
         }
     });
     protocol_->OnAudioChannelClosed([this, &board]() {
+#if CONFIG_USE_SESSION_RECORD
+        SessionRecorder::GetInstance().OnChannelClosed();
+#endif
         board.SetPowerSaveMode(true);
         Schedule([this]() {
             auto display = Board::GetInstance().GetDisplay();
@@ -573,6 +569,16 @@ void Application::Start() {
         });
     });
     protocol_->OnIncomingJson([this, display](const cJSON* root) {
+#if CONFIG_USE_SESSION_RECORD
+        auto& recorder = SessionRecorder::GetInstance();
+        if (recorder.IsRecording()) {
+            char* text = cJSON_PrintUnformatted(root);
+            if (text != nullptr) {
+                recorder.Record(kSessionRecordDownlinkJson, text, strlen(text));
+                cJSON_free(text);
+            }
+        }
+#endif
         // Parse JSON data
         auto type = cJSON_GetObjectItem(root, "type");
         if (strcmp(type->valuestring, "tts") == 0) {
@@ -629,33 +635,179 @@ void Application::Start() {
                     thing_manager.Invoke(command);
                 }
             }
+        } else if (strcmp(type->valuestring, "diagnostics") == 0) {
+            auto query = cJSON_GetObjectItem(root, "query");
+            if (cJSON_IsString(query) && strcmp(query->valuestring, "memory") == 0) {
+                Schedule([this]() {
+                    protocol_->SendDiagnostics("memory", MemoryTracker::GetInstance().GetReportJson());
+                });
+            } else if (cJSON_IsString(query) && strcmp(query->valuestring, "boot") == 0) {
+                Schedule([this]() {
+                    protocol_->SendDiagnostics("boot", BootProfiler::GetInstance().GetReportJson());
+                });
+#if CONFIG_USE_TASK_PROFILER
+            } else if (cJSON_IsString(query) && strcmp(query->valuestring, "tasks") == 0) {
+                Schedule([this]() {
+                    protocol_->SendDiagnostics("tasks", TaskProfiler::GetInstance().GetReportJson());
+                });
+#endif
+            }
         }
     });
-    protocol_->Start();
+    {
+        // 只统计客户端初始化的开销，之后收发消息的分配不计入
+        MemoryScope scope(kMemoryTagProtocol);
+        protocol_->Start();
+    }
+}
 
-    // Check for new firmware version or get the MQTT broker address
-    ota_.SetCheckVersionUrl(CONFIG_OTA_VERSION_URL);
-    ota_.SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
-    ota_.SetHeader("Client-Id", board.GetUuid());
-    ota_.SetHeader("Accept-Language", Lang::CODE);
-    auto app_desc = esp_app_get_description();
-    ota_.SetHeader("User-Agent", std::string(BOARD_NAME "/") + app_desc->version);
+void Application::Start() {
+    // 第一次获取 Board 时会初始化外设和屏幕
+    BootProfiler::GetInstance().Begin("board");
+    auto& board = Board::GetInstance();
+    BootProfiler::GetInstance().End("board");
+    SetDeviceState(kDeviceStateStarting);
+    auto display = board.GetDisplay();
+    auto codec = board.GetAudioCodec();
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+    // 要在各阶段读取输入声道数之前启用
+    codec->EnableSoftwareReference();
+#endif
 
-    xTaskCreate([](void* arg) {
+    /* Start the main loop */
+    xTaskCreatePinnedToCore([](void* arg) {
         Application* app = (Application*)arg;
-        app->CheckNewVersion();
+        app->MainLoop();
         vTaskDelete(NULL);
-    }, "check_new_version", 4096 * 2, this, 2, nullptr);
+    }, "main_loop", 4096 * 2, this, 4, &main_loop_task_handle_, 0);
+
+    // 互不依赖的阶段并行执行，并行期间 MemoryScope 统计的是整个堆的变化，归属只是近似值
+    BootSequence boot;
+    boot.AddPhase("display", {}, [display]() {
+#if CONFIG_USE_ASSET_PARTITION
+        Assets::GetInstance().Initialize();
+#endif
+        avi_player_port_config_t config = {
+            .buffer_size = 50 * 1024,
+            .core_id = 1,
+            .display = display  // 传入LCD显示对象指针
+        };
+        MemoryScope scope(kMemoryTagVideo);
+        avi_player_port_init(&config);
+    }, 4096);
+
+    boot.AddPhase("codec", {}, [this, &board, codec]() {
+        {
+            MemoryScope scope(kMemoryTagAudio);
+            audio_mixer_.Initialize(codec->output_sample_rate());
+            audio_mixer_.ConfigureStream(kAudioStreamTts, codec->output_sample_rate(), OPUS_FRAME_DURATION_MS);
+            opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
+        }
+        int complexity;
+        if (realtime_chat_enabled_) {
+            ESP_LOGI(TAG, "Realtime chat enabled, setting opus encoder complexity to 0");
+            complexity = 0;
+        } else if (board.GetBoardType() == "ml307") {
+            ESP_LOGI(TAG, "ML307 board detected, setting opus encoder complexity to 5");
+            complexity = 5;
+        } else {
+            ESP_LOGI(TAG, "WiFi board detected, setting opus encoder complexity to 3");
+            complexity = 3;
+        }
+        opus_encoder_->SetComplexity(complexity);
+#if CONFIG_USE_UPLINK_ADAPTATION
+        // 板级选择的复杂度作为自适应的上限
+        uplink_adapter_ = std::make_unique<UplinkAdapter>(OPUS_FRAME_DURATION_MS, complexity);
+#endif
+
+        if (codec->input_sample_rate() != 16000) {
+            input_resampler_.Configure(codec->input_sample_rate(), 16000, codec->input_channels());
+        }
+        codec->Start();
+
+        xTaskCreatePinnedToCore([](void* arg) {
+            Application* app = (Application*)arg;
+            app->AudioLoop();
+            vTaskDelete(NULL);
+        }, "audio_loop", 4096 * 2, this, 8, &audio_loop_task_handle_, realtime_chat_enabled_ ? 1 : 0);
+    }, 4096 * 2);
+
+#if CONFIG_USE_AUDIO_PROCESSOR || CONFIG_USE_WAKE_WORD_DETECT
+    // 加载 AFE 和唤醒词模型，检测在所有阶段完成后才开始
+    boot.AddPhase("models", {}, [this, codec]() {
+        MemoryScope scope(kMemoryTagAudio);
+#if CONFIG_USE_AUDIO_PROCESSOR
+        audio_processor_.Initialize(codec, realtime_chat_enabled_);
+#endif
+#if CONFIG_USE_WAKE_WORD_DETECT
+        wake_word_detect_.Initialize(codec);
+#endif
+#if CONFIG_USE_COMMAND_WORD_DETECT
+        command_word_detect_.Initialize(CONFIG_COMMAND_WORD_TABLE);
+#endif
+    }, 4096 * 2);
+#endif
+
+    /* Wait for the network to be ready */
+    // 配网模式会播放提示音，所以要等音频编解码器就绪；网络阶段在当前任务中执行
+    boot.AddPhase("network", {"codec"}, [&board]() {
+        board.StartNetwork();
+    });
+    boot.AddPhase("ota", {"network"}, [this, &board]() {
+        // Check for new firmware version or get the MQTT broker address
+        ota_.SetCheckVersionUrl(CONFIG_OTA_VERSION_URL);
+        ota_.SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
+        ota_.SetHeader("Client-Id", board.GetUuid());
+        ota_.SetHeader("Accept-Language", Lang::CODE);
+        auto app_desc = esp_app_get_description();
+        ota_.SetHeader("User-Agent", std::string(BOARD_NAME "/") + app_desc->version);
+
+        xTaskCreate([](void* arg) {
+            Application* app = (Application*)arg;
+            app->CheckNewVersion();
+            vTaskDelete(NULL);
+        }, "check_new_version", 4096 * 2, this, 2, nullptr);
+    });
+    boot.AddPhase("protocol", {"network"}, [this]() {
+        InitializeProtocol();
+    });
+    boot.Run();
+
+    int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    int free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    ESP_LOGI(TAG, "Free internal: %u minimal internal: %u free_psram: %u", free_sram, min_free_sram, free_psram);
 
 #if CONFIG_USE_AUDIO_PROCESSOR
-    audio_processor_.Initialize(codec, realtime_chat_enabled_);
     audio_processor_.OnOutput([this](std::vector<int16_t>&& data) {
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
-                    protocol_->SendAudio(opus);
-                });
+#if CONFIG_USE_UPLINK_VAD_GATE
+        if (uplink_gate_enabled_) {
+            // 静音期间的数据不编码也不上传，跳过的时长通过时间戳告诉服务器。
+            // 门控按编码器的帧边界开关，和编码器一样只在 background_task_ 中使用
+            bool voice = audio_processor_.IsVoiceActive();
+            background_task_->Schedule([this, data = std::move(data), voice]() mutable {
+                bool was_closed = uplink_gate_.closed();
+                std::vector<std::vector<int16_t>> frames;
+                int skipped_ms = uplink_gate_.Process(std::move(data), voice, opus_encoder_->duration_ms() * 16,
+                    encoder_pending_samples_, frames);
+                for (auto& pcm : frames) {
+                    EncodeAudio(std::move(pcm));
+                }
+                if (!was_closed && uplink_gate_.closed()) {
+                    // 最后一帧已经编出，清掉编码状态，空缺之后从头开始
+                    opus_encoder_->ResetState();
+                }
+                if (skipped_ms > 0) {
+                    Schedule([this, skipped_ms]() {
+                        protocol_->SkipAudio(skipped_ms);
+                    });
+                }
             });
+            return;
+        }
+#endif
+        background_task_->Schedule([this, data = std::move(data)]() mutable {
+            EncodeAudio(std::move(data));
         });
     });
     audio_processor_.OnVadStateChange([this](bool speaking) {
@@ -674,7 +826,6 @@ void Application::Start() {
 #endif
 
 #if CONFIG_USE_WAKE_WORD_DETECT
-    wake_word_detect_.Initialize(codec);
     wake_word_detect_.OnWakeWordDetected([this](const std::string& wake_word) {
         Schedule([this, &wake_word]() {
             if (device_state_ == kDeviceStateIdle) {
@@ -702,18 +853,61 @@ void Application::Start() {
             }
         });
     });
+#if CONFIG_USE_COMMAND_WORD_DETECT
+    if (command_word_detect_.IsInitialized()) {
+        wake_word_detect_.OnAudioFetched([this](const int16_t* data, size_t samples) {
+            command_word_detect_.Feed(data, samples);
+        });
+        // 设备方法已经由 ThingManager 调度执行，这里只处理内置动作并同步状态
+        command_word_detect_.OnCommandDetected([this](const CommandWord& command) {
+            Schedule([this, command]() {
+                if (command.method == "abort") {
+                    if (device_state_ == kDeviceStateSpeaking) {
+                        AbortSpeaking(kAbortReasonNone);
+                    }
+                    return;
+                }
+                if (protocol_ && protocol_->IsAudioChannelOpened()) {
+                    UpdateIotStates();
+                }
+            });
+        });
+    }
+#endif
     wake_word_detect_.StartDetection();
 #endif
 
     SetDeviceState(kDeviceStateIdle);
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
-
-#if 0
-    while (true) {
-        SystemInfo::PrintRealTimeStats(pdMS_TO_TICKS(1000));
-        vTaskDelay(pdMS_TO_TICKS(10000));
+    BootProfiler::GetInstance().MarkReady();
+#if CONFIG_USE_SESSION_RECORD
+    // 回放从干净的待机状态开始，和录制时一样打开音频通道
+    if (replay_ != nullptr) {
+        ToggleChatState();
     }
 #endif
+
+#if CONFIG_USE_TASK_PROFILER
+    TaskProfiler::GetInstance().Start();
+#endif
+#if CONFIG_USE_DEBUG_CONSOLE
+    MemoryTracker::GetInstance().RegisterConsoleCommand();
+    BootProfiler::GetInstance().RegisterConsoleCommand();
+#if CONFIG_USE_TASK_PROFILER
+    TaskProfiler::GetInstance().RegisterConsoleCommand();
+#endif
+#if CONFIG_USE_ASSET_PARTITION
+    Assets::GetInstance().RegisterConsoleCommand();
+#endif
+#if CONFIG_USE_BENCHMARK
+    Benchmark::GetInstance().RegisterConsoleCommand();
+#endif
+#if CONFIG_USE_SESSION_RECORD
+    SessionRecorder::GetInstance().RegisterConsoleCommand();
+    ReplayProtocol::RegisterConsoleCommand();
+#endif
+    DebugConsole::GetInstance().Start();
+#endif
 }
 
 void Application::OnClockTimer() {
@@ -738,6 +932,94 @@ void Application::OnClockTimer() {
             }
         }
     }
+
+#if CONFIG_USE_UPLINK_ADAPTATION
+    if (clock_ticks_ % CONFIG_UPLINK_ADAPTATION_INTERVAL_SECONDS == 0 && device_state_ == kDeviceStateListening) {
+        Schedule([this]() {
+            AdaptUplink();
+        });
+    }
+#endif
+}
+
+#if CONFIG_USE_UPLINK_ADAPTATION
+// 在主循环中根据上一个统计窗口的链路和编码负载调整上行帧长和复杂度
+void Application::AdaptUplink() {
+    if (device_state_ != kDeviceStateListening || !protocol_ || !protocol_->IsAudioChannelOpened()) {
+        return;
+    }
+    auto stats = protocol_->TakeLinkStats();
+    uint32_t encoded_ms = encoded_ms_.exchange(0);
+    uint32_t encode_time_us = encode_time_us_.exchange(0);
+    if (encoded_ms == 0) {
+        // 静音被门控时没有编码数据，保持当前参数
+        return;
+    }
+    int encode_load = encode_time_us / 10 / encoded_ms;
+
+    UplinkAdapter::Decision decision;
+    if (!uplink_adapter_->Update(stats.loss_percent, stats.send_latency_ms, encode_load, decision)) {
+        return;
+    }
+    ESP_LOGI(TAG, "Uplink: loss %d%%, latency %d ms, encode load %d%% -> frame %d ms, complexity %d",
+        stats.loss_percent, stats.send_latency_ms, encode_load, decision.frame_duration, decision.complexity);
+
+    // 编码器只在 background_task_ 中使用，在同一个任务里替换
+    background_task_->Schedule([this, decision]() {
+        opus_encoder_->SetComplexity(decision.complexity);
+        next_frame_duration_ = opus_encoder_->duration_ms() != decision.frame_duration ? decision.frame_duration : 0;
+        next_complexity_ = decision.complexity;
+    });
+}
+
+// 在帧边界上换成新帧长的编码器，旧编码器中没有待编码的数据
+void Application::SwitchEncoder() {
+    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, next_frame_duration_);
+    opus_encoder_->SetComplexity(next_complexity_);
+#if CONFIG_USE_UPLINK_VAD_GATE
+    opus_encoder_->SetDtx(listening_mode_ != kListeningModeRealtime && !uplink_gate_enabled_);
+#endif
+    // 新帧长的第一个包发出之前先通知服务器
+    Schedule([this, frame_duration = next_frame_duration_]() {
+        protocol_->SetUplinkFrameDuration(frame_duration);
+    });
+    next_frame_duration_ = 0;
+}
+#endif
+
+void Application::EncodeAudio(std::vector<int16_t>&& pcm) {
+#if CONFIG_USE_UPLINK_ADAPTATION
+    // 帧长变化时先用旧编码器凑满当前帧，再换新编码器，切换时不丢失编码器中缓存的数据
+    if (next_frame_duration_ != 0) {
+        int frame_samples = opus_encoder_->duration_ms() * 16;
+        size_t missing = (frame_samples - encoder_pending_samples_) % frame_samples;
+        if (pcm.size() < missing) {
+            EncodeFrames(std::move(pcm));
+            return;
+        }
+        if (missing > 0) {
+            EncodeFrames(std::vector<int16_t>(pcm.begin(), pcm.begin() + missing));
+            pcm.erase(pcm.begin(), pcm.begin() + missing);
+        }
+        SwitchEncoder();
+        if (pcm.empty()) {
+            return;
+        }
+    }
+#endif
+    EncodeFrames(std::move(pcm));
+}
+
+void Application::EncodeFrames(std::vector<int16_t>&& pcm) {
+    encoded_ms_ += pcm.size() / 16;
+    encoder_pending_samples_ = (encoder_pending_samples_ + pcm.size()) % (opus_encoder_->duration_ms() * 16);
+    auto start_time = esp_timer_get_time();
+    opus_encoder_->Encode(std::move(pcm), [this](std::vector<uint8_t>&& opus) {
+        Schedule([this, opus = std::move(opus)]() {
+            protocol_->SendAudio(opus);
+        });
+    });
+    encode_time_us_ += esp_timer_get_time() - start_time;
 }
 
 // Add a async task to MainLoop
@@ -783,8 +1065,7 @@ void Application::OnAudioOutput() {
     auto codec = Board::GetInstance().GetAudioCodec();
     const int max_silence_seconds = 10;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (audio_decode_queue_.empty()) {
+    if (!audio_mixer_.HasPendingAudio()) {
         // Disable the output if there is no audio data for a long time
         if (device_state_ == kDeviceStateIdle) {
             auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_output_time_).count();
@@ -796,32 +1077,26 @@ void Application::OnAudioOutput() {
     }
 
     if (device_state_ == kDeviceStateListening) {
-        audio_decode_queue_.clear();
+        audio_mixer_.ResetAll();
         return;
     }
 
-    auto opus = std::move(audio_decode_queue_.front());
-    audio_decode_queue_.pop_front();
-    lock.unlock();
+    // 最多预先调度两帧，保证输出连续，又不会在后台任务里堆积
+    if (pending_mix_frames_ >= 2) {
+        return;
+    }
+    pending_mix_frames_++;
 
-    background_task_->Schedule([this, codec, opus = std::move(opus)]() mutable {
+    background_task_->Schedule([this, codec]() {
         if (aborted_) {
-            return;
+            audio_mixer_.Reset(kAudioStreamTts);
         }
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(opus), pcm)) {
-            return;
-        }
-        // Resample if the sample rate is different
-        if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+        if (audio_mixer_.Mix(output_buffer_)) {
+            WriteCodecOutput(codec, output_buffer_);
+            last_output_time_ = std::chrono::steady_clock::now();
         }
-        codec->OutputData(pcm);
-        last_output_time_ = std::chrono::steady_clock::now();
+        pending_mix_frames_--;
     });
 }
 
@@ -830,7 +1105,7 @@ void Application::OnAudioInput() {
 
 #if CONFIG_USE_WAKE_WORD_DETECT
     if (wake_word_detect_.IsDetectionRunning()) {
-        ReadAudio(data, 16000, wake_word_detect_.GetFeedSize());
+        ReadAudio(data, 16000, wake_word_detect_.GetReadSize());
         wake_word_detect_.Feed(data);
         return;
     }
@@ -845,11 +1120,7 @@ void Application::OnAudioInput() {
     if (device_state_ == kDeviceStateListening) {
         ReadAudio(data, 16000, 30 * 16000 / 1000);
         background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
-                    protocol_->SendAudio(opus);
-                });
-            });
+            EncodeAudio(std::move(data));
         });
         return;
     }
@@ -860,39 +1131,44 @@ void Application::OnAudioInput() {
 void Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int samples) {
     auto codec = Board::GetInstance().GetAudioCodec();
     if (codec->input_sample_rate() != sample_rate) {
-        data.resize(samples * codec->input_sample_rate() / sample_rate);
-        if (!codec->InputData(data)) {
+        input_buffer_.resize(samples * codec->input_sample_rate() / sample_rate);
+        if (!ReadCodecInput(codec, input_buffer_)) {
             return;
         }
-        if (codec->input_channels() == 2) {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
-        } else {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
-        }
+        data.resize(input_resampler_.GetOutputSamples(input_buffer_.size()));
+        input_resampler_.Process(input_buffer_.data(), input_buffer_.size(), data.data());
     } else {
         data.resize(samples);
-        if (!codec->InputData(data)) {
+        if (!ReadCodecInput(codec, data)) {
             return;
         }
     }
 }
 
+bool Application::ReadCodecInput(AudioCodec* codec, std::vector<int16_t>& data) {
+#if CONFIG_USE_SESSION_RECORD
+    if (replay_ != nullptr && replay_->ReadInput(data)) {
+        return true;
+    }
+#endif
+    if (!codec->InputData(data)) {
+        return false;
+    }
+#if CONFIG_USE_SESSION_RECORD
+    SessionRecorder::GetInstance().Record(kSessionRecordMicPcm, data.data(), data.size() * sizeof(int16_t));
+#endif
+    return true;
+}
+
+void Application::WriteCodecOutput(AudioCodec* codec, std::vector<int16_t>& data) {
+#if CONFIG_USE_SESSION_RECORD
+    if (replay_ != nullptr && replay_->WriteOutput(data)) {
+        return;
+    }
+#endif
+    codec->OutputData(data);
+}
+
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     aborted_ = true;
@@ -961,6 +1237,13 @@ void Application::SetDeviceState(DeviceState state) {
                     vTaskDelay(pdMS_TO_TICKS(120));
                 }
                 opus_encoder_->ResetState();
+                encoder_pending_samples_ = 0;
+#if CONFIG_USE_UPLINK_VAD_GATE
+                // 实时模式需要持续上行；传输层无法表示空缺时改用 Opus DTX
+                uplink_gate_.Reset();
+                uplink_gate_enabled_ = listening_mode_ != kListeningModeRealtime && protocol_->CanSkipAudio();
+                opus_encoder_->SetDtx(listening_mode_ != kListeningModeRealtime && !uplink_gate_enabled_);
+#endif
 #if CONFIG_USE_WAKE_WORD_DETECT
                 wake_word_detect_.StopDetection();
 #endif
@@ -990,9 +1273,7 @@ void Application::SetDeviceState(DeviceState state) {
 }
 
 void Application::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
+    audio_mixer_.Reset(kAudioStreamTts);
     last_output_time_ = std::chrono::steady_clock::now();
     
     auto codec = Board::GetInstance().GetAudioCodec();
@@ -1000,18 +1281,7 @@ void Application::ResetDecoder() {
 }
 
 void Application::SetDecodeSampleRate(int sample_rate, int frame_duration) {
-    if (opus_decoder_->sample_rate() == sample_rate && opus_decoder_->duration_ms() == frame_duration) {
-        return;
-    }
-
-    opus_decoder_.reset();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(sample_rate, 1, frame_duration);
-
-    auto codec = Board::GetInstance().GetAudioCodec();
-    if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
-        ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decoder_->sample_rate(), codec->output_sample_rate());
-        output_resampler_.Configure(opus_decoder_->sample_rate(), codec->output_sample_rate());
-    }
+    audio_mixer_.ConfigureStream(kAudioStreamTts, sample_rate, frame_duration);
 }
 
 void Application::UpdateIotStates() {
@@ -9,21 +9,36 @@
 #include <string>
 #include <mutex>
 #include <list>
+#include <atomic>
 
 #include <opus_encoder.h>
-#include <opus_decoder.h>
-#include <opus_resampler.h>
 
 #include "protocol.h"
 #include "ota.h"
 #include "background_task.h"
+#include "audio_resampler.h"
+#include "audio_mixer.h"
 
 #if CONFIG_USE_WAKE_WORD_DETECT
 #include "wake_word_detect.h"
 #endif
+#if CONFIG_USE_COMMAND_WORD_DETECT
+#include "command_word_detect.h"
+#endif
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "audio_processor.h"
 #endif
+#if CONFIG_USE_UPLINK_VAD_GATE
+#include "uplink_vad_gate.h"
+#endif
+#if CONFIG_USE_UPLINK_ADAPTATION
+#include "uplink_adapter.h"
+#endif
+#if CONFIG_USE_SESSION_RECORD
+#include "replay_protocol.h"
+#endif
+
+class AudioCodec;
 
 #define SCHEDULE_EVENT (1 << 0)
 #define AUDIO_INPUT_READY_EVENT (1 << 1)
@@ -42,8 +57,6 @@ enum DeviceState {
     kDeviceStateFatalError
 };
 
-#define OPUS_FRAME_DURATION_MS 60
-
 class Application {
 public:
     static Application& GetInstance() {
@@ -68,7 +81,7 @@ public:
     void UpdateIotStates();
     void Reboot();
     void WakeWordInvoke(const std::string& wake_word);
-    void PlaySound(const std::string_view& sound);
+    void PlaySound(const std::string_view& sound, AudioStreamId stream = kAudioStreamSystem);
     bool CanEnterSleepMode();
 
 private:
@@ -78,13 +91,24 @@ private:
 #if CONFIG_USE_WAKE_WORD_DETECT
     WakeWordDetect wake_word_detect_;
 #endif
+#if CONFIG_USE_COMMAND_WORD_DETECT
+    CommandWordDetect command_word_detect_;
+#endif
 #if CONFIG_USE_AUDIO_PROCESSOR
     AudioProcessor audio_processor_;
+#endif
+#if CONFIG_USE_UPLINK_VAD_GATE
+    UplinkVadGate uplink_gate_{CONFIG_UPLINK_VAD_HANGOVER_MS, CONFIG_UPLINK_VAD_PREROLL_MS};
+    bool uplink_gate_enabled_ = false;
 #endif
     Ota ota_;
     std::mutex mutex_;
     std::list<std::function<void()>> main_tasks_;
     std::unique_ptr<Protocol> protocol_;
+#if CONFIG_USE_SESSION_RECORD
+    // 回放录制的会话时 protocol_ 就是它，同时代替 codec 的输入输出
+    ReplayProtocol* replay_ = nullptr;
+#endif
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
     volatile DeviceState device_state_ = kDeviceStateUnknown;
@@ -104,20 +128,44 @@ private:
     TaskHandle_t audio_loop_task_handle_ = nullptr;
     BackgroundTask* background_task_ = nullptr;
     std::chrono::steady_clock::time_point last_output_time_;
-    std::list<std::vector<uint8_t>> audio_decode_queue_;
+    AudioMixer audio_mixer_;
+    // 已调度但还没输出的混音帧数
+    std::atomic<int> pending_mix_frames_ = 0;
+    // 混音输出缓冲区，只在 background_task_ 中使用，每帧复用
+    std::vector<int16_t> output_buffer_;
 
     std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
-    std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
+    // 编码器中还没凑满一帧的采样数，只在 background_task_ 中使用
+    int encoder_pending_samples_ = 0;
+    // 编码耗时和编码的音频时长，用于计算编码 CPU 占用
+    std::atomic<uint32_t> encode_time_us_ = 0;
+    std::atomic<uint32_t> encoded_ms_ = 0;
+#if CONFIG_USE_UPLINK_ADAPTATION
+    std::unique_ptr<UplinkAdapter> uplink_adapter_;
+    // 等待在帧边界上切换的编码器帧长（0 表示不切换）和复杂度，只在 background_task_ 中使用
+    int next_frame_duration_ = 0;
+    int next_complexity_ = 0;
+#endif
 
-    OpusResampler input_resampler_;
-    OpusResampler reference_resampler_;
-    OpusResampler output_resampler_;
+    // 输入为交错的麦克风和参考声道，按 codec 的声道数整体重采样
+    AudioResampler input_resampler_;
+    std::vector<int16_t> input_buffer_;
 
     void MainLoop();
+    void InitializeProtocol();
     void OnAudioInput();
     void OnAudioOutput();
     void ReadAudio(std::vector<int16_t>& data, int sample_rate, int samples);
+    bool ReadCodecInput(AudioCodec* codec, std::vector<int16_t>& data);
+    void WriteCodecOutput(AudioCodec* codec, std::vector<int16_t>& data);
     void ResetDecoder();
+    // 在 background_task_ 中调用
+    void EncodeAudio(std::vector<int16_t>&& pcm);
+    void EncodeFrames(std::vector<int16_t>&& pcm);
+#if CONFIG_USE_UPLINK_ADAPTATION
+    void AdaptUplink();
+    void SwitchEncoder();
+#endif
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
     void CheckNewVersion();
     void ShowActivationCode();
@@ -0,0 +1,145 @@
+#include "assets.h"
+#include "debug_console.h"
+#include "assets/lang_config.h"
+
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "Assets"
+
+#define ASSETS_PARTITION_LABEL "assets"
+#define ASSETS_MAGIC 0x54534158  // "XAST"
+#define ASSETS_VERSION 1
+#define ASSETS_NAME_SIZE 40
+
+// 布局（小端）：Header | Entry[entry_count]，按名字升序 | 16 字节对齐的数据块
+struct AssetsHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_count;
+    uint32_t total_size;
+    uint32_t index_crc32;
+    char language[16];
+};
+static_assert(sizeof(AssetsHeader) == 32, "AssetsHeader layout must match pack_assets.py");
+
+struct Assets::Entry {
+    char name[ASSETS_NAME_SIZE];
+    uint32_t offset;
+    uint32_t size;
+};
+
+bool Assets::Initialize() {
+    static_assert(sizeof(Entry) == 48, "Entry layout must match pack_assets.py");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (initialized_) {
+        return data_ != nullptr;
+    }
+    initialized_ = true;
+
+    auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSETS_PARTITION_LABEL);
+    if (partition == nullptr) {
+        ESP_LOGE(TAG, "Partition '%s' not found", ASSETS_PARTITION_LABEL);
+        return false;
+    }
+
+    AssetsHeader header;
+    esp_err_t err = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read header: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (header.magic != ASSETS_MAGIC || header.version != ASSETS_VERSION) {
+        ESP_LOGE(TAG, "Invalid assets bundle (magic 0x%08lx, version %u), run scripts/pack_assets.py and flash it",
+            (unsigned long)header.magic, header.version);
+        return false;
+    }
+    size_t index_end = sizeof(AssetsHeader) + header.entry_count * sizeof(Entry);
+    if (header.total_size > partition->size || index_end > header.total_size) {
+        ESP_LOGE(TAG, "Assets bundle size %lu does not fit partition size %lu",
+            (unsigned long)header.total_size, (unsigned long)partition->size);
+        return false;
+    }
+
+    // 只映射资源包实际占用的部分，MMU 按 64KB 页映射
+    const void* ptr = nullptr;
+    err = esp_partition_mmap(partition, 0, header.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &mmap_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mmap assets partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    auto data = (const uint8_t*)ptr;
+    auto entries = (const Entry*)(data + sizeof(AssetsHeader));
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)entries, header.entry_count * sizeof(Entry));
+    if (crc != header.index_crc32) {
+        ESP_LOGE(TAG, "Assets index checksum mismatch");
+        esp_partition_munmap(mmap_handle_);
+        return false;
+    }
+    for (size_t i = 0; i < header.entry_count; i++) {
+        // 先比较 offset，避免 total_size - offset 下溢后越界的条目通过检查
+        if (entries[i].offset < index_end || entries[i].offset > header.total_size ||
+            entries[i].size > header.total_size - entries[i].offset) {
+            ESP_LOGE(TAG, "Asset %.*s out of range", ASSETS_NAME_SIZE, entries[i].name);
+            esp_partition_munmap(mmap_handle_);
+            return false;
+        }
+    }
+
+    char language[sizeof(header.language) + 1] = {};
+    memcpy(language, header.language, sizeof(header.language));
+    if (strcmp(language, Lang::CODE) != 0) {
+        ESP_LOGW(TAG, "Assets bundle language %s does not match firmware language %s", language, Lang::CODE);
+    }
+
+    data_ = data;
+    entries_ = entries;
+    entry_count_ = header.entry_count;
+    ESP_LOGI(TAG, "Mapped %u assets (%lu bytes, %s)", (unsigned)entry_count_, (unsigned long)header.total_size, language);
+    return true;
+}
+
+std::string_view Assets::Get(std::string_view name) {
+    if (!Initialize()) {
+        return {};
+    }
+
+    // 名字不足 ASSETS_NAME_SIZE 时以 0 结尾，索引按字节序升序排列
+    auto compare = [](const Entry& entry, std::string_view name) {
+        size_t length = strnlen(entry.name, ASSETS_NAME_SIZE);
+        return std::string_view(entry.name, length) < name;
+    };
+    auto end = entries_ + entry_count_;
+    auto it = std::lower_bound(entries_, end, name, compare);
+    if (it == end || std::string_view(it->name, strnlen(it->name, ASSETS_NAME_SIZE)) != name) {
+        ESP_LOGW(TAG, "Asset %.*s not found", (int)name.size(), name.data());
+        return {};
+    }
+    return std::string_view((const char*)data_ + it->offset, it->size);
+}
+
+void Assets::PrintIndex() {
+    if (!Initialize()) {
+        printf("Assets partition not available\n");
+        return;
+    }
+    printf("| Offset   | Size     | Name\n");
+    for (size_t i = 0; i < entry_count_; i++) {
+        auto& entry = entries_[i];
+        printf("| %08lx | %8lu | %.*s\n", (unsigned long)entry.offset, (unsigned long)entry.size,
+            ASSETS_NAME_SIZE, entry.name);
+    }
+}
+
+void Assets::RegisterConsoleCommand() {
+    DebugConsole::GetInstance().RegisterCommand("assets", "List the assets in the assets partition",
+        [this](int argc, char** argv) {
+            PrintIndex();
+            return 0;
+        });
+}
@@ -0,0 +1,50 @@
+#ifndef _ASSETS_H_
+#define _ASSETS_H_
+
+#include <esp_partition.h>
+
+#include <mutex>
+#include <string_view>
+
+// assets 分区中的资源包，由 scripts/pack_assets.py 生成，整体映射到地址空间后按名字二分查找
+// 返回的数据直接指向 flash 映射，不复制，在整个运行期间有效
+class Assets {
+public:
+    static Assets& GetInstance() {
+        static Assets instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    Assets(const Assets&) = delete;
+    Assets& operator=(const Assets&) = delete;
+
+    bool Initialize();
+    // 找不到时返回空
+    std::string_view Get(std::string_view name);
+    void PrintIndex();
+    void RegisterConsoleCommand();
+
+private:
+    Assets() = default;
+
+    struct Entry;
+
+    std::mutex mutex_;
+    bool initialized_ = false;
+    const uint8_t* data_ = nullptr;
+    const Entry* entries_ = nullptr;
+    size_t entry_count_ = 0;
+    esp_partition_mmap_handle_t mmap_handle_ = 0;
+};
+
+// gen_lang.py 在启用 USE_ASSET_PARTITION 时生成的音效引用，用到时才去 assets 分区查找
+class AssetRef {
+public:
+    constexpr AssetRef(const char* name) : name_(name) {}
+    operator std::string_view() const { return Assets::GetInstance().Get(name_); }
+
+private:
+    const char* name_;
+};
+
+#endif // _ASSETS_H_
@@ -0,0 +1,58 @@
+#include "aec_reference.h"
+
+#include <algorithm>
+#include <cstring>
+
+AecReference::AecReference(int sample_rate, int duration_ms)
+    : ring_(sample_rate * duration_ms / 1000, 0), sample_rate_(sample_rate) {
+}
+
+void AecReference::Append(const int16_t* data, int samples) {
+    int capacity = ring_.size();
+    // 超过容量的部分只保留最后 capacity 个样本
+    if (samples > capacity) {
+        if (data != nullptr) {
+            data += samples - capacity;
+        }
+        write_index_ += samples - capacity;
+        samples = capacity;
+    }
+
+    int position = write_index_ % capacity;
+    while (samples > 0) {
+        int count = std::min(samples, capacity - position);
+        if (data != nullptr) {
+            memcpy(&ring_[position], data, count * sizeof(int16_t));
+            data += count;
+        } else {
+            memset(&ring_[position], 0, count * sizeof(int16_t));
+        }
+        write_index_ += count;
+        samples -= count;
+        position = 0;
+    }
+}
+
+void AecReference::Write(const int16_t* data, int samples, int64_t play_time_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t gap = (play_time_us - end_time_us_) * sample_rate_ / 1000000;
+    if (gap > 0) {
+        Append(nullptr, std::min<int64_t>(gap, ring_.size()));
+    }
+    // 时间重叠时说明之前的估计偏晚，以这次的时间为准重新对齐
+    Append(data, samples);
+    end_time_us_ = play_time_us + (int64_t)samples * 1000000 / sample_rate_;
+}
+
+void AecReference::Read(int16_t* dest, int samples, int64_t start_time_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t capacity = ring_.size();
+    int64_t index = write_index_ - (end_time_us_ - start_time_us) * sample_rate_ / 1000000;
+    for (int i = 0; i < samples; i++, index++) {
+        if (index < write_index_ - capacity || index >= write_index_ || index < 0) {
+            dest[i] = 0;
+        } else {
+            dest[i] = ring_[index % capacity];
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef _AEC_REFERENCE_H_
+#define _AEC_REFERENCE_H_
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+// 软件回采：记录扬声器实际播出的 PCM 及其播放时间，采集时按麦克风数据的时间取出对齐的参考信号
+// 写入和读取的采样率相同，时间单位为 esp_timer 的微秒
+class AecReference {
+public:
+    AecReference(int sample_rate, int duration_ms);
+
+    // data 的第一个样本在 play_time_us 从扬声器播出，和上次写入之间的空隙补静音
+    void Write(const int16_t* data, int samples, int64_t play_time_us);
+    // 取出从 start_time_us 开始的 samples 个参考样本，没有播放数据的时段为 0
+    void Read(int16_t* dest, int samples, int64_t start_time_us);
+
+private:
+    std::mutex mutex_;
+    std::vector<int16_t> ring_;
+    int sample_rate_;
+    // 已写入的样本总数，以及下一个样本的播放时间
+    int64_t write_index_ = 0;
+    int64_t end_time_us_ = 0;
+
+    void Append(const int16_t* data, int samples);
+};
+
+#endif // _AEC_REFERENCE_H_
@@ -3,11 +3,15 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <cstring>
+#include <algorithm>
 #include <driver/i2s_common.h>
 
 #define TAG "AudioCodec"
 
+static constexpr SettingKey<int32_t> kOutputVolumeSetting("audio", "output_volume");
+
 AudioCodec::AudioCodec() {
 }
 
@@ -15,10 +19,53 @@ AudioCodec::~AudioCodec() {
 }
 
 void AudioCodec::OutputData(std::vector<int16_t>& data) {
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+    if (software_reference_ && output_enabled_) {
+        int64_t start_time = esp_timer_get_time();
+        Write(data.data(), data.size());
+        int64_t now = esp_timer_get_time();
+
+        // Write 返回时数据已进入 DMA 队列。队列未满时紧接上一段播放，队列满时最后一个样本在整个队列播完后输出
+        int64_t duration = (int64_t)data.size() * 1000000 / output_sample_rate_;
+        int64_t queue_latency = (int64_t)AUDIO_CODEC_DMA_FRAMES * 1000000 / output_sample_rate_;
+        int64_t end_time = std::min(std::max(last_play_end_time_, start_time) + duration, now + queue_latency);
+        last_play_end_time_ = end_time;
+
+        const int16_t* reference = data.data();
+        int samples = data.size();
+        if (output_sample_rate_ != input_sample_rate_) {
+            output_reference_buffer_.resize(reference_resampler_.GetOutputSamples(samples));
+            samples = reference_resampler_.Process(data.data(), samples, output_reference_buffer_.data());
+            reference = output_reference_buffer_.data();
+        }
+        software_reference_->Write(reference, samples,
+            end_time - duration + CONFIG_SOFTWARE_AEC_REFERENCE_DELAY_MS * 1000);
+        return;
+    }
+#endif
     Write(data.data(), data.size());
 }
 
 bool AudioCodec::InputData(std::vector<int16_t>& data) {
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+    if (software_reference_) {
+        // 先读单声道麦克风数据，再按读取完成的时间取出对齐的参考信号，交错成麦克风、参考双声道
+        int frames = data.size() / 2;
+        mic_buffer_.resize(frames);
+        int samples = Read(mic_buffer_.data(), frames);
+        if (samples <= 0) {
+            return false;
+        }
+        int64_t start_time = esp_timer_get_time() - (int64_t)samples * 1000000 / input_sample_rate_;
+        input_reference_buffer_.resize(samples);
+        software_reference_->Read(input_reference_buffer_.data(), samples, start_time);
+        for (int i = 0; i < samples; i++) {
+            data[i * 2] = mic_buffer_[i];
+            data[i * 2 + 1] = input_reference_buffer_[i];
+        }
+        return true;
+    }
+#endif
     int samples = Read(data.data(), data.size());
     if (samples > 0) {
         return true;
@@ -26,9 +73,24 @@ bool AudioCodec::InputData(std::vector<int16_t>& data) {
     return false;
 }
 
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+void AudioCodec::EnableSoftwareReference() {
+    if (input_reference_ || input_channels_ != 1) {
+        return;
+    }
+    // 参考信号按输入采样率保存，保留的时长要覆盖 DMA 队列和读写之间的抖动
+    software_reference_ = std::make_unique<AecReference>(input_sample_rate_, 500);
+    if (output_sample_rate_ != input_sample_rate_) {
+        reference_resampler_.Configure(output_sample_rate_, input_sample_rate_);
+    }
+    input_reference_ = true;
+    input_channels_ = 2;
+    ESP_LOGI(TAG, "Software AEC reference enabled, extra delay %d ms", CONFIG_SOFTWARE_AEC_REFERENCE_DELAY_MS);
+}
+#endif
+
 void AudioCodec::Start() {
-    Settings settings("audio", false);
-    output_volume_ = settings.GetInt("output_volume", output_volume_);
+    output_volume_ = kOutputVolumeSetting.Get(output_volume_);
     if (output_volume_ <= 0) {
         ESP_LOGW(TAG, "Output volume value (%d) is too small, setting to default (10)", output_volume_);
         output_volume_ = 10;
@@ -45,9 +107,7 @@ void AudioCodec::Start() {
 void AudioCodec::SetOutputVolume(int volume) {
     output_volume_ = volume;
     ESP_LOGI(TAG, "Set output volume to %d", output_volume_);
-    
-    Settings settings("audio", true);
-    settings.SetInt("output_volume", output_volume_);
+    kOutputVolumeSetting.Set(output_volume_);
 }
 
 void AudioCodec::EnableInput(bool enable) {
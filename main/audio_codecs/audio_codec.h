@@ -7,10 +7,19 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <functional>
 
 #include "board.h"
 
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+#include "aec_reference.h"
+#include "audio_resampler.h"
+#endif
+
+// 各 codec 的 I2S 通道都配置为 6 个 DMA 描述符，每个 240 帧
+#define AUDIO_CODEC_DMA_FRAMES (6 * 240)
+
 class AudioCodec {
 public:
     AudioCodec();
@@ -21,6 +30,11 @@ public:
     virtual void EnableOutput(bool enable);
 
     void Start();
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+    // 没有硬件回采的 codec 用播放数据作为参考声道，输入变为交错的麦克风和参考双声道
+    // 必须在读取 input_channels() 和 Start 之前调用
+    void EnableSoftwareReference();
+#endif
     void OutputData(std::vector<int16_t>& data);
     bool InputData(std::vector<int16_t>& data);
 
@@ -50,6 +64,17 @@ protected:
 
     virtual int Read(int16_t* dest, int samples) = 0;
     virtual int Write(const int16_t* data, int samples) = 0;
+
+private:
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+    std::unique_ptr<AecReference> software_reference_;
+    AudioResampler reference_resampler_;
+    // OutputData 和 InputData 在不同任务中调用，各自使用自己的缓冲区
+    std::vector<int16_t> output_reference_buffer_;
+    std::vector<int16_t> input_reference_buffer_;
+    std::vector<int16_t> mic_buffer_;
+    int64_t last_play_end_time_ = 0;
+#endif
 };
 
 #endif // _AUDIO_CODEC_H
@@ -0,0 +1,195 @@
+#include "audio_mixer.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <iterator>
+
+#define TAG "AudioMixer"
+
+// 增益为 Q15，32768 表示原始音量
+#define AUDIO_MIXER_UNITY_GAIN 32768
+
+AudioMixer::AudioMixer() {
+    // 系统提示音和通知音都会压低 TTS
+    streams_[kAudioStreamSystem].ducks_tts = true;
+    streams_[kAudioStreamNotification].ducks_tts = true;
+}
+
+AudioMixer::~AudioMixer() {
+}
+
+void AudioMixer::Initialize(int output_sample_rate) {
+    std::lock_guard<std::mutex> lock(decoder_mutex_);
+    output_sample_rate_ = output_sample_rate;
+    frame_samples_ = output_sample_rate * AUDIO_MIXER_FRAME_DURATION_MS / 1000;
+    accumulator_.resize(frame_samples_);
+}
+
+void AudioMixer::ConfigureStream(AudioStreamId id, int sample_rate, int frame_duration) {
+    std::lock_guard<std::mutex> lock(decoder_mutex_);
+    auto& stream = streams_[id];
+    if (stream.decoder && stream.decoder->sample_rate() == sample_rate && stream.decoder->duration_ms() == frame_duration) {
+        return;
+    }
+
+    stream.decoder.reset();
+    stream.decoder = std::make_unique<OpusDecoderWrapper>(sample_rate, 1, frame_duration);
+    stream.pending.clear();
+    if (sample_rate != output_sample_rate_) {
+        ESP_LOGI(TAG, "Stream %d: resampling audio from %d to %d", id, sample_rate, output_sample_rate_);
+        stream.resampler.Configure(sample_rate, output_sample_rate_);
+    }
+}
+
+void AudioMixer::SetGain(AudioStreamId id, int percent) {
+    std::lock_guard<std::mutex> lock(decoder_mutex_);
+    streams_[id].gain = std::clamp(percent, 0, 100) * AUDIO_MIXER_UNITY_GAIN / 100;
+}
+
+void AudioMixer::Push(AudioStreamId id, AudioPacket&& packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_[id].queue.emplace_back(std::move(packet));
+}
+
+void AudioMixer::Push(AudioStreamId id, std::vector<AudioPacket>&& packets) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& queue = streams_[id].queue;
+    queue.insert(queue.end(), std::make_move_iterator(packets.begin()), std::make_move_iterator(packets.end()));
+}
+
+void AudioMixer::Reset(AudioStreamId id) {
+    std::lock_guard<std::mutex> decoder_lock(decoder_mutex_);
+    auto& stream = streams_[id];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream.queue.clear();
+        stream.has_pending = false;
+    }
+    stream.pending.clear();
+    if (stream.decoder) {
+        stream.decoder->ResetState();
+    }
+    stream.resampler.Reset();
+}
+
+void AudioMixer::ResetAll() {
+    for (int id = 0; id < kAudioStreamCount; id++) {
+        Reset((AudioStreamId)id);
+    }
+}
+
+bool AudioMixer::HasPendingAudio(AudioStreamId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !streams_[id].queue.empty() || streams_[id].has_pending;
+}
+
+bool AudioMixer::HasPendingAudio() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stream : streams_) {
+        if (!stream.queue.empty() || stream.has_pending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 解码到至少一帧的数据或队列为空
+void AudioMixer::Fill(Stream& stream) {
+    while ((int)stream.pending.size() < frame_samples_) {
+        AudioPacket packet;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stream.queue.empty()) {
+                return;
+            }
+            packet = std::move(stream.queue.front());
+            stream.queue.pop_front();
+        }
+
+        bool decoded;
+        if (packet.asset != nullptr) {
+            // OpusDecoderWrapper 只接受 vector，资源包复用同一个缓冲区，不再逐包分配
+            asset_packet_buffer_.assign(packet.asset, packet.asset + packet.asset_size);
+            decoded = stream.decoder->Decode(std::move(asset_packet_buffer_), decoded_);
+        } else {
+            decoded = stream.decoder->Decode(std::move(packet.data), decoded_);
+        }
+        if (!decoded) {
+            continue;
+        }
+
+        size_t offset = stream.pending.size();
+        if (stream.decoder->sample_rate() != output_sample_rate_) {
+            stream.pending.resize(offset + stream.resampler.GetOutputSamples(decoded_.size()));
+            int samples = stream.resampler.Process(decoded_.data(), decoded_.size(), stream.pending.data() + offset);
+            stream.pending.resize(offset + samples);
+        } else if (offset == 0) {
+            // 不需要重采样时通常一包正好一帧，直接交换缓冲区，不复制
+            std::swap(stream.pending, decoded_);
+        } else {
+            stream.pending.insert(stream.pending.end(), decoded_.begin(), decoded_.end());
+        }
+    }
+}
+
+bool AudioMixer::Mix(std::vector<int16_t>& output) {
+    std::lock_guard<std::mutex> lock(decoder_mutex_);
+
+    // 输出长度取各路已解码数据的最大值，只有一路在播放时不会插入静音
+    int length = 0;
+    bool ducking = false;
+    for (auto& stream : streams_) {
+        if (!stream.decoder) {
+            continue;
+        }
+        Fill(stream);
+        int available = std::min<int>(stream.pending.size(), frame_samples_);
+        length = std::max(length, available);
+        if (stream.ducks_tts && available > 0) {
+            ducking = true;
+        }
+    }
+    if (length == 0) {
+        return false;
+    }
+
+    std::fill(accumulator_.begin(), accumulator_.begin() + length, 0);
+    for (int id = 0; id < kAudioStreamCount; id++) {
+        auto& stream = streams_[id];
+        int target_gain = stream.gain;
+        if (id == kAudioStreamTts && ducking) {
+            target_gain = target_gain * AUDIO_MIXER_DUCKING_PERCENT / 100;
+        }
+
+        int samples = std::min<int>(stream.pending.size(), length);
+        if (samples == 0) {
+            // 没有数据的流直接跳到目标增益，下次出声时不需要渐变
+            stream.current_gain = target_gain;
+            continue;
+        }
+
+        // 增益在一帧内线性渐变到目标值，避免压低和恢复时出现爆音
+        int64_t gain = (int64_t)stream.current_gain << 16;
+        int64_t step = (((int64_t)target_gain << 16) - gain) / samples;
+        for (int i = 0; i < samples; i++) {
+            gain += step;
+            accumulator_[i] += (int32_t)(((gain >> 16) * stream.pending[i]) >> 15);
+        }
+        stream.current_gain = target_gain;
+        stream.pending.erase(stream.pending.begin(), stream.pending.begin() + samples);
+    }
+
+    {
+        std::lock_guard<std::mutex> queue_lock(mutex_);
+        for (auto& stream : streams_) {
+            stream.has_pending = !stream.pending.empty();
+        }
+    }
+
+    output.resize(length);
+    for (int i = 0; i < length; i++) {
+        output[i] = std::clamp<int32_t>(accumulator_[i], INT16_MIN, INT16_MAX);
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef _AUDIO_MIXER_H_
+#define _AUDIO_MIXER_H_
+
+#include <opus_decoder.h>
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "audio_resampler.h"
+
+// 每次混音输出的时长
+#define AUDIO_MIXER_FRAME_DURATION_MS 60
+// 提示音播放期间 TTS 的音量（百分比）
+#define AUDIO_MIXER_DUCKING_PERCENT 30
+
+// 待解码的 Opus 包：网络数据由 data 持有，内置提示音直接引用 flash 中资源的字节，不复制
+struct AudioPacket {
+    std::vector<uint8_t> data;
+    const uint8_t* asset = nullptr;
+    size_t asset_size = 0;
+};
+
+// TTS 为服务器下发的语音；System 为对用户操作的即时反馈（成功提示等）；
+// Notification 为设备主动发出的告警和通知（Alert、低电量、激活码），和 System 互不打断
+enum AudioStreamId {
+    kAudioStreamTts,
+    kAudioStreamSystem,
+    kAudioStreamNotification,
+    kAudioStreamCount
+};
+
+// 多路音频混音：每路有自己的 Opus 解码器、采样率和增益，解码后重采样到输出采样率再叠加
+// 系统提示音和通知音播放时，TTS 平滑压低到 AUDIO_MIXER_DUCKING_PERCENT
+class AudioMixer {
+public:
+    AudioMixer();
+    ~AudioMixer();
+
+    void Initialize(int output_sample_rate);
+    // 采样率和帧长不变时保留现有解码器，只有真正变化时才重建
+    void ConfigureStream(AudioStreamId id, int sample_rate, int frame_duration);
+    void SetGain(AudioStreamId id, int percent);
+    // 入队前必须先 ConfigureStream 过这一路
+    void Push(AudioStreamId id, AudioPacket&& packet);
+    void Push(AudioStreamId id, std::vector<AudioPacket>&& packets);
+    // 丢弃该路未播放的数据并重置解码器和重采样器状态
+    void Reset(AudioStreamId id);
+    void ResetAll();
+    bool HasPendingAudio(AudioStreamId id) const;
+    bool HasPendingAudio() const;
+
+    // 最多输出一帧混音结果，没有任何数据时返回 false
+    bool Mix(std::vector<int16_t>& output);
+
+private:
+    struct Stream {
+        std::deque<AudioPacket> queue;
+        std::unique_ptr<OpusDecoderWrapper> decoder;
+        AudioResampler resampler;
+        std::vector<int16_t> pending;
+        // pending 是否非空，由 mutex_ 保护，供 HasPendingAudio 查询
+        bool has_pending = false;
+        int gain = 32768;
+        int current_gain = 32768;
+        bool ducks_tts = false;
+    };
+
+    // mutex_ 保护各路队列，decoder_mutex_ 保护解码器和已解码的数据，解码时不阻塞网络任务入队
+    mutable std::mutex mutex_;
+    std::mutex decoder_mutex_;
+    Stream streams_[kAudioStreamCount];
+    int output_sample_rate_ = 0;
+    int frame_samples_ = 0;
+    std::vector<uint8_t> asset_packet_buffer_;
+    std::vector<int16_t> decoded_;
+    std::vector<int32_t> accumulator_;
+
+    void Fill(Stream& stream);
+};
+
+#endif // _AUDIO_MIXER_H_
@@ -22,6 +22,8 @@ public:
     void Start();
     void Stop();
     bool IsRunning();
+    // 最近一次输出数据时的 VAD 状态，在输出回调中调用时对应当前这一块数据
+    bool IsVoiceActive() const { return is_speaking_; }
     void OnOutput(std::function<void(std::vector<int16_t>&& data)> callback);
     void OnVadStateChange(std::function<void(bool speaking)> callback);
     size_t GetFeedSize();
@@ -0,0 +1,132 @@
+#include "audio_resampler.h"
+#include "polyphase_resampler.h"
+
+#include <esp_log.h>
+
+#define TAG "AudioResampler"
+
+namespace {
+
+template <int InputRate, int OutputRate, int Channels, int Taps>
+class PolyphaseImpl : public AudioResampler::Impl {
+public:
+    int GetOutputSamples(int input_samples) const override {
+        return resampler_.GetOutputSamples(input_samples);
+    }
+
+    int Process(const int16_t* input, int input_samples, int16_t* output) override {
+        return resampler_.Process(input, input_samples, output);
+    }
+
+    void Reset() override {
+        resampler_.Reset();
+    }
+
+private:
+    PolyphaseResampler<InputRate, OutputRate, Channels, Taps> resampler_;
+};
+
+// 多声道时逐声道拆分后处理，拆分用的缓冲区跨帧复用
+class OpusImpl : public AudioResampler::Impl {
+public:
+    OpusImpl(int input_sample_rate, int output_sample_rate, int channels)
+        : input_sample_rate_(input_sample_rate), output_sample_rate_(output_sample_rate), resamplers_(channels) {
+        Reset();
+    }
+
+    int GetOutputSamples(int input_samples) const override {
+        int channels = resamplers_.size();
+        return resamplers_[0].GetOutputSamples(input_samples / channels) * channels;
+    }
+
+    int Process(const int16_t* input, int input_samples, int16_t* output) override {
+        int channels = resamplers_.size();
+        if (channels == 1) {
+            resamplers_[0].Process(input, input_samples, output);
+            return resamplers_[0].GetOutputSamples(input_samples);
+        }
+
+        int frames = input_samples / channels;
+        int output_frames = resamplers_[0].GetOutputSamples(frames);
+        channel_input_.resize(frames);
+        channel_output_.resize(output_frames);
+        for (int channel = 0; channel < channels; channel++) {
+            for (int i = 0; i < frames; i++) {
+                channel_input_[i] = input[i * channels + channel];
+            }
+            resamplers_[channel].Process(channel_input_.data(), frames, channel_output_.data());
+            for (int i = 0; i < output_frames; i++) {
+                output[i * channels + channel] = channel_output_[i];
+            }
+        }
+        return output_frames * channels;
+    }
+
+    // OpusResampler 没有单独的复位接口，重新配置即清空状态
+    void Reset() override {
+        for (auto& resampler : resamplers_) {
+            resampler.Configure(input_sample_rate_, output_sample_rate_);
+        }
+    }
+
+private:
+    int input_sample_rate_;
+    int output_sample_rate_;
+    std::vector<OpusResampler> resamplers_;
+    std::vector<int16_t> channel_input_;
+    std::vector<int16_t> channel_output_;
+};
+
+// 每个相位的抽头数：上采样和 24k->16k 用 32，大比例降采样用 64 以压住混叠
+template <int Channels>
+std::unique_ptr<AudioResampler::Impl> CreatePolyphase(int input_sample_rate, int output_sample_rate) {
+    if (input_sample_rate == 16000 && output_sample_rate == 24000) {
+        return std::make_unique<PolyphaseImpl<16000, 24000, Channels, 32>>();
+    } else if (input_sample_rate == 24000 && output_sample_rate == 16000) {
+        return std::make_unique<PolyphaseImpl<24000, 16000, Channels, 32>>();
+    } else if (input_sample_rate == 48000 && output_sample_rate == 16000) {
+        return std::make_unique<PolyphaseImpl<48000, 16000, Channels, 64>>();
+    } else if (input_sample_rate == 44100 && output_sample_rate == 16000) {
+        return std::make_unique<PolyphaseImpl<44100, 16000, Channels, 64>>();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+AudioResampler::AudioResampler() = default;
+
+AudioResampler::~AudioResampler() = default;
+
+void AudioResampler::Configure(int input_sample_rate, int output_sample_rate, int channels) {
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+
+    impl_.reset();
+    if (channels == 1) {
+        impl_ = CreatePolyphase<1>(input_sample_rate, output_sample_rate);
+    } else if (channels == 2) {
+        impl_ = CreatePolyphase<2>(input_sample_rate, output_sample_rate);
+    }
+    if (impl_) {
+        ESP_LOGI(TAG, "Polyphase resampler %d -> %d, %d channel(s)", input_sample_rate, output_sample_rate, channels);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Opus resampler %d -> %d, %d channel(s)", input_sample_rate, output_sample_rate, channels);
+    impl_ = std::make_unique<OpusImpl>(input_sample_rate, output_sample_rate, channels);
+}
+
+int AudioResampler::GetOutputSamples(int input_samples) const {
+    return impl_ ? impl_->GetOutputSamples(input_samples) : 0;
+}
+
+int AudioResampler::Process(const int16_t* input, int input_samples, int16_t* output) {
+    return impl_ ? impl_->Process(input, input_samples, output) : 0;
+}
+
+void AudioResampler::Reset() {
+    if (impl_) {
+        impl_->Reset();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef _AUDIO_RESAMPLER_H_
+#define _AUDIO_RESAMPLER_H_
+
+#include <opus_resampler.h>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// 运行时按采样率选择重采样器：常用组合（16k<->24k、48k->16k、44.1k->16k）使用编译期生成的多相滤波器，
+// 其余组合逐声道回退到 OpusResampler。输入输出都是交错的 channels 声道数据
+class AudioResampler {
+public:
+    AudioResampler();
+    ~AudioResampler();
+
+    void Configure(int input_sample_rate, int output_sample_rate, int channels = 1);
+    int GetOutputSamples(int input_samples) const;
+    // 返回写入 output 的样本数（所有声道合计）
+    int Process(const int16_t* input, int input_samples, int16_t* output);
+    // 清除跨帧保留的滤波器状态，下一段音频不受上一段影响
+    void Reset();
+
+    int input_sample_rate() const { return input_sample_rate_; }
+    int output_sample_rate() const { return output_sample_rate_; }
+
+    class Impl {
+    public:
+        virtual ~Impl() = default;
+        virtual int GetOutputSamples(int input_samples) const = 0;
+        virtual int Process(const int16_t* input, int input_samples, int16_t* output) = 0;
+        virtual void Reset() = 0;
+    };
+
+private:
+    std::unique_ptr<Impl> impl_;
+    int input_sample_rate_ = 0;
+    int output_sample_rate_ = 0;
+};
+
+#endif // _AUDIO_RESAMPLER_H_
@@ -0,0 +1,170 @@
+#include "command_word_detect.h"
+#include "iot/thing_manager.h"
+
+#include <esp_log.h>
+#include <esp_mn_models.h>
+#include <esp_mn_speech_commands.h>
+#include <model_path.h>
+#include <cJSON.h>
+
+#include <sstream>
+#include <algorithm>
+
+static const char* TAG = "CommandWordDetect";
+
+// MultiNet 等待命令词结束的最长时间
+#define COMMAND_WORD_TIMEOUT_MS 3000
+
+CommandWordDetect::CommandWordDetect() {
+}
+
+CommandWordDetect::~CommandWordDetect() {
+    if (model_data_ != nullptr) {
+        multinet_->destroy(model_data_);
+    }
+}
+
+bool CommandWordDetect::ParseTable(const char* table) {
+    std::stringstream ss(table);
+    std::string entry;
+    while (std::getline(ss, entry, ';')) {
+        auto equal = entry.find('=');
+        if (equal == std::string::npos) {
+            continue;
+        }
+        CommandWord command;
+        command.pinyin = entry.substr(0, equal);
+        std::string action = entry.substr(equal + 1);
+        if (action == "abort") {
+            command.method = action;
+            commands_.push_back(command);
+            continue;
+        }
+
+        // Thing.Method:parameter=value
+        auto dot = action.find('.');
+        auto colon = action.find(':');
+        if (dot == std::string::npos || (colon != std::string::npos && colon < dot)) {
+            ESP_LOGW(TAG, "Invalid command action: %s", action.c_str());
+            continue;
+        }
+        command.thing = action.substr(0, dot);
+        command.method = action.substr(dot + 1, colon == std::string::npos ? std::string::npos : colon - dot - 1);
+        if (colon != std::string::npos) {
+            auto argument = action.substr(colon + 1);
+            auto assign = argument.find('=');
+            if (assign == std::string::npos || assign + 1 >= argument.size()) {
+                ESP_LOGW(TAG, "Invalid command parameter: %s", argument.c_str());
+                continue;
+            }
+            command.parameter = argument.substr(0, assign);
+            auto value = argument.substr(assign + 1);
+            command.relative = value[0] == '+' || value[0] == '-';
+            command.value = atoi(value.c_str());
+        }
+        commands_.push_back(command);
+    }
+    return !commands_.empty();
+}
+
+bool CommandWordDetect::Initialize(const char* table) {
+    if (!ParseTable(table)) {
+        ESP_LOGW(TAG, "Command word table is empty");
+        return false;
+    }
+
+    srmodel_list_t *models = esp_srmodel_init("model");
+    char* mn_name = esp_srmodel_filter(models, ESP_MN_PREFIX, ESP_MN_CHINESE);
+    if (mn_name == nullptr) {
+        ESP_LOGW(TAG, "No MultiNet model found, command words disabled");
+        commands_.clear();
+        return false;
+    }
+
+    multinet_ = esp_mn_handle_from_name(mn_name);
+    model_data_ = multinet_->create(mn_name, COMMAND_WORD_TIMEOUT_MS);
+
+    // 命令 id 从 1 开始，对应 commands_ 的下标加一
+    esp_mn_commands_alloc(multinet_, model_data_);
+    esp_mn_commands_clear();
+    for (size_t i = 0; i < commands_.size(); i++) {
+        esp_mn_commands_add(i + 1, (char*)commands_[i].pinyin.c_str());
+    }
+    auto errors = esp_mn_commands_update();
+    if (errors != nullptr) {
+        for (int i = 0; i < errors->num; i++) {
+            ESP_LOGW(TAG, "Invalid command word: %s", errors->phrases[i]->string);
+        }
+    }
+    ESP_LOGI(TAG, "MultiNet %s loaded with %zu commands, chunk size %d", mn_name, commands_.size(),
+        multinet_->get_samp_chunksize(model_data_));
+    return true;
+}
+
+void CommandWordDetect::OnCommandDetected(std::function<void(const CommandWord& command)> callback) {
+    command_detected_callback_ = callback;
+}
+
+void CommandWordDetect::Reset() {
+    if (model_data_ != nullptr) {
+        multinet_->clean(model_data_);
+    }
+}
+
+void CommandWordDetect::Feed(const int16_t* data, size_t samples) {
+    if (model_data_ == nullptr) {
+        return;
+    }
+    // AFE 的输出块和 MultiNet 的输入块大小相同，都是 512 个样本
+    size_t chunk_size = multinet_->get_samp_chunksize(model_data_);
+    for (size_t offset = 0; offset + chunk_size <= samples; offset += chunk_size) {
+        auto state = multinet_->detect(model_data_, (int16_t*)data + offset);
+        if (state == ESP_MN_STATE_DETECTING) {
+            continue;
+        }
+        if (state == ESP_MN_STATE_DETECTED) {
+            auto results = multinet_->get_results(model_data_);
+            int id = results->command_id[0];
+            if (id >= 1 && id <= (int)commands_.size()) {
+                auto& command = commands_[id - 1];
+                ESP_LOGI(TAG, "Command word detected: %s (prob %.2f)", command.pinyin.c_str(), results->prob[0]);
+                Execute(command);
+            }
+        }
+        // 检测到命令或超时后重新开始下一轮识别
+        multinet_->clean(model_data_);
+    }
+}
+
+// 和服务器下发的 iot 指令走同一个 ThingManager::Invoke，方法在主循环中执行
+void CommandWordDetect::Execute(const CommandWord& command) {
+    if (!command.thing.empty()) {
+        auto& thing_manager = iot::ThingManager::GetInstance();
+        int value = command.value;
+        if (command.relative) {
+            int current;
+            if (!thing_manager.GetPropertyNumber(command.thing, command.parameter, current)) {
+                ESP_LOGW(TAG, "Property %s.%s not found", command.thing.c_str(), command.parameter.c_str());
+                return;
+            }
+            value = std::clamp(current + command.value, 0, 100);
+        }
+
+        auto root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "name", command.thing.c_str());
+        cJSON_AddStringToObject(root, "method", command.method.c_str());
+        auto parameters = cJSON_AddObjectToObject(root, "parameters");
+        if (!command.parameter.empty()) {
+            cJSON_AddNumberToObject(parameters, command.parameter.c_str(), value);
+        }
+        bool invoked = thing_manager.Invoke(root);
+        cJSON_Delete(root);
+        if (!invoked) {
+            return;
+        }
+    }
+
+    if (command_detected_callback_) {
+        command_detected_callback_(command);
+    }
+}
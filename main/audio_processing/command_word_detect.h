@@ -0,0 +1,45 @@
+#ifndef COMMAND_WORD_DETECT_H
+#define COMMAND_WORD_DETECT_H
+
+#include <esp_mn_iface.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// 一条本地命令词：pinyin 为 MultiNet 的拼音短语，thing 为空时是不对应设备的内置动作（如 abort）
+struct CommandWord {
+    std::string pinyin;
+    std::string thing;
+    std::string method;
+    std::string parameter;
+    int value = 0;
+    // value 是相对当前属性值的增量
+    bool relative = false;
+};
+
+// 在唤醒词 AFE 的输出上运行 MultiNet，识别到命令词后直接调用本地注册的 iot::Thing 方法，不经过服务器
+// 命令表格式：拼音=Thing.Method:参数=值，多条用分号分隔，值带 +/- 号表示相对当前值调整；拼音=abort 表示打断播放
+class CommandWordDetect {
+public:
+    CommandWordDetect();
+    ~CommandWordDetect();
+
+    bool Initialize(const char* table);
+    bool IsInitialized() const { return model_data_ != nullptr; }
+    // data 为 AFE 输出的单声道 16kHz 数据
+    void Feed(const int16_t* data, size_t samples);
+    void Reset();
+    void OnCommandDetected(std::function<void(const CommandWord& command)> callback);
+
+private:
+    esp_mn_iface_t* multinet_ = nullptr;
+    model_iface_data_t* model_data_ = nullptr;
+    std::vector<CommandWord> commands_;
+    std::function<void(const CommandWord& command)> command_detected_callback_;
+
+    bool ParseTable(const char* table);
+    void Execute(const CommandWord& command);
+};
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef _POLYPHASE_RESAMPLER_H_
+#define _POLYPHASE_RESAMPLER_H_
+
+#include <array>
+#include <vector>
+#include <numeric>
+#include <cstdint>
+#include <cstring>
+
+namespace polyphase {
+
+constexpr double kPi = 3.14159265358979323846;
+// 系数为 Q14，上采样滤波器的单个相位系数绝对值之和可能超过 2.0，Q15 时 int32 累加有溢出的可能
+constexpr int kCoefficientBits = 14;
+
+constexpr double Sin(double x) {
+    // 先归约到 [-pi, pi]，再用泰勒级数
+    long turns = (long)(x / (2 * kPi) + (x >= 0 ? 0.5 : -0.5));
+    x -= turns * 2 * kPi;
+    double term = x, sum = x;
+    for (int i = 1; i < 20; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double Sqrt(double x) {
+    if (x <= 0) {
+        return 0;
+    }
+    double y = x > 1 ? x : 1;
+    for (int i = 0; i < 64; i++) {
+        y = (y + x / y) / 2;
+    }
+    return y;
+}
+
+// 第一类零阶修正贝塞尔函数，用于 Kaiser 窗
+constexpr double BesselI0(double x) {
+    double term = 1, sum = 1;
+    for (int k = 1; k < 40; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Up 个相位，每个相位 Taps 个 Q14 系数。系数倒序存放，卷积时按输入顺序正向点积
+template <int Up, int Taps>
+struct FilterBank {
+    std::array<std::array<int16_t, Taps>, Up> phases;
+};
+
+// 以 Kaiser 窗设计 Up * Taps 阶的低通原型滤波器，截止频率为输入、输出中较低的奈奎斯特频率乘以 rolloff
+template <int Up, int Down, int Taps>
+constexpr FilterBank<Up, Taps> DesignFilterBank(double beta, double rolloff) {
+    constexpr int length = Up * Taps;
+    const double cutoff = rolloff * 0.5 / (Up > Down ? Up : Down);
+    const double center = (length - 1) / 2.0;
+    const double window_scale = BesselI0(beta);
+
+    FilterBank<Up, Taps> bank{};
+    for (int phase = 0; phase < Up; phase++) {
+        for (int k = 0; k < Taps; k++) {
+            int n = phase + k * Up;
+            double t = n - center;
+            double sinc = t == 0 ? 2 * cutoff : Sin(2 * kPi * cutoff * t) / (kPi * t);
+            double r = 2.0 * n / (length - 1) - 1;
+            double window = BesselI0(beta * Sqrt(1 - r * r)) / window_scale;
+            // 插零上采样后需要乘以 Up 补偿增益
+            double value = sinc * window * Up * (1 << kCoefficientBits);
+            value += value >= 0 ? 0.5 : -0.5;
+            if (value > 32767) {
+                value = 32767;
+            } else if (value < -32768) {
+                value = -32768;
+            }
+            bank.phases[phase][Taps - 1 - k] = (int16_t)value;
+        }
+    }
+    return bank;
+}
+
+// 任意输入下 int32 累加都不会溢出
+template <int Up, int Taps>
+constexpr bool FitsInt32Accumulator(const FilterBank<Up, Taps>& bank) {
+    for (auto& phase : bank.phases) {
+        int64_t sum = 0;
+        for (auto c : phase) {
+            sum += c < 0 ? -c : c;
+        }
+        if (sum * 32768 + (1 << (kCoefficientBits - 1)) > INT32_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace polyphase
+
+// 定点多相重采样器，采样率比和滤波器在编译期确定
+// 输入输出均为交错的 Channels 声道数据，跨帧保留滤波器历史，可以连续处理任意长度的帧
+template <int InputRate, int OutputRate, int Channels, int Taps>
+class PolyphaseResampler {
+public:
+    static constexpr int kUp = OutputRate / std::gcd(InputRate, OutputRate);
+    static constexpr int kDown = InputRate / std::gcd(InputRate, OutputRate);
+    static constexpr int kHistory = (Taps - 1) * Channels;
+
+    PolyphaseResampler() : buffer_(kHistory, 0) {}
+
+    void Reset() {
+        buffer_.assign(kHistory, 0);
+        time_ = 0;
+    }
+
+    // 处理 input_samples（所有声道合计）后会产生的输出样本数
+    int GetOutputSamples(int input_samples) const {
+        int end = input_samples / Channels * kUp;
+        if (time_ >= end) {
+            return 0;
+        }
+        return (end - time_ + kDown - 1) / kDown * Channels;
+    }
+
+    int Process(const int16_t* input, int input_samples, int16_t* output) {
+        int frames = input_samples / Channels;
+        buffer_.resize(kHistory + frames * Channels);
+        memcpy(buffer_.data() + kHistory, input, frames * Channels * sizeof(int16_t));
+
+        // time_ 是下一个输出在上采样域中相对本帧第一个输入的位置
+        int end = frames * kUp;
+        int16_t* out = output;
+        while (time_ < end) {
+            int base = time_ / kUp;
+            auto& coefficients = kBank.phases[time_ % kUp];
+            const int16_t* x = buffer_.data() + base * Channels;
+            for (int channel = 0; channel < Channels; channel++) {
+                *out++ = Dot(coefficients.data(), x + channel);
+            }
+            time_ += kDown;
+        }
+        time_ -= end;
+
+        memmove(buffer_.data(), buffer_.data() + frames * Channels, kHistory * sizeof(int16_t));
+        return out - output;
+    }
+
+private:
+    static constexpr double kBeta = 7.0;
+    static constexpr double kRolloff = 0.92;
+    static constexpr auto kBank = polyphase::DesignFilterBank<kUp, kDown, Taps>(kBeta, kRolloff);
+    static_assert(polyphase::FitsInt32Accumulator(kBank), "filter gain too high for int32 accumulation");
+
+    std::vector<int16_t> buffer_;
+    int time_ = 0;
+
+    // Taps 是编译期常量，内层循环可以完全展开
+    static inline int16_t Dot(const int16_t* h, const int16_t* x) {
+        int32_t acc = 1 << (polyphase::kCoefficientBits - 1);
+#pragma GCC unroll 16
+        for (int i = 0; i < Taps; i++) {
+            acc += (int32_t)h[i] * x[i * Channels];
+        }
+        acc >>= polyphase::kCoefficientBits;
+        if (acc > INT16_MAX) {
+            return INT16_MAX;
+        } else if (acc < INT16_MIN) {
+            return INT16_MIN;
+        }
+        return acc;
+    }
+};
+
+#endif // _POLYPHASE_RESAMPLER_H_
@@ -0,0 +1,74 @@
+#ifndef UPLINK_VAD_GATE_H
+#define UPLINK_VAD_GATE_H
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+// 上行 VAD 门控：说话结束后再保持 hangover_ms 才停止上传，静音期间缓存最近 preroll_ms 的数据，
+// 重新开口时连同缓存一起上传，避免 VAD 判定滞后截掉开头。输入为 16kHz 单声道 PCM
+class UplinkVadGate {
+public:
+    UplinkVadGate(int hangover_ms, int preroll_ms) : hangover_ms_(hangover_ms), preroll_samples_(preroll_ms * 16) {}
+
+    void Reset() {
+        hangover_ = hangover_ms_;
+        closed_ = false;
+        preroll_.clear();
+    }
+
+    // 是否已停止上传（编码器中没有未凑满的帧）
+    bool closed() const { return closed_; }
+
+    // frame_samples 为编码器帧长，pending_samples 为编码器中还没凑满一帧的采样数。
+    // 静音开始后先补齐编码器里的半帧再停止，丢弃的静音也按整帧计算，
+    // 空缺前后的音频不会编进同一个包，时间戳保持按帧对齐。
+    // 需要编码的数据追加到 output，返回本次丢弃的静音时长（毫秒）
+    int Process(std::vector<int16_t>&& pcm, bool voice, int frame_samples, int pending_samples,
+                std::vector<std::vector<int16_t>>& output) {
+        int duration = pcm.size() / 16;
+        if (voice) {
+            hangover_ = hangover_ms_;
+        } else if (hangover_ > 0) {
+            hangover_ -= duration;
+        }
+
+        if (voice || hangover_ > 0) {
+            if (!preroll_.empty()) {
+                output.emplace_back(preroll_.begin(), preroll_.end());
+                preroll_.clear();
+            }
+            closed_ = false;
+            output.emplace_back(std::move(pcm));
+            return 0;
+        }
+
+        size_t offset = 0;
+        if (!closed_) {
+            size_t missing = (frame_samples - pending_samples) % frame_samples;
+            offset = std::min(pcm.size(), missing);
+            if (offset > 0) {
+                output.emplace_back(pcm.begin(), pcm.begin() + offset);
+            }
+            closed_ = offset == missing;
+        }
+        preroll_.insert(preroll_.end(), pcm.begin() + offset, pcm.end());
+
+        int dropped = 0;
+        while ((int)preroll_.size() >= preroll_samples_ + frame_samples) {
+            preroll_.erase(preroll_.begin(), preroll_.begin() + frame_samples);
+            dropped += frame_samples / 16;
+        }
+        return dropped;
+    }
+
+private:
+    int hangover_ms_;
+    int preroll_samples_;
+    int hangover_ = 0;
+    bool closed_ = false;
+    std::deque<int16_t> preroll_;
+};
+
+#endif // UPLINK_VAD_GATE_H
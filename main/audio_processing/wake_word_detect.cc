@@ -5,8 +5,13 @@
 #include <model_path.h>
 #include <arpa/inet.h>
 #include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
 
 #define DETECTION_RUNNING_EVENT 1
+// 门限判断时均方能量的下限，低于它一律视为安静
+#define WAKE_WORD_GATE_MIN_ENERGY 100
 
 static const char* TAG = "WakeWordDetect";
 
@@ -66,6 +71,18 @@ void WakeWordDetect::Initialize(AudioCodec* codec) {
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
 
+#if CONFIG_USE_WAKE_WORD_GATE
+    // 每个块的时长，采样率固定为 16000
+    int chunk_ms = afe_iface_->get_feed_chunksize(afe_data_) * 1000 / 16000;
+    gate_threshold_ = powf(10, CONFIG_WAKE_WORD_GATE_THRESHOLD_DB / 10.0f);
+    gate_hangover_chunks_ = std::max(1, CONFIG_WAKE_WORD_GATE_HANGOVER_MS / chunk_ms);
+    gate_idle_read_chunks_ = std::max(1, CONFIG_WAKE_WORD_GATE_IDLE_READ_MS / chunk_ms);
+    preroll_chunks_ = std::max(1, CONFIG_WAKE_WORD_GATE_PREROLL_MS / chunk_ms);
+    preroll_.resize(preroll_chunks_ * GetFeedSize());
+    ESP_LOGI(TAG, "Wake word gate: threshold %d dB, pre-roll %d chunks, hangover %d chunks, idle read %d chunks",
+        CONFIG_WAKE_WORD_GATE_THRESHOLD_DB, preroll_chunks_, gate_hangover_chunks_, gate_idle_read_chunks_);
+#endif
+
     xTaskCreate([](void* arg) {
         auto this_ = (WakeWordDetect*)arg;
         this_->AudioDetectionTask();
@@ -77,7 +94,14 @@ void WakeWordDetect::OnWakeWordDetected(std::function<void(const std::string& wa
     wake_word_detected_callback_ = callback;
 }
 
+void WakeWordDetect::OnAudioFetched(std::function<void(const int16_t* data, size_t samples)> callback) {
+    audio_fetched_callback_ = callback;
+}
+
 void WakeWordDetect::StartDetection() {
+#if CONFIG_USE_WAKE_WORD_GATE
+    gate_reset_ = true;
+#endif
     xEventGroupSetBits(event_group_, DETECTION_RUNNING_EVENT);
 }
 
@@ -91,13 +115,94 @@ bool WakeWordDetect::IsDetectionRunning() {
 }
 
 void WakeWordDetect::Feed(const std::vector<int16_t>& data) {
+#if CONFIG_USE_WAKE_WORD_GATE
+    size_t chunk_size = GetFeedSize();
+    for (size_t offset = 0; offset + chunk_size <= data.size(); offset += chunk_size) {
+        FeedGated(data.data() + offset, chunk_size);
+    }
+#else
     afe_iface_->feed(afe_data_, data.data());
+#endif
 }
 
 size_t WakeWordDetect::GetFeedSize() {
     return afe_iface_->get_feed_chunksize(afe_data_) * codec_->input_channels();
 }
 
+size_t WakeWordDetect::GetReadSize() {
+#if CONFIG_USE_WAKE_WORD_GATE
+    if (!gate_open_) {
+        return GetFeedSize() * gate_idle_read_chunks_;
+    }
+#endif
+    return GetFeedSize();
+}
+
+#if CONFIG_USE_WAKE_WORD_GATE
+// 只看第一个麦克风声道：均方能量高于底噪一定倍数，并且过零率不是直流或工频干扰
+bool WakeWordDetect::IsSoundPresent(const int16_t* data, size_t size) {
+    int channels = codec_->input_channels();
+    int frames = size / channels;
+    int64_t energy = 0;
+    int crossings = 0;
+    int16_t previous = data[0];
+    for (int i = 0; i < frames; i++) {
+        int16_t sample = data[i * channels];
+        energy += (int32_t)sample * sample;
+        if ((sample ^ previous) < 0) {
+            crossings++;
+        }
+        previous = sample;
+    }
+    energy /= frames;
+
+    // 底噪下降快、上升慢，持续的背景噪声大约十几秒后才会被当作底噪
+    if (noise_floor_ < 0) {
+        noise_floor_ = energy;
+    } else if (energy < noise_floor_) {
+        noise_floor_ = (noise_floor_ * 3 + energy) / 4;
+    } else {
+        noise_floor_ += (energy - noise_floor_) / 512;
+    }
+
+    return energy > WAKE_WORD_GATE_MIN_ENERGY && energy > noise_floor_ * gate_threshold_ && crossings * 100 >= frames;
+}
+
+void WakeWordDetect::FeedGated(const int16_t* data, size_t size) {
+    if (gate_reset_.exchange(false)) {
+        gate_open_ = false;
+        preroll_count_ = 0;
+    }
+    bool sound = IsSoundPresent(data, size);
+    if (sound) {
+        gate_hangover_ = gate_hangover_chunks_;
+    } else if (gate_open_ && --gate_hangover_ <= 0) {
+        gate_open_ = false;
+    }
+
+    if (!gate_open_ && !sound) {
+        // 门限关闭时只保存到预录缓冲区，AFE 任务阻塞在 fetch 上不占用 CPU
+        memcpy(&preroll_[preroll_head_ * size], data, size * sizeof(int16_t));
+        preroll_head_ = (preroll_head_ + 1) % preroll_chunks_;
+        preroll_count_ = std::min(preroll_count_ + 1, preroll_chunks_);
+        return;
+    }
+
+    if (!gate_open_) {
+        gate_open_ = true;
+        ESP_LOGD(TAG, "Wake word gate opened, noise floor %lld", noise_floor_);
+        // 补送唤醒词开头可能已经进入预录缓冲区的数据
+        int index = (preroll_head_ + preroll_chunks_ - preroll_count_) % preroll_chunks_;
+        for (int i = 0; i < preroll_count_; i++) {
+            afe_iface_->feed(afe_data_, &preroll_[index * size]);
+            index = (index + 1) % preroll_chunks_;
+        }
+        preroll_count_ = 0;
+    }
+    afe_iface_->feed(afe_data_, data);
+}
+#endif
+
 void WakeWordDetect::AudioDetectionTask() {
     auto fetch_size = afe_iface_->get_fetch_chunksize(afe_data_);
     auto feed_size = afe_iface_->get_feed_chunksize(afe_data_);
@@ -115,6 +220,10 @@ void WakeWordDetect::AudioDetectionTask() {
         // Store the wake word data for voice recognition, like who is speaking
         StoreWakeWordData((uint16_t*)res->data, res->data_size / sizeof(uint16_t));
 
+        if (audio_fetched_callback_) {
+            audio_fetched_callback_(res->data, res->data_size / sizeof(int16_t));
+        }
+
         if (res->wakeup_state == WAKENET_DETECTED) {
             StopDetection();
             last_detected_wake_word_ = wake_words_[res->wake_word_index - 1];
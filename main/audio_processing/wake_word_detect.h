@@ -14,6 +14,7 @@
 #include <functional>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 #include "audio_codec.h"
 
@@ -25,10 +26,14 @@ public:
     void Initialize(AudioCodec* codec);
     void Feed(const std::vector<int16_t>& data);
     void OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback);
+    // AFE 每次输出的单声道数据，在检测任务中回调，可以接命令词识别等后级
+    void OnAudioFetched(std::function<void(const int16_t* data, size_t samples)> callback);
     void StartDetection();
     void StopDetection();
     bool IsDetectionRunning();
     size_t GetFeedSize();
+    // 每次从 codec 读取的样本数，门限关闭时一次读多个块，减少采集任务的唤醒次数
+    size_t GetReadSize();
     void EncodeWakeWordData();
     bool GetWakeWordOpus(std::vector<uint8_t>& opus);
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
@@ -40,6 +45,7 @@ private:
     std::vector<std::string> wake_words_;
     EventGroupHandle_t event_group_;
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
+    std::function<void(const int16_t* data, size_t samples)> audio_fetched_callback_;
     AudioCodec* codec_ = nullptr;
     std::string last_detected_wake_word_;
 
@@ -53,6 +59,25 @@ private:
 
     void StoreWakeWordData(uint16_t* data, size_t size);
     void AudioDetectionTask();
+
+#if CONFIG_USE_WAKE_WORD_GATE
+    // 能量门限：安静时不送入 AFE，检测到声音后先补送预录的数据，再持续送入直到安静一段时间
+    // 门限状态只在音频任务中访问；StartDetection 在主循环中调用，只设置 gate_reset_，由 FeedGated 执行重置
+    std::atomic<bool> gate_reset_ = false;
+    bool gate_open_ = false;
+    int gate_hangover_ = 0;
+    int gate_hangover_chunks_ = 0;
+    int gate_idle_read_chunks_ = 1;
+    float gate_threshold_ = 0;
+    int64_t noise_floor_ = -1;
+    std::vector<int16_t> preroll_;
+    int preroll_chunks_ = 0;
+    int preroll_head_ = 0;
+    int preroll_count_ = 0;
+
+    bool IsSoundPresent(const int16_t* data, size_t size);
+    void FeedGated(const int16_t* data, size_t size);
+#endif
 };
 
 #endif
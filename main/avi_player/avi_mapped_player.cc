@@ -0,0 +1,214 @@
+#include "avi_mapped_player.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <cstring>
+#include <algorithm>
+
+#define TAG "AviMappedPlayer"
+
+#define AVI_EVENT_PLAY (1 << 0)
+#define AVI_EVENT_STOP (1 << 1)
+#define AVI_EVENT_IDLE (1 << 2)
+
+#define AVI_DEFAULT_FRAME_PERIOD_US (1000000 / 15)
+#define AVI_CHUNK_HEADER_SIZE 8
+#define AVI_INDEX_ENTRY_SIZE 16
+
+static uint32_t ReadU32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static bool IsFourCC(const uint8_t* p, const char* fourcc) {
+    return memcmp(p, fourcc, 4) == 0;
+}
+
+// 视频数据块的 ID 是 "##dc"（压缩）或 "##db"（未压缩）
+static bool IsVideoChunk(const uint8_t* id) {
+    return id[2] == 'd' && (id[3] == 'c' || id[3] == 'b');
+}
+
+AviMappedPlayer::AviMappedPlayer(FrameCallback on_frame, EndCallback on_end, int core_id)
+    : on_frame_(on_frame), on_end_(on_end) {
+    event_group_ = xEventGroupCreate();
+    xEventGroupSetBits(event_group_, AVI_EVENT_IDLE);
+
+    xTaskCreatePinnedToCore([](void* arg) {
+        auto player = (AviMappedPlayer*)arg;
+        player->PlayerTask();
+        vTaskDelete(NULL);
+    }, "avi_mapped", 4096, this, 4, &task_handle_, core_id);
+}
+
+AviMappedPlayer::~AviMappedPlayer() {
+    Stop();
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+    vEventGroupDelete(event_group_);
+}
+
+bool AviMappedPlayer::Play(std::string_view clip, bool loop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StopLocked();
+
+    auto data = (const uint8_t*)clip.data();
+    if (!ParseIndex(data, clip.size())) {
+        ESP_LOGE(TAG, "Invalid AVI clip (%u bytes)", (unsigned)clip.size());
+        return false;
+    }
+    clip_ = data;
+    loop_ = loop;
+    ESP_LOGI(TAG, "Playing %u frames, %lu us per frame", (unsigned)frames_.size(), (unsigned long)frame_period_us_);
+
+    // 片段自然结束后、播放任务回到空闲前调用的 Stop 会留下 STOP 位，不清除的话新片段会立即退出
+    xEventGroupClearBits(event_group_, AVI_EVENT_IDLE | AVI_EVENT_STOP);
+    xEventGroupSetBits(event_group_, AVI_EVENT_PLAY);
+    return true;
+}
+
+void AviMappedPlayer::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StopLocked();
+}
+
+bool AviMappedPlayer::IsPlaying() {
+    return (xEventGroupGetBits(event_group_) & AVI_EVENT_IDLE) == 0;
+}
+
+void AviMappedPlayer::StopLocked() {
+    if (xEventGroupGetBits(event_group_) & AVI_EVENT_IDLE) {
+        return;
+    }
+    // 播放任务最多再显示完当前帧就会回到空闲状态
+    xEventGroupSetBits(event_group_, AVI_EVENT_STOP);
+    xEventGroupWaitBits(event_group_, AVI_EVENT_IDLE, pdFALSE, pdFALSE, portMAX_DELAY);
+}
+
+bool AviMappedPlayer::ParseIndex(const uint8_t* data, size_t size) {
+    frames_.clear();
+    frame_period_us_ = AVI_DEFAULT_FRAME_PERIOD_US;
+    if (size < 12 || !IsFourCC(data, "RIFF") || !IsFourCC(data + 8, "AVI ")) {
+        return false;
+    }
+
+    size_t end = std::min<size_t>(size, (size_t)ReadU32(data + 4) + AVI_CHUNK_HEADER_SIZE);
+    size_t movi_start = 0, movi_end = 0;
+    size_t index_start = 0, index_size = 0;
+    for (size_t pos = 12; pos + AVI_CHUNK_HEADER_SIZE <= end; ) {
+        size_t body = pos + AVI_CHUNK_HEADER_SIZE;
+        size_t length = std::min<size_t>(ReadU32(data + pos + 4), end - body);
+        if (IsFourCC(data + pos, "LIST") && length >= 4) {
+            if (IsFourCC(data + body, "movi")) {
+                movi_start = body;
+                movi_end = body + length;
+            } else if (IsFourCC(data + body, "hdrl") && length >= 4 + AVI_CHUNK_HEADER_SIZE + 4 &&
+                       IsFourCC(data + body + 4, "avih")) {
+                // avih 的第一个字段是 dwMicroSecPerFrame
+                uint32_t period = ReadU32(data + body + 4 + AVI_CHUNK_HEADER_SIZE);
+                if (period > 0) {
+                    frame_period_us_ = period;
+                }
+            }
+        } else if (IsFourCC(data + pos, "idx1")) {
+            index_start = body;
+            index_size = length;
+        }
+        pos = body + length + (length & 1);
+    }
+    if (movi_start == 0) {
+        return false;
+    }
+
+    // idx1 的偏移通常相对 movi 的 FourCC，少数编码器写的是文件偏移，用第一个视频块判断
+    size_t base = SIZE_MAX;
+    for (size_t i = 0; i + AVI_INDEX_ENTRY_SIZE <= index_size; i += AVI_INDEX_ENTRY_SIZE) {
+        auto entry = data + index_start + i;
+        if (!IsVideoChunk(entry)) {
+            continue;
+        }
+        size_t offset = ReadU32(entry + 8);
+        size_t frame_size = ReadU32(entry + 12);
+        if (base == SIZE_MAX) {
+            if (movi_start + offset + 4 <= size && IsFourCC(data + movi_start + offset, (const char*)entry)) {
+                base = movi_start;
+            } else if (offset + 4 <= size && IsFourCC(data + offset, (const char*)entry)) {
+                base = 0;
+            } else {
+                break;
+            }
+        }
+        size_t frame_offset = base + offset + AVI_CHUNK_HEADER_SIZE;
+        if (frame_offset > size || frame_size > size - frame_offset) {
+            ESP_LOGW(TAG, "Frame %u out of range, index ignored", (unsigned)frames_.size());
+            frames_.clear();
+            break;
+        }
+        // 长度为 0 的帧表示重复上一帧，保留下来以维持播放节奏
+        frames_.push_back({(uint32_t)frame_offset, (uint32_t)frame_size});
+    }
+
+    if (frames_.empty() && !ScanMovi(data, movi_start + 4, movi_end)) {
+        return false;
+    }
+    frames_.shrink_to_fit();
+    return !frames_.empty();
+}
+
+// 没有 idx1 时顺序遍历 movi 列表
+bool AviMappedPlayer::ScanMovi(const uint8_t* data, size_t start, size_t end) {
+    for (size_t pos = start; pos + AVI_CHUNK_HEADER_SIZE <= end; ) {
+        size_t body = pos + AVI_CHUNK_HEADER_SIZE;
+        size_t length = std::min<size_t>(ReadU32(data + pos + 4), end - body);
+        if (IsFourCC(data + pos, "LIST") && length >= 4 && IsFourCC(data + body, "rec ")) {
+            ScanMovi(data, body + 4, body + length);
+        } else if (IsVideoChunk(data + pos)) {
+            frames_.push_back({(uint32_t)body, (uint32_t)length});
+        }
+        pos = body + length + (length & 1);
+    }
+    return !frames_.empty();
+}
+
+void AviMappedPlayer::PlayerTask() {
+    while (true) {
+        xEventGroupWaitBits(event_group_, AVI_EVENT_PLAY, pdTRUE, pdFALSE, portMAX_DELAY);
+
+        int64_t next_frame_time = esp_timer_get_time();
+        size_t index = 0;
+        bool finished = false;
+        while ((xEventGroupGetBits(event_group_) & AVI_EVENT_STOP) == 0) {
+            if (index == frames_.size()) {
+                if (!loop_) {
+                    finished = true;
+                    break;
+                }
+                index = 0;
+            }
+            auto& frame = frames_[index++];
+            if (frame.size > 0) {
+                on_frame_(clip_ + frame.offset, frame.size);
+            }
+
+            // 按绝对时间推进，解码耗时不会累积成播放变慢；落后太多时不追帧
+            next_frame_time += frame_period_us_;
+            int64_t now = esp_timer_get_time();
+            if (next_frame_time > now) {
+                vTaskDelay(std::max<TickType_t>(pdMS_TO_TICKS((next_frame_time - now) / 1000), 1));
+            } else {
+                next_frame_time = now;
+                vTaskDelay(1);
+            }
+        }
+
+        // 在回到空闲前调用，下一次 Play 等待空闲，回调的效果不会覆盖新片段的设置
+        if (finished && on_end_ != nullptr) {
+            on_end_();
+        }
+        xEventGroupClearBits(event_group_, AVI_EVENT_STOP);
+        xEventGroupSetBits(event_group_, AVI_EVENT_IDLE);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef AVI_MAPPED_PLAYER_H
+#define AVI_MAPPED_PLAYER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// 播放已映射到地址空间的 AVI（例如 assets 分区中的 anim/*.avi）
+// 打开时解析一次 RIFF / idx1 索引，播放时把 flash 中 JPEG 帧的指针直接交给回调，不经过读缓冲区
+class AviMappedPlayer {
+public:
+    using FrameCallback = std::function<void(const uint8_t* data, size_t size)>;
+    // 不循环的片段自然播放完时在播放任务中调用，Stop 停止时不调用
+    using EndCallback = std::function<void()>;
+
+    AviMappedPlayer(FrameCallback on_frame, EndCallback on_end, int core_id);
+    ~AviMappedPlayer();
+
+    // 停止当前片段后开始播放 clip，clip 需要在播放期间保持有效
+    bool Play(std::string_view clip, bool loop);
+    void Stop();
+    bool IsPlaying();
+    // 当前片段的帧间隔，Play 成功后有效
+    uint32_t frame_period_us() const { return frame_period_us_; }
+
+private:
+    struct Frame {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    FrameCallback on_frame_;
+    EndCallback on_end_;
+    std::mutex mutex_;
+    EventGroupHandle_t event_group_ = nullptr;
+    TaskHandle_t task_handle_ = nullptr;
+    const uint8_t* clip_ = nullptr;
+    std::vector<Frame> frames_;
+    uint32_t frame_period_us_ = 0;
+    bool loop_ = false;
+
+    bool ParseIndex(const uint8_t* data, size_t size);
+    bool ScanMovi(const uint8_t* data, size_t start, size_t end);
+    void StopLocked();
+    void PlayerTask();
+};
+
+#endif // AVI_MAPPED_PLAYER_H
@@ -3,11 +3,21 @@
 #include "esp_jpeg_decode.h"
 #include "fs_manager.h"
 #include "board.h"
+#include "media_memory.h"
 #include "freertos/semphr.h"  // 添加这行以支持信号量
+#if CONFIG_USE_ASSET_PARTITION
+#include "assets.h"
+#include "avi_mapped_player.h"
+#include <string>
+#endif
 static const char *TAG = "avi_player_port";
 
 static i2s_chan_handle_t i2s_tx_handle = NULL;
-static uint8_t *img_rgb565 = NULL;
+#define FRAME_BUFFER_SIZE (240 * 280 * 2)
+
+// 双缓冲：画布显示其中一个时解码到另一个，缓冲区来自 PSRAM 帧内存池，播放期间不再逐帧分配
+static uint8_t *frame_buffers[2] = {NULL, NULL};
+static int frame_index = 0;
 
 static bool is_playing = false;
 static char file_path[128] = {0};
@@ -15,19 +25,39 @@ static bool enable_loop = true;  // 默认启用循环播放
 
 static SemaphoreHandle_t avi_mutex = NULL;  // 添加互斥锁
 
+#if CONFIG_USE_ASSET_PARTITION
+// assets 分区可用时动画直接从 flash 映射播放，不挂载 SPIFFS，也不初始化 avi_player 的读缓冲区
+static AviMappedPlayer *mapped_player = NULL;
+#endif
 
-void video_write(frame_data_t *data, void *arg)
+static void show_frame(const uint8_t *data, size_t size)
 {
     int Rgbsize = 0;
-    esp_jpeg_decode_one_picture(data->data, data->data_bytes, &img_rgb565, &Rgbsize);
+    uint8_t *frame = frame_buffers[frame_index];
+    if (frame == NULL) {
+        return;
+    }
+    // 画面由 LVGL 任务异步更新，上一帧还没显示时丢弃本帧，避免解码覆盖画布正在使用的缓冲区
+    auto display = Board::GetInstance().GetDisplay();
+    if (display->IsFaceImagePending()) {
+        return;
+    }
+    // 解码器只读取输入，flash 映射的帧可以直接传入
+    if (esp_jpeg_decode_to_buffer((uint8_t *)data, size, frame, FRAME_BUFFER_SIZE, &Rgbsize) != JPEG_ERR_OK) {
+        return;
+    }
     // 通过回调函数更新LCD显示
-    if (img_rgb565 != NULL&& Rgbsize > 0) {
-        auto display = Board::GetInstance().GetDisplay();
-        display->SetFaceImage(img_rgb565, get_rgb_width(), get_rgb_height());
-        free(img_rgb565);
+    if (Rgbsize > 0) {
+        display->SetFaceImage(frame, get_rgb_width(), get_rgb_height());
+        frame_index ^= 1;
     }
 }
 
+void video_write(frame_data_t *data, void *arg)
+{
+    show_frame(data->data, data->data_bytes);
+}
+
 void audio_write(frame_data_t *data, void *arg)
 {
     size_t bytes_write = 0;
@@ -100,27 +130,31 @@ esp_err_t avi_player_port_init(avi_player_port_config_t *config)
         }
     }
 
-    // 使用SPIFFS
-    fs_config_t spiffs_config = {
-        .type = FS_TYPE_SPIFFS,
-        .spiffs = {
-            .base_path = "/spiffs",
-            .partition_label = "storage",
-            .max_files = 5,
-            .format_if_mount_failed = true
+    auto& media_memory = MediaMemory::GetInstance();
+    for (auto& buffer : frame_buffers) {
+        buffer = (uint8_t *)media_memory.Allocate(kMediaPoolFrame, FRAME_BUFFER_SIZE);
+        if (!buffer)
+        {
+            return ESP_ERR_NO_MEM;
         }
-    };
-    // 初始化文件系统
-    ESP_ERROR_CHECK(fs_manager_init(&spiffs_config));  // 或 &sdcard_config
-
-    // 列出文件
-    fs_manager_list_files("/spiffs");  // 或 "/sdcard"
+    }
 
-    img_rgb565 = (uint8_t *)heap_caps_malloc(240 * 280 * 2, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
-    if (!img_rgb565)
-    {
-        return ESP_ERR_NO_MEM;
+#if CONFIG_USE_ASSET_PARTITION
+    if (Assets::GetInstance().Initialize()) {
+        // 不循环的片段播放完后恢复默认刷新周期
+        mapped_player = new AviMappedPlayer(show_frame, []() {
+            Board::GetInstance().GetDisplay()->SetFrameRate(0);
+        }, config->core_id);
+        return ESP_OK;
     }
+    ESP_LOGW(TAG, "assets 分区不可用，使用 SPIFFS 播放");
+#endif
+
+    // 使用SPIFFS
+    ESP_ERROR_CHECK(fs_manager_mount_storage());
+
+    // 列出文件
+    fs_manager_list_files(FS_STORAGE_BASE_PATH);  // 或 "/sdcard"
 
     avi_player_config_t player_config = {
         .buffer_size = config->buffer_size,
@@ -146,6 +180,25 @@ esp_err_t avi_player_port_play_file(const char *filepath)
         ESP_LOGE(TAG, "无法获取互斥锁，可能存在死锁");
         return ESP_ERR_TIMEOUT;
     }
+
+#if CONFIG_USE_ASSET_PARTITION
+    if (mapped_player != NULL) {
+        // 按文件名在 assets 分区中查找，例如 /spiffs/xiaoliang.avi 对应 anim/xiaoliang.avi
+        const char *file_name = strrchr(filepath, '/');
+        std::string asset_name = std::string("anim/") + (file_name ? file_name + 1 : filepath);
+        auto clip = Assets::GetInstance().Get(asset_name);
+        esp_err_t ret = ESP_ERR_NOT_FOUND;
+        if (!clip.empty()) {
+            ret = mapped_player->Play(clip, enable_loop) ? ESP_OK : ESP_FAIL;
+        }
+        if (ret == ESP_OK) {
+            // 播放期间按视频帧率刷新屏幕
+            Board::GetInstance().GetDisplay()->SetFrameRate(1000000 / mapped_player->frame_period_us());
+        }
+        xSemaphoreGive(avi_mutex);
+        return ret;
+    }
+#endif
     
     // 检查文件是否存在
     FILE* f = fopen(filepath, "r");
@@ -186,6 +239,13 @@ esp_err_t avi_player_port_play_file(const char *filepath)
 
 esp_err_t avi_player_port_stop(void)
 {
+#if CONFIG_USE_ASSET_PARTITION
+    if (mapped_player != NULL) {
+        mapped_player->Stop();
+        Board::GetInstance().GetDisplay()->SetFrameRate(0);
+        return ESP_OK;
+    }
+#endif
     if (avi_mutex != NULL && xSemaphoreTake(avi_mutex, pdMS_TO_TICKS(500)) == pdTRUE) {
         if (!is_playing) {
             ESP_LOGW(TAG, "已经停止播放，无需再次停止");
@@ -218,7 +278,16 @@ esp_err_t avi_player_port_stop(void)
 void avi_player_port_deinit(void)
 {
     avi_player_port_stop();
+#if CONFIG_USE_ASSET_PARTITION
+    if (mapped_player != NULL) {
+        delete mapped_player;
+        mapped_player = NULL;
+    } else {
+        avi_player_deinit();
+    }
+#else
     avi_player_deinit();
+#endif
     
     // 删除互斥锁
     if (avi_mutex != NULL) {
@@ -226,9 +295,8 @@ void avi_player_port_deinit(void)
         avi_mutex = NULL;
     }
     
-    if (img_rgb565)
-    {
-        free(img_rgb565);
-        img_rgb565 = NULL;
+    for (auto& buffer : frame_buffers) {
+        MediaMemory::GetInstance().Free(kMediaPoolFrame, buffer);
+        buffer = NULL;
     }
 }
\ No newline at end of file
@@ -22,7 +22,8 @@ size_t get_rgb_height()
 {
     return rgb_height;
 }
-jpeg_error_t esp_jpeg_decode_one_picture(uint8_t *input_buf, int len, uint8_t **output_buf, int *out_len)
+// *output_buf 为 NULL 时按图片大小分配输出缓冲区，否则解码到调用方提供的 output_size 字节缓冲区（需 16 字节对齐）
+static jpeg_error_t decode_picture(uint8_t *input_buf, int len, uint8_t **output_buf, int output_size, int *out_len)
 {
     uint8_t *out_buf = NULL;
     jpeg_error_t ret = JPEG_ERR_OK;
@@ -92,7 +93,20 @@ jpeg_error_t esp_jpeg_decode_one_picture(uint8_t *input_buf, int len, uint8_t **
         ret = JPEG_ERR_INVALID_PARAM;
         goto jpeg_dec_failed;
     }
-    out_buf = jpeg_calloc_align(*out_len, 16);
+    if (*output_buf != NULL)
+    {
+        if (*out_len > output_size)
+        {
+            ESP_LOGE(TAG, "Frame %dx%d does not fit the %d bytes output buffer", out_info->width, out_info->height, output_size);
+            ret = JPEG_ERR_NO_MEM;
+            goto jpeg_dec_failed;
+        }
+        out_buf = *output_buf;
+    }
+    else
+    {
+        out_buf = jpeg_calloc_align(*out_len, 16);
+    }
     if (out_buf == NULL)
     {
         ret = JPEG_ERR_NO_MEM;
@@ -121,3 +135,14 @@ jpeg_dec_failed:
     }
     return ret;
 }
+
+jpeg_error_t esp_jpeg_decode_one_picture(uint8_t *input_buf, int len, uint8_t **output_buf, int *out_len)
+{
+    *output_buf = NULL;
+    return decode_picture(input_buf, len, output_buf, 0, out_len);
+}
+
+jpeg_error_t esp_jpeg_decode_to_buffer(uint8_t *input_buf, int len, uint8_t *output_buf, int output_size, int *out_len)
+{
+    return decode_picture(input_buf, len, &output_buf, output_size, out_len);
+}
@@ -17,6 +17,8 @@ size_t get_rgb_height();
 
 
 jpeg_error_t esp_jpeg_decode_one_picture(uint8_t *input_buf, int len, uint8_t **output_buf, int *out_len);
+// 解码到预先分配的缓冲区，避免每帧分配和释放
+jpeg_error_t esp_jpeg_decode_to_buffer(uint8_t *input_buf, int len, uint8_t *output_buf, int output_size, int *out_len);
 
 #ifdef __cplusplus
 }
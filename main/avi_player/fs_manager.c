@@ -1,9 +1,13 @@
 #include "fs_manager.h"
 #include <dirent.h>
+#include <pthread.h>
+#include <string.h>
 
 static const char *TAG = "fs_manager";
 static fs_type_t current_fs_type = FS_TYPE_SPIFFS;
 static sdmmc_card_t *sd_card = NULL;
+// 启动阶段并行执行，播放器和回放可能同时挂载
+static pthread_mutex_t storage_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static esp_err_t init_spiffs(fs_config_t *config)
 {
@@ -88,6 +92,35 @@ esp_err_t fs_manager_init(fs_config_t *config)
     return ESP_ERR_INVALID_ARG;
 }
 
+esp_err_t fs_manager_mount_storage(void)
+{
+    pthread_mutex_lock(&storage_mutex);
+    esp_err_t ret = ESP_OK;
+    if (!esp_spiffs_mounted(FS_STORAGE_PARTITION)) {
+        fs_config_t config = {
+            .type = FS_TYPE_SPIFFS,
+            .spiffs = {
+                .base_path = FS_STORAGE_BASE_PATH,
+                .partition_label = FS_STORAGE_PARTITION,
+                .max_files = 5,
+                .format_if_mount_failed = true
+            }
+        };
+        ret = fs_manager_init(&config);
+    }
+    pthread_mutex_unlock(&storage_mutex);
+    return ret;
+}
+
+esp_err_t fs_manager_prepare_path(const char* path)
+{
+    size_t length = strlen(FS_STORAGE_BASE_PATH);
+    if (strncmp(path, FS_STORAGE_BASE_PATH, length) != 0 || (path[length] != '/' && path[length] != '\0')) {
+        return ESP_OK;
+    }
+    return fs_manager_mount_storage();
+}
+
 void fs_manager_list_files(const char* path)
 {
     DIR *dir = opendir(path);
@@ -13,6 +13,9 @@
 extern "C" {
 #endif
 
+#define FS_STORAGE_BASE_PATH "/spiffs"
+#define FS_STORAGE_PARTITION "storage"
+
 // 文件系统类型枚举
 typedef enum {
     FS_TYPE_SPIFFS,
@@ -47,6 +50,20 @@ typedef struct {
  */
 esp_err_t fs_manager_init(fs_config_t *config);
 
+/**
+ * @brief 挂载 storage 分区到 FS_STORAGE_BASE_PATH，已挂载时直接返回
+ *        SPIFFS 播放、会话录制和回放共用，使用 assets 分区播放时启动阶段不会挂载
+ * @return esp_err_t
+ */
+esp_err_t fs_manager_mount_storage(void);
+
+/**
+ * @brief 访问文件前调用，path 位于 FS_STORAGE_BASE_PATH 下时按需挂载 storage 分区
+ * @param path 文件路径
+ * @return esp_err_t path 不在 storage 分区上时返回 ESP_OK
+ */
+esp_err_t fs_manager_prepare_path(const char* path);
+
 /**
  * @brief 列出指定目录下的文件
  * @param path 目录路径
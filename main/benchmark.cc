@@ -0,0 +1,333 @@
+#include "benchmark.h"
+#include "audio_processing/audio_resampler.h"
+#include "iot/thing_manager.h"
+
+#include <esp_log.h>
+#include <mbedtls/aes.h>
+#include <cJSON.h>
+#if !CONFIG_IDF_TARGET_LINUX
+#include <opus_encoder.h>
+#include <opus_decoder.h>
+#include <opus_resampler.h>
+#include <esp_cpu.h>
+#include <esp_heap_caps.h>
+#include "avi_player/esp_jpeg_decode.h"
+#if CONFIG_USE_ASSET_PARTITION
+#include "assets.h"
+#endif
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "Benchmark"
+
+#define BENCH_JPEG_MAX_FRAMES 16
+#define BENCH_JPEG_CLIP "xiaoliang_idle.avi"
+
+// 目标板上按 CPU 周期计时；Linux 主机上用纳秒代替，cpu_mhz 记为 1000，只用于相对比较
+#if CONFIG_IDF_TARGET_LINUX
+#define BENCH_CPU_MHZ 1000
+static inline uint32_t GetCycles() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#else
+#define BENCH_CPU_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+static inline uint32_t GetCycles() {
+    return esp_cpu_get_cycle_count();
+}
+#endif
+
+void Benchmark::RegisterSuite(const char* name, Suite suite) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    suites_[name] = std::move(suite);
+}
+
+std::vector<std::string> Benchmark::GetSuiteNames() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (auto& [name, suite] : suites_) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+void Benchmark::Measure(const std::string& name, int iterations, const Operation& operation) {
+    if (iterations_override_ > 0) {
+        iterations = iterations_override_;
+    }
+    iterations = std::max(1, iterations);
+    for (int i = 0; i < std::max(1, iterations / 10); i++) {
+        operation();
+    }
+
+    std::vector<uint32_t> cycles(iterations);
+    size_t bytes = 0;
+    for (int i = 0; i < iterations; i++) {
+        uint32_t start = GetCycles();
+        bytes += operation();
+        cycles[i] = GetCycles() - start;
+    }
+    std::sort(cycles.begin(), cycles.end());
+    uint32_t median = cycles[iterations / 2];
+    size_t bytes_per_op = bytes / iterations;
+    printf("BENCH {\"suite\":\"%s\",\"case\":\"%s\",\"iterations\":%d,\"cpu_mhz\":%d,"
+        "\"cycles_min\":%lu,\"cycles_median\":%lu,\"cycles_max\":%lu,\"bytes_per_op\":%u,\"cycles_per_byte\":%.2f}\n",
+        current_suite_, name.c_str(), iterations, BENCH_CPU_MHZ, (unsigned long)cycles.front(),
+        (unsigned long)median, (unsigned long)cycles.back(), (unsigned)bytes_per_op,
+        bytes_per_op > 0 ? (double)median / bytes_per_op : 0.0);
+}
+
+void Benchmark::Run(const std::vector<std::string>& names, int iterations) {
+    std::vector<std::pair<std::string, Suite>> suites;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [name, suite] : suites_) {
+            if (names.empty() || std::find(names.begin(), names.end(), name) != names.end()) {
+                suites.emplace_back(name, suite);
+            }
+        }
+    }
+    iterations_override_ = iterations;
+    for (auto& [name, suite] : suites) {
+        current_suite_ = name.c_str();
+        suite(*this);
+    }
+    current_suite_ = nullptr;
+    iterations_override_ = 0;
+}
+
+// 固定种子的测试信号：两个正弦叠加少量噪声，接近语音的频谱，编码器不会走静音捷径
+static std::vector<int16_t> GenerateSignal(int sample_rate, int samples) {
+    std::vector<int16_t> pcm(samples);
+    uint32_t seed = 12345;
+    for (int i = 0; i < samples; i++) {
+        seed = seed * 1103515245 + 12345;
+        float t = (float)i / sample_rate;
+        float value = 6000 * sinf(2 * M_PI * 220 * t) + 3000 * sinf(2 * M_PI * 1330 * t) + (int)(seed >> 20) - 2048;
+        pcm[i] = (int16_t)value;
+    }
+    return pcm;
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+static void OpusSuite(Benchmark& bench) {
+    const int duration_ms = 60;
+    auto pcm = GenerateSignal(16000, 16000 * duration_ms / 1000);
+
+    for (int complexity = 0; complexity <= 10; complexity++) {
+        OpusEncoderWrapper encoder(16000, 1, duration_ms);
+        encoder.SetComplexity(complexity);
+        bench.Measure("encode_16k_c" + std::to_string(complexity), 20, [&]() {
+            encoder.Encode(std::vector<int16_t>(pcm), [](std::vector<uint8_t>&& opus) {});
+            return pcm.size() * sizeof(int16_t);
+        });
+    }
+
+    // 下行解码按服务器常用的 16k / 24k 分别测量，先编码出一段固定的包序列
+    for (int sample_rate : {16000, 24000}) {
+        auto signal = GenerateSignal(sample_rate, sample_rate * duration_ms / 1000);
+        std::vector<std::vector<uint8_t>> packets;
+        OpusEncoderWrapper encoder(sample_rate, 1, duration_ms);
+        encoder.SetComplexity(3);
+        for (int i = 0; i < 16; i++) {
+            encoder.Encode(std::vector<int16_t>(signal), [&packets](std::vector<uint8_t>&& opus) {
+                packets.push_back(std::move(opus));
+            });
+        }
+        if (packets.empty()) {
+            continue;
+        }
+        OpusDecoderWrapper decoder(sample_rate, 1, duration_ms);
+        std::vector<int16_t> output;
+        size_t index = 0;
+        bench.Measure("decode_" + std::to_string(sample_rate / 1000) + "k", 50, [&]() {
+            auto& packet = packets[index++ % packets.size()];
+            decoder.Decode(std::vector<uint8_t>(packet), output);
+            return packet.size();
+        });
+    }
+}
+
+#endif
+
+static void ResamplerSuite(Benchmark& bench) {
+#if CONFIG_IDF_TARGET_LINUX
+    // 主机上没有 Opus 的重采样器，只测多相滤波覆盖的组合
+    const int pairs[][2] = {{16000, 24000}, {24000, 16000}, {48000, 16000}, {44100, 16000}};
+#else
+    const int pairs[][2] = {{16000, 24000}, {24000, 16000}, {48000, 16000}, {44100, 16000}, {24000, 48000}};
+#endif
+    for (auto& pair : pairs) {
+        auto input = GenerateSignal(pair[0], pair[0] * 60 / 1000);
+        std::string rates = std::to_string(pair[0]) + "_" + std::to_string(pair[1]);
+        std::vector<int16_t> output;
+
+#if !CONFIG_IDF_TARGET_LINUX
+        OpusResampler opus;
+        opus.Configure(pair[0], pair[1]);
+        output.resize(opus.GetOutputSamples(input.size()));
+        bench.Measure("opus_" + rates, 50, [&]() {
+            opus.Process(input.data(), input.size(), output.data());
+            return input.size() * sizeof(int16_t);
+        });
+#endif
+
+        // 应用实际使用的重采样器，常用组合走多相滤波
+        AudioResampler resampler;
+        resampler.Configure(pair[0], pair[1]);
+        output.resize(resampler.GetOutputSamples(input.size()));
+        bench.Measure("audio_" + rates, 50, [&]() {
+            resampler.Process(input.data(), input.size(), output.data());
+            return input.size() * sizeof(int16_t);
+        });
+    }
+}
+
+// 与 MqttProtocol::SendAudio 相同的组包：复制 nonce、写入长度时间戳序号、AES-CTR 加密负载
+static void AesSuite(Benchmark& bench) {
+    uint8_t key[16];
+    std::string aes_nonce(16, '\0');
+    for (int i = 0; i < 16; i++) {
+        key[i] = i * 17 + 3;
+        aes_nonce[i] = i * 29 + 7;
+    }
+    mbedtls_aes_context aes_ctx;
+    mbedtls_aes_init(&aes_ctx);
+    mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
+
+    uint32_t timestamp = 0;
+    uint32_t sequence = 0;
+    for (size_t size : {64, 160, 480}) {
+        std::vector<uint8_t> data(size, 0x5A);
+        bench.Measure("ctr_packet_" + std::to_string(size), 200, [&]() {
+            std::string nonce(aes_nonce);
+            *(uint16_t*)&nonce[2] = __builtin_bswap16(data.size());
+            *(uint32_t*)&nonce[8] = __builtin_bswap32(timestamp);
+            *(uint32_t*)&nonce[12] = __builtin_bswap32(++sequence);
+            timestamp += 60;
+
+            std::string encrypted;
+            encrypted.resize(aes_nonce.size() + data.size());
+            memcpy(encrypted.data(), nonce.data(), nonce.size());
+            size_t nc_off = 0;
+            uint8_t stream_block[16] = {0};
+            mbedtls_aes_crypt_ctr(&aes_ctx, data.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
+                data.data(), (uint8_t*)&encrypted[nonce.size()]);
+            return data.size();
+        });
+    }
+    mbedtls_aes_free(&aes_ctx);
+}
+
+static void JsonSuite(Benchmark& bench) {
+    // 服务器下发的典型消息
+    const char* messages[][2] = {
+        {"hello", R"({"type":"hello","version":3,"session_id":"4f3a9c2e-8d1b-4e6a-9f0c-2b7d5e1a8c34","transport":"udp",)"
+                  R"("udp":{"server":"120.24.160.13","port":8884,"encryption":"aes-128-ctr",)"
+                  R"("key":"263094c3aa28cb42f3965a1020cb21a7","nonce":"01000000ccba9720b4bc268100000000"},)"
+                  R"("audio_params":{"format":"opus","sample_rate":24000,"channels":1,"frame_duration":60}})"},
+        {"tts", R"({"type":"tts","state":"sentence_start","text":"今天天气不错，适合出去走走，记得带上水杯哦。","session_id":"4f3a9c2e"})"},
+        {"stt", R"({"type":"stt","text":"明天早上七点叫我起床","session_id":"4f3a9c2e"})"},
+        {"iot", R"({"type":"iot","commands":[{"name":"Speaker","method":"SetVolume","parameters":{"volume":60}},)"
+                R"({"name":"Screen","method":"SetBrightness","parameters":{"brightness":80}}],"session_id":"4f3a9c2e"})"},
+    };
+    for (auto& message : messages) {
+        size_t length = strlen(message[1]);
+        bench.Measure(std::string("parse_") + message[0], 200, [&]() {
+            auto root = cJSON_ParseWithLength(message[1], length);
+            cJSON_Delete(root);
+            return length;
+        });
+    }
+}
+
+static void ThingSuite(Benchmark& bench) {
+    auto& thing_manager = iot::ThingManager::GetInstance();
+    bench.Measure("descriptors_json", 50, [&]() {
+        return thing_manager.GetDescriptorsJson().size();
+    });
+    bench.Measure("states_json", 100, [&]() {
+        std::string json;
+        thing_manager.GetStatesJson(json, false);
+        return json.size();
+    });
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+// 从 AVI 中找出前几个 "00dc" JPEG 帧，不解析索引，只用于取样
+static std::vector<std::pair<const uint8_t*, size_t>> FindJpegFrames(const uint8_t* data, size_t size) {
+    std::vector<std::pair<const uint8_t*, size_t>> frames;
+    for (size_t offset = 0; offset + 10 < size && frames.size() < BENCH_JPEG_MAX_FRAMES; offset++) {
+        if (memcmp(data + offset, "00dc", 4) != 0) {
+            continue;
+        }
+        uint32_t chunk_size;
+        memcpy(&chunk_size, data + offset + 4, sizeof(chunk_size));
+        const uint8_t* frame = data + offset + 8;
+        if (chunk_size > 2 && offset + 8 + chunk_size <= size && frame[0] == 0xFF && frame[1] == 0xD8) {
+            frames.emplace_back(frame, chunk_size);
+            offset += 8 + chunk_size - 1;
+        }
+    }
+    return frames;
+}
+
+static void JpegSuite(Benchmark& bench) {
+    std::vector<uint8_t> file;
+    const uint8_t* clip = nullptr;
+    size_t clip_size = 0;
+#if CONFIG_USE_ASSET_PARTITION
+    auto mapped = Assets::GetInstance().Get("anim/" BENCH_JPEG_CLIP);
+    clip = (const uint8_t*)mapped.data();
+    clip_size = mapped.size();
+#else
+    // SPIFFS 由 avi_player 在启动时挂载，只读取开头一段
+    FILE* fp = fopen("/spiffs/" BENCH_JPEG_CLIP, "rb");
+    if (fp != nullptr) {
+        file.resize(512 * 1024);
+        file.resize(fread(file.data(), 1, file.size(), fp));
+        fclose(fp);
+        clip = file.data();
+        clip_size = file.size();
+    }
+#endif
+    auto frames = FindJpegFrames(clip, clip_size);
+    if (frames.empty()) {
+        ESP_LOGW(TAG, "No JPEG frames found in %s", BENCH_JPEG_CLIP);
+        return;
+    }
+
+    const int output_size = 240 * 280 * 2;
+    auto output = (uint8_t*)heap_caps_malloc(output_size, MALLOC_CAP_SPIRAM);
+    if (output == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate JPEG output buffer");
+        return;
+    }
+    size_t index = 0;
+    bench.Measure("decode_frame", 30, [&]() {
+        auto& frame = frames[index++ % frames.size()];
+        int out_len = 0;
+        esp_jpeg_decode_to_buffer((uint8_t*)frame.first, frame.second, output, output_size, &out_len);
+        return frame.second;
+    });
+    heap_caps_free(output);
+}
+#endif
+
+// Opus 编解码和 JPEG 解码依赖设备上的组件，主机上只注册通用的测试组
+void Benchmark::RegisterDefaultSuites() {
+    RegisterSuite("resampler", ResamplerSuite);
+    RegisterSuite("aes", AesSuite);
+    RegisterSuite("json", JsonSuite);
+    RegisterSuite("thing", ThingSuite);
+#if !CONFIG_IDF_TARGET_LINUX
+    RegisterSuite("opus", OpusSuite);
+    RegisterSuite("jpeg", JpegSuite);
+#endif
+}
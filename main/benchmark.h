@@ -0,0 +1,49 @@
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 基础操作微基准：各模块注册测试组，设备上由调试控制台 bench 命令（benchmark_console.cc）在独立任务中运行，
+// 不依赖 Opus 和 JPEG 组件的测试组也能在主机上运行（test/host 的 benchmark_host）
+// 每个测量先预热再逐次计时，输出一行 "BENCH {...}" JSON，取中位数，便于脚本收集和对比
+// 输入数据都是固定种子生成的，同一固件多次运行的结果可以直接比较
+class Benchmark {
+public:
+    // 执行一次被测操作，返回本次处理的字节数
+    using Operation = std::function<size_t()>;
+    using Suite = std::function<void(Benchmark& bench)>;
+
+    static Benchmark& GetInstance() {
+        static Benchmark instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    Benchmark(const Benchmark&) = delete;
+    Benchmark& operator=(const Benchmark&) = delete;
+
+    // name 需要在整个运行期间有效，一般是字符串常量
+    void RegisterSuite(const char* name, Suite suite);
+    std::vector<std::string> GetSuiteNames();
+    // 运行指定的测试组，names 为空时运行全部；iterations 为 0 时使用各测量的默认次数
+    void Run(const std::vector<std::string>& names, int iterations = 0);
+    void RegisterDefaultSuites();
+    void RegisterConsoleCommand();
+
+    // 在测试组中调用
+    void Measure(const std::string& name, int iterations, const Operation& operation);
+
+private:
+    Benchmark() = default;
+
+    std::mutex mutex_;
+    std::map<std::string, Suite> suites_;
+    const char* current_suite_ = nullptr;
+    int iterations_override_ = 0;
+};
+
+#endif // _BENCHMARK_H_
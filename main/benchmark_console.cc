@@ -0,0 +1,55 @@
+#include "benchmark.h"
+#include "debug_console.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "Benchmark"
+
+#define BENCH_TASK_STACK_SIZE (4096 * 8)
+
+void Benchmark::RegisterConsoleCommand() {
+    RegisterDefaultSuites();
+    DebugConsole::GetInstance().RegisterCommand("bench",
+        "Run micro-benchmarks: 'bench list', 'bench [-n iterations] [suite...]'",
+        [this](int argc, char** argv) {
+            if (argc > 1 && strcmp(argv[1], "list") == 0) {
+                for (auto& name : GetSuiteNames()) {
+                    printf("%s\n", name.c_str());
+                }
+                return 0;
+            }
+
+            struct Request {
+                Benchmark* bench;
+                std::vector<std::string> names;
+                int iterations = 0;
+                TaskHandle_t caller;
+            } request = {this, {}, 0, xTaskGetCurrentTaskHandle()};
+            for (int i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+                    request.iterations = atoi(argv[++i]);
+                } else {
+                    request.names.push_back(argv[i]);
+                }
+            }
+
+            // Opus 编码需要较大的栈，控制台任务的栈不够，在独立任务中运行并等待结束
+            if (xTaskCreate([](void* arg) {
+                auto request = (Request*)arg;
+                request->bench->Run(request->names, request->iterations);
+                xTaskNotifyGive(request->caller);
+                vTaskDelete(NULL);
+            }, "benchmark", BENCH_TASK_STACK_SIZE, &request, 2, nullptr) != pdPASS) {
+                ESP_LOGE(TAG, "Failed to create benchmark task");
+                return 1;
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            return 0;
+        });
+}
@@ -7,12 +7,19 @@
 #include "config.h"
 #include "iot/thing_manager.h"
 #include "led/single_led.h"
+#include "memory_tracker.h"
 
 #include <esp_log.h>
 #include <esp_lcd_panel_vendor.h>
 #include <driver/i2c_master.h>
 #include <wifi_station.h>
 #include <esp_lcd_nv3007.h>
+#if CONFIG_USE_BENCHMARK
+#include "benchmark.h"
+#include <esp_lvgl_port.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#endif
 
 #define TAG "kevin-sp-v3"
 
@@ -99,12 +106,51 @@ private:
         display_ = new SpiLcdDisplay(panel_io, panel,
                             DISPLAY_WIDTH, DISPLAY_HEIGHT, DISPLAY_OFFSET_X, DISPLAY_OFFSET_Y, DISPLAY_MIRROR_X, DISPLAY_MIRROR_Y, DISPLAY_SWAP_XY,
                             {
+#if CONFIG_USE_FLASH_FONT
+                                // 中文字形从 assets 分区按需加载，固件中只保留西文字体作为回退
+                                .text_font = &lv_font_montserrat_14,
+#else
                                 .text_font = &font_puhui_20_4,
+#endif
                                 .icon_font = &font_awesome_20_4,
                                 .emoji_font = font_emoji_32_init(),
                             });
+#if CONFIG_USE_BENCHMARK
+        RegisterLcdBenchmark(panel_io, panel);
+#endif
     }
 
+#if CONFIG_USE_BENCHMARK
+    // NV3007 整屏推送：按 LVGL 刷新时相同的方式分块 DMA 传输，最后发送一个 NOP 命令，等待所有颜色数据传输完成
+    // 测量期间持有 LVGL 锁，结束后整屏重绘
+    void RegisterLcdBenchmark(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel) {
+        Benchmark::GetInstance().RegisterSuite("lcd", [panel_io, panel](Benchmark& bench) {
+            const int lines = 40;
+            size_t chunk_size = DISPLAY_WIDTH * lines * sizeof(uint16_t);
+            auto chunk = (uint16_t*)heap_caps_malloc(chunk_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            if (chunk == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate LCD benchmark buffer");
+                return;
+            }
+            for (size_t i = 0; i < chunk_size / sizeof(uint16_t); i++) {
+                chunk[i] = i * 0x0841;
+            }
+
+            lvgl_port_lock(0);
+            bench.Measure("full_frame", 20, [&]() {
+                for (int y = 0; y < DISPLAY_HEIGHT; y += lines) {
+                    esp_lcd_panel_draw_bitmap(panel, 0, y, DISPLAY_WIDTH, std::min(y + lines, DISPLAY_HEIGHT), chunk);
+                }
+                esp_lcd_panel_io_tx_param(panel_io, 0x00, nullptr, 0);
+                return (size_t)DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(uint16_t);
+            });
+            lv_obj_invalidate(lv_screen_active());
+            lvgl_port_unlock();
+            heap_caps_free(chunk);
+        });
+    }
+#endif
+
     // 物联网初始化，添加对 AI 可见设备
     void InitializeIot() {
         auto& thing_manager = iot::ThingManager::GetInstance();
@@ -119,8 +165,15 @@ public:
         InitializeCodecI2c();
         InitializeSpi();
         InitializeButtons();
-        InitializeSt7789Display();  
-        InitializeIot();
+        // 只统计屏幕和设备初始化的开销，运行期 LVGL 的分配不计入
+        {
+            MemoryScope scope(kMemoryTagUi);
+            InitializeSt7789Display();
+        }
+        {
+            MemoryScope scope(kMemoryTagIot);
+            InitializeIot();
+        }
         GetBacklight()->RestoreBrightness();
     }
     
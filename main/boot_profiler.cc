@@ -0,0 +1,103 @@
+#include "boot_profiler.h"
+#include "debug_console.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cJSON.h>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "BootProfiler"
+
+void BootProfiler::Begin(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phases_.push_back({name, esp_timer_get_time(), 0, (int)xPortGetCoreID()});
+}
+
+void BootProfiler::End(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(phases_.rbegin(), phases_.rend(), [name](const Phase& phase) {
+        return phase.end_us == 0 && strcmp(phase.name, name) == 0;
+    });
+    if (it == phases_.rend()) {
+        ESP_LOGW(TAG, "Phase %s ended without begin", name);
+        return;
+    }
+    it->end_us = esp_timer_get_time();
+}
+
+void BootProfiler::MarkReady() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ready_us_ != 0) {
+            return;
+        }
+        ready_us_ = esp_timer_get_time();
+    }
+    ESP_LOGI(TAG, "Ready for interaction %lld ms after power on", ready_us_ / 1000);
+    PrintReport();
+}
+
+std::string BootProfiler::GetReportJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "ready_ms", ready_us_ / 1000.0);
+
+    cJSON* phases = cJSON_CreateArray();
+    for (auto& phase : phases_) {
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", phase.name);
+        cJSON_AddNumberToObject(item, "start_ms", phase.start_us / 1000.0);
+        if (phase.end_us != 0) {
+            cJSON_AddNumberToObject(item, "duration_ms", (phase.end_us - phase.start_us) / 1000.0);
+        }
+        cJSON_AddNumberToObject(item, "core", phase.core);
+        cJSON_AddItemToArray(phases, item);
+    }
+    cJSON_AddItemToObject(root, "phases", phases);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
+void BootProfiler::PrintReport() {
+    std::vector<Phase> phases;
+    int64_t ready_us;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        phases = phases_;
+        ready_us = ready_us_;
+    }
+
+    printf("| Phase            | Core | Start ms | Duration ms\n");
+    for (auto& phase : phases) {
+        if (phase.end_us == 0) {
+            printf("| %-16s | %4d | %8lld | running\n", phase.name, phase.core, phase.start_us / 1000);
+        } else {
+            printf("| %-16s | %4d | %8lld | %8lld\n", phase.name, phase.core, phase.start_us / 1000,
+                (phase.end_us - phase.start_us) / 1000);
+        }
+    }
+    if (ready_us != 0) {
+        printf("Ready: %lld ms\n", ready_us / 1000);
+    }
+}
+
+void BootProfiler::RegisterConsoleCommand() {
+    DebugConsole::GetInstance().RegisterCommand("boot", "Print startup phase timings, 'boot json' for JSON",
+        [this](int argc, char** argv) {
+            if (argc > 1 && strcmp(argv[1], "json") == 0) {
+                printf("%s\n", GetReportJson().c_str());
+            } else {
+                PrintReport();
+            }
+            return 0;
+        });
+}
@@ -0,0 +1,55 @@
+#ifndef _BOOT_PROFILER_H_
+#define _BOOT_PROFILER_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 记录启动各阶段的起止时间（自上电起的微秒数），设备第一次进入待机时输出启动报告
+class BootProfiler {
+public:
+    static BootProfiler& GetInstance() {
+        static BootProfiler instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    BootProfiler(const BootProfiler&) = delete;
+    BootProfiler& operator=(const BootProfiler&) = delete;
+
+    // name 需要在整个运行期间有效，一般是字符串常量
+    void Begin(const char* name);
+    void End(const char* name);
+    // 可以交互的时刻，只记录第一次
+    void MarkReady();
+
+    std::string GetReportJson();
+    void PrintReport();
+    void RegisterConsoleCommand();
+
+private:
+    BootProfiler() = default;
+
+    struct Phase {
+        const char* name;
+        int64_t start_us;
+        int64_t end_us;
+        int core;
+    };
+
+    std::mutex mutex_;
+    std::vector<Phase> phases_;
+    int64_t ready_us_ = 0;
+};
+
+// 在作用域内记录一个启动阶段
+class BootPhase {
+public:
+    BootPhase(const char* name) : name_(name) { BootProfiler::GetInstance().Begin(name_); }
+    ~BootPhase() { BootProfiler::GetInstance().End(name_); }
+
+private:
+    const char* name_;
+};
+
+#endif // _BOOT_PROFILER_H_
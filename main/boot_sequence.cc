@@ -0,0 +1,90 @@
+#include "boot_sequence.h"
+#include "boot_profiler.h"
+
+#include <esp_log.h>
+#include <freertos/task.h>
+
+#include <cstring>
+
+#define TAG "BootSequence"
+
+// EventGroup 可用的位数
+#define BOOT_SEQUENCE_MAX_PHASES 24
+
+BootSequence::BootSequence() {
+    event_group_ = xEventGroupCreate();
+}
+
+BootSequence::~BootSequence() {
+    vEventGroupDelete(event_group_);
+}
+
+void BootSequence::AddPhase(const char* name, std::initializer_list<const char*> depends_on,
+    std::function<void()> action, uint32_t stack_size) {
+    if (phases_.size() >= BOOT_SEQUENCE_MAX_PHASES) {
+        ESP_LOGE(TAG, "Too many boot phases");
+        abort();
+    }
+
+    // 依赖只能指向已经添加的阶段，这样就不会出现循环依赖
+    EventBits_t bits = 0;
+    for (auto dependency : depends_on) {
+        size_t i = 0;
+        while (i < phases_.size() && strcmp(phases_[i].name, dependency) != 0) {
+            i++;
+        }
+        if (i == phases_.size()) {
+            ESP_LOGE(TAG, "Phase %s depends on unknown phase %s", name, dependency);
+            abort();
+        }
+        bits |= (EventBits_t)1 << i;
+    }
+    phases_.push_back({name, bits, std::move(action), stack_size});
+}
+
+void BootSequence::RunPhase(size_t index) {
+    auto& phase = phases_[index];
+    if (phase.depends_on != 0) {
+        xEventGroupWaitBits(event_group_, phase.depends_on, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    {
+        BootPhase profile(phase.name);
+        phase.action();
+    }
+    xEventGroupSetBits(event_group_, (EventBits_t)1 << index);
+}
+
+void BootSequence::Run() {
+    struct TaskArgs {
+        BootSequence* sequence;
+        size_t index;
+    };
+
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    for (size_t i = 0; i < phases_.size(); i++) {
+        if (phases_[i].stack_size == 0) {
+            continue;
+        }
+        auto args = new TaskArgs{this, i};
+        if (xTaskCreate([](void* arg) {
+            auto args = (TaskArgs*)arg;
+            args->sequence->RunPhase(args->index);
+            delete args;
+            vTaskDelete(NULL);
+        }, phases_[i].name, phases_[i].stack_size, args, priority, nullptr) != pdPASS) {
+            // 创建任务失败时退回到当前任务中执行
+            ESP_LOGW(TAG, "Failed to create task for phase %s, running inline", phases_[i].name);
+            delete args;
+            phases_[i].stack_size = 0;
+        }
+    }
+
+    for (size_t i = 0; i < phases_.size(); i++) {
+        if (phases_[i].stack_size == 0) {
+            RunPhase(i);
+        }
+    }
+
+    EventBits_t all = ((EventBits_t)1 << phases_.size()) - 1;
+    xEventGroupWaitBits(event_group_, all, pdFALSE, pdTRUE, portMAX_DELAY);
+}
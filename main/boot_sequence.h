@@ -0,0 +1,37 @@
+#ifndef _BOOT_SEQUENCE_H_
+#define _BOOT_SEQUENCE_H_
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+// 按依赖关系执行启动阶段，互不依赖的阶段在各自的任务中并行执行，每个阶段都记录到 BootProfiler
+class BootSequence {
+public:
+    BootSequence();
+    ~BootSequence();
+
+    // 依赖的阶段全部完成后才开始执行，stack_size 为 0 时在调用 Run 的任务中按添加顺序执行
+    void AddPhase(const char* name, std::initializer_list<const char*> depends_on, std::function<void()> action,
+        uint32_t stack_size = 0);
+    // 阻塞直到全部阶段完成
+    void Run();
+
+private:
+    struct Phase {
+        const char* name;
+        EventBits_t depends_on;
+        std::function<void()> action;
+        uint32_t stack_size;
+    };
+
+    EventGroupHandle_t event_group_;
+    std::vector<Phase> phases_;
+
+    void RunPhase(size_t index);
+};
+
+#endif // _BOOT_SEQUENCE_H_
@@ -0,0 +1,77 @@
+#include "debug_console.h"
+
+#include <esp_log.h>
+
+#define TAG "DebugConsole"
+
+void DebugConsole::Start() {
+    if (repl_ != nullptr) {
+        return;
+    }
+
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "xiaozhi>";
+    repl_config.task_stack_size = 4096;
+    repl_config.task_priority = 1;
+
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if defined(CONFIG_ESP_CONSOLE_UART_DEFAULT) || defined(CONFIG_ESP_CONSOLE_UART_CUSTOM)
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl_);
+#elif defined(CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG)
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl_);
+#elif defined(CONFIG_ESP_CONSOLE_USB_CDC)
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &repl_);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create console: %s", esp_err_to_name(err));
+        repl_ = nullptr;
+        return;
+    }
+
+    esp_console_register_help_command();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [name, command] : commands_) {
+            Register(name.c_str(), command.help);
+        }
+    }
+    ESP_ERROR_CHECK(esp_console_start_repl(repl_));
+    ESP_LOGI(TAG, "Debug console started, type 'help' for commands");
+}
+
+void DebugConsole::RegisterCommand(const char* name, const char* help, Handler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& command = commands_[name];
+    command.help = help;
+    command.handler = std::move(handler);
+    // 控制台启动前注册的命令在 Start 中统一注册
+    if (repl_ != nullptr) {
+        Register(name, help);
+    }
+}
+
+// esp_console 只接受函数指针，统一由 Dispatch 按 argv[0] 查找处理函数
+void DebugConsole::Register(const char* name, const char* help) {
+    esp_console_cmd_t command = {};
+    command.command = name;
+    command.help = help;
+    command.func = &DebugConsole::Dispatch;
+    ESP_ERROR_CHECK(esp_console_cmd_register(&command));
+}
+
+int DebugConsole::Dispatch(int argc, char** argv) {
+    auto& self = GetInstance();
+    Handler handler;
+    {
+        std::lock_guard<std::mutex> lock(self.mutex_);
+        auto it = self.commands_.find(argv[0]);
+        if (it == self.commands_.end()) {
+            return 1;
+        }
+        handler = it->second.handler;
+    }
+    return handler(argc, argv);
+}
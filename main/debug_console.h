@@ -0,0 +1,44 @@
+#ifndef _DEBUG_CONSOLE_H_
+#define _DEBUG_CONSOLE_H_
+
+#include <esp_console.h>
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+// 串口调试控制台，各模块注册自己的诊断命令，例如 mem / tasks
+class DebugConsole {
+public:
+    using Handler = std::function<int(int argc, char** argv)>;
+
+    static DebugConsole& GetInstance() {
+        static DebugConsole instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    DebugConsole(const DebugConsole&) = delete;
+    DebugConsole& operator=(const DebugConsole&) = delete;
+
+    void Start();
+    // 在 Start 之前或之后注册都可以，help 字符串需要在整个运行期间有效
+    void RegisterCommand(const char* name, const char* help, Handler handler);
+
+private:
+    DebugConsole() = default;
+
+    struct Command {
+        const char* help;
+        Handler handler;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Command> commands_;
+    esp_console_repl_t* repl_ = nullptr;
+
+    static void Register(const char* name, const char* help);
+    static int Dispatch(int argc, char** argv);
+};
+
+#endif // _DEBUG_CONSOLE_H_
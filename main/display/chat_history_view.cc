@@ -0,0 +1,233 @@
+#include "chat_history_view.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "ChatHistoryView"
+
+#define CHAT_BUBBLE_PADDING 8
+#define CHAT_BUBBLE_BORDER 1
+#define CHAT_BUBBLE_MIN_TEXT_WIDTH 20
+#define CHAT_MESSAGE_GAP 10
+
+void ChatHistoryView::Initialize(lv_obj_t* parent, const lv_font_t* font, const Style& style) {
+    parent_ = parent;
+    font_ = font;
+    style_ = style;
+
+    // 绑定范围是可见区域加上下各半屏，共两屏高；内容区域不超过屏幕高度，每条消息至少一行，
+    // 按此分配的气泡足够绑定范围内所有的消息，两端各加一个给被边界截断的消息
+    int32_t min_bubble_height = lv_font_get_line_height(font_) + 2 * (CHAT_BUBBLE_PADDING + CHAT_BUBBLE_BORDER)
+        + CHAT_MESSAGE_GAP;
+    slots_.resize(2 * LV_VER_RES / min_bubble_height + 2);
+    ESP_LOGI(TAG, "Bubble pool size %d", (int)slots_.size());
+
+    // 撑开滚动范围的占位对象，放在最后一条消息的底部
+    spacer_ = lv_obj_create(parent_);
+    lv_obj_remove_style_all(spacer_);
+    lv_obj_set_size(spacer_, 1, 1);
+    lv_obj_remove_flag(spacer_, LV_OBJ_FLAG_CLICKABLE);
+
+    for (auto& slot : slots_) {
+        slot.seq = kUnbound;
+        slot.bubble = lv_obj_create(parent_);
+        lv_obj_set_style_radius(slot.bubble, 8, 0);
+        lv_obj_set_scrollbar_mode(slot.bubble, LV_SCROLLBAR_MODE_OFF);
+        lv_obj_remove_flag(slot.bubble, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_style_border_width(slot.bubble, CHAT_BUBBLE_BORDER, 0);
+        lv_obj_set_style_pad_all(slot.bubble, CHAT_BUBBLE_PADDING, 0);
+
+        slot.label = lv_label_create(slot.bubble);
+        lv_label_set_long_mode(slot.label, LV_LABEL_LONG_WRAP);
+        lv_obj_set_style_text_font(slot.label, font_, 0);
+        lv_obj_add_flag(slot.bubble, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    lv_obj_add_event_cb(parent_, [](lv_event_t* e) {
+        auto view = static_cast<ChatHistoryView*>(lv_event_get_user_data(e));
+        view->Relayout();
+    }, LV_EVENT_SCROLL, this);
+}
+
+void ChatHistoryView::SetStyle(const Style& style) {
+    style_ = style;
+    for (auto& slot : slots_) {
+        if (slot.seq != kUnbound) {
+            ApplyStyle(slot);
+        }
+    }
+}
+
+// 每条消息只测量一次，之后的滚动和回收直接使用缓存的尺寸
+void ChatHistoryView::Measure(Entry& entry) {
+    int32_t max_width = LV_HOR_RES * 85 / 100 - 16;
+    int32_t text_width = lv_text_get_width(entry.text.c_str(), entry.text.size(), font_, 0);
+    text_width = std::clamp<int32_t>(text_width, CHAT_BUBBLE_MIN_TEXT_WIDTH, max_width);
+
+    lv_point_t size;
+    lv_text_get_size(&size, entry.text.c_str(), font_, 0, 0, text_width, LV_TEXT_FLAG_NONE);
+    entry.width = text_width;
+    entry.height = size.y;
+}
+
+void ChatHistoryView::AddMessage(const char* role, const char* content) {
+    if (parent_ == nullptr || strlen(content) == 0) {
+        return;
+    }
+
+    Entry entry;
+    entry.text = content;
+    if (strcmp(role, "user") == 0) {
+        entry.role = kRoleUser;
+    } else if (strcmp(role, "system") == 0) {
+        entry.role = kRoleSystem;
+    } else {
+        entry.role = kRoleAssistant;
+    }
+    Measure(entry);
+    entry.y = entries_.empty() ? base_y_ : base_y_ + Bottom(entries_.back()) + CHAT_MESSAGE_GAP;
+    entries_.push_back(std::move(entry));
+
+    // 丢弃最早的消息后剩余消息整体上移，滚动位置同步上移，画面不跳动
+    int32_t removed = 0;
+    while (entries_.size() > CHAT_HISTORY_CAPACITY) {
+        entries_.pop_front();
+        first_seq_++;
+        removed += entries_.front().y - base_y_;
+        base_y_ = entries_.front().y;
+    }
+
+    int32_t total_height = Bottom(entries_.back());
+    lv_obj_set_pos(spacer_, 0, total_height - 1);
+    lv_obj_update_layout(parent_);
+    if (removed > 0) {
+        lv_obj_scroll_by(parent_, 0, removed, LV_ANIM_OFF);
+    }
+    Relayout();
+
+    int32_t scroll_y = std::max<int32_t>(0, total_height - lv_obj_get_content_height(parent_));
+    lv_obj_scroll_to_y(parent_, scroll_y, LV_ANIM_ON);
+}
+
+int32_t ChatHistoryView::Top(const Entry& entry) const {
+    return entry.y - base_y_;
+}
+
+int32_t ChatHistoryView::Bottom(const Entry& entry) const {
+    return entry.y - base_y_ + entry.height + 2 * (CHAT_BUBBLE_PADDING + CHAT_BUBBLE_BORDER);
+}
+
+// 只给可见区域及其上下各半屏内的消息绑定气泡，离开范围的气泡回收。
+// 先绑定可见的消息，再向上下两侧交替扩展，气泡不够时被舍弃的总是离可见区域最远的消息
+void ChatHistoryView::Relayout() {
+    int32_t view_top = lv_obj_get_scroll_y(parent_);
+    int32_t view_height = lv_obj_get_content_height(parent_);
+    int32_t view_bottom = view_top + view_height;
+
+    // 与 [top, bottom] 相交的消息的下标范围
+    auto find_range = [this](int32_t top, int32_t bottom, size_t& begin, size_t& end) {
+        begin = std::partition_point(entries_.begin(), entries_.end(), [this, top](const Entry& entry) {
+            return Bottom(entry) < top;
+        }) - entries_.begin();
+        end = std::partition_point(entries_.begin(), entries_.end(), [this, bottom](const Entry& entry) {
+            return Top(entry) <= bottom;
+        }) - entries_.begin();
+        end = std::max(begin, end);
+    };
+    size_t window_begin, window_end, begin, end;
+    find_range(view_top - view_height / 2, view_bottom + view_height / 2, window_begin, window_end);
+    find_range(view_top, view_bottom, begin, end);
+
+    // 可见的消息本身超过气泡数时保留最新的
+    size_t pool_size = slots_.size();
+    if (end - begin > pool_size) {
+        begin = end - pool_size;
+    }
+    while (end - begin < pool_size && (begin > window_begin || end < window_end)) {
+        if (end < window_end) {
+            end++;
+        }
+        if (end - begin < pool_size && begin > window_begin) {
+            begin--;
+        }
+    }
+
+    // 只在进入气泡不足的状态时打印一次，避免每个滚动事件都打印
+    bool exhausted = begin > window_begin || end < window_end;
+    if (exhausted && !pool_exhausted_) {
+        ESP_LOGW(TAG, "Bubble pool exhausted, %d messages in range not shown",
+            (int)((begin - window_begin) + (window_end - end)));
+    }
+    pool_exhausted_ = exhausted;
+
+    uint32_t begin_seq = first_seq_ + begin;
+    uint32_t end_seq = first_seq_ + end;
+    for (auto& slot : slots_) {
+        if (slot.seq == kUnbound) {
+            continue;
+        }
+        if (slot.seq < begin_seq || slot.seq >= end_seq) {
+            slot.seq = kUnbound;
+            lv_obj_add_flag(slot.bubble, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            // 丢弃旧消息后位置会整体变化
+            PlaceSlot(slot);
+        }
+    }
+
+    for (uint32_t seq = begin_seq; seq < end_seq; seq++) {
+        bool bound = std::any_of(slots_.begin(), slots_.end(), [seq](const Slot& slot) {
+            return slot.seq == seq;
+        });
+        if (bound) {
+            continue;
+        }
+        auto free_slot = std::find_if(slots_.begin(), slots_.end(), [](const Slot& slot) {
+            return slot.seq == kUnbound;
+        });
+        if (free_slot == slots_.end()) {
+            break;
+        }
+        Bind(*free_slot, seq);
+    }
+}
+
+void ChatHistoryView::Bind(Slot& slot, uint32_t seq) {
+    auto& entry = entries_[seq - first_seq_];
+    slot.seq = seq;
+    lv_label_set_text(slot.label, entry.text.c_str());
+    lv_obj_set_size(slot.label, entry.width, entry.height);
+    lv_obj_set_size(slot.bubble, entry.width + 2 * (CHAT_BUBBLE_PADDING + CHAT_BUBBLE_BORDER),
+        entry.height + 2 * (CHAT_BUBBLE_PADDING + CHAT_BUBBLE_BORDER));
+    ApplyStyle(slot);
+    PlaceSlot(slot);
+    lv_obj_remove_flag(slot.bubble, LV_OBJ_FLAG_HIDDEN);
+}
+
+void ChatHistoryView::PlaceSlot(Slot& slot) {
+    auto& entry = entries_[slot.seq - first_seq_];
+    int32_t bubble_width = entry.width + 2 * (CHAT_BUBBLE_PADDING + CHAT_BUBBLE_BORDER);
+    int32_t content_width = lv_obj_get_content_width(parent_);
+    int32_t x = 0;
+    if (entry.role == kRoleUser) {
+        x = content_width - bubble_width;
+    } else if (entry.role == kRoleSystem) {
+        x = (content_width - bubble_width) / 2;
+    }
+    lv_obj_set_pos(slot.bubble, x, Top(entry));
+}
+
+void ChatHistoryView::ApplyStyle(Slot& slot) {
+    auto role = entries_[slot.seq - first_seq_].role;
+    lv_color_t bubble_color = style_.assistant_bubble;
+    if (role == kRoleUser) {
+        bubble_color = style_.user_bubble;
+    } else if (role == kRoleSystem) {
+        bubble_color = style_.system_bubble;
+    }
+    lv_obj_set_style_bg_color(slot.bubble, bubble_color, 0);
+    lv_obj_set_style_border_color(slot.bubble, style_.border, 0);
+    lv_obj_set_style_text_color(slot.label, role == kRoleSystem ? style_.system_text : style_.text, 0);
+}
@@ -0,0 +1,78 @@
+#ifndef CHAT_HISTORY_VIEW_H
+#define CHAT_HISTORY_VIEW_H
+
+#include <lvgl.h>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// 保留的历史消息条数，超出后丢弃最早的消息
+#define CHAT_HISTORY_CAPACITY 50
+
+// 微信风格的聊天记录列表：历史消息只保存文本和测量好的尺寸，
+// 固定数量的气泡控件只绑定到可见区域及其上下各半屏内的消息，滚动时回收复用，消息再多控件数和布局开销也不变
+class ChatHistoryView {
+public:
+    struct Style {
+        lv_color_t user_bubble;
+        lv_color_t assistant_bubble;
+        lv_color_t system_bubble;
+        lv_color_t text;
+        lv_color_t system_text;
+        lv_color_t border;
+    };
+
+    // parent 为可滚动的聊天区域，需要持有 LVGL 锁
+    void Initialize(lv_obj_t* parent, const lv_font_t* font, const Style& style);
+    void SetStyle(const Style& style);
+    void AddMessage(const char* role, const char* content);
+
+private:
+    enum Role : uint8_t {
+        kRoleUser,
+        kRoleAssistant,
+        kRoleSystem,
+    };
+
+    struct Entry {
+        std::string text;
+        Role role;
+        int16_t width;
+        int16_t height;
+        // 相对于 base_y_ 的纵向位置
+        int32_t y;
+    };
+
+    struct Slot {
+        lv_obj_t* bubble = nullptr;
+        lv_obj_t* label = nullptr;
+        // 绑定的消息序号，kUnbound 表示空闲
+        uint32_t seq;
+    };
+
+    static constexpr uint32_t kUnbound = UINT32_MAX;
+
+    lv_obj_t* parent_ = nullptr;
+    lv_obj_t* spacer_ = nullptr;
+    const lv_font_t* font_ = nullptr;
+    Style style_;
+    std::deque<Entry> entries_;
+    // entries_ 第一条消息的序号
+    uint32_t first_seq_ = 0;
+    int32_t base_y_ = 0;
+    // 按屏幕高度和单行气泡的高度在 Initialize 中分配，能覆盖两屏高的绑定范围
+    std::vector<Slot> slots_;
+    bool pool_exhausted_ = false;
+
+    void Measure(Entry& entry);
+    int32_t Top(const Entry& entry) const;
+    int32_t Bottom(const Entry& entry) const;
+    void Relayout();
+    void Bind(Slot& slot, uint32_t seq);
+    void PlaceSlot(Slot& slot);
+    void ApplyStyle(Slot& slot);
+};
+
+#endif // CHAT_HISTORY_VIEW_H
@@ -1,6 +1,7 @@
 #include <esp_log.h>
 #include <esp_err.h>
 #include <string>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -11,9 +12,31 @@
 #include "audio_codec.h"
 #include "settings.h"
 #include "assets/lang_config.h"
+#if CONFIG_USE_FLASH_FONT
+#include "assets.h"
+#endif
 
 #define TAG "Display"
 
+// 微信风格下聊天消息不合并，队列最多积压的消息数
+#define UI_MAX_PENDING_MESSAGES 32
+
+// 作用在同一个控件上的消息只保留最新的一条；微信风格下每条聊天消息都是新的气泡，不能合并
+static int GetUiMessageSlot(UiMessageType type) {
+    switch (type) {
+    case kUiMessageIcon:
+        return kUiMessageEmotion;
+    case kUiMessageHideNotification:
+        return kUiMessageNotification;
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    case kUiMessageChat:
+        return -1;
+#endif
+    default:
+        return type;
+    }
+}
+
 Display::Display() {
     // Load theme from settings
     Settings settings("display", false);
@@ -23,9 +46,7 @@ Display::Display() {
     esp_timer_create_args_t notification_timer_args = {
         .callback = [](void *arg) {
             Display *display = static_cast<Display*>(arg);
-            DisplayLockGuard lock(display);
-            lv_obj_add_flag(display->notification_label_, LV_OBJ_FLAG_HIDDEN);
-            lv_obj_clear_flag(display->status_label_, LV_OBJ_FLAG_HIDDEN);
+            display->HideNotification();
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -66,6 +87,9 @@ Display::~Display() {
         esp_timer_stop(update_timer_);
         esp_timer_delete(update_timer_);
     }
+    if (ui_timer_ != nullptr) {
+        lv_timer_delete(ui_timer_);
+    }
 
     if (network_label_ != nullptr) {
         lv_obj_del(network_label_);
@@ -81,7 +105,128 @@ Display::~Display() {
     }
 }
 
+void Display::InitializeRendering() {
+    DisplayLockGuard lock(this);
+    render_scheduler_.Attach(display_);
+
+    // 队列定时器平时不会到期，有消息时由投递方设为就绪并唤醒 LVGL 任务；刷新结束时再检查一次，处理刷新期间投递的消息
+    ui_timer_ = lv_timer_create([](lv_timer_t* timer) {
+        auto display = static_cast<Display*>(lv_timer_get_user_data(timer));
+        display->DrainUiMessages();
+    }, RENDER_MAX_SLEEP_MS, this);
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto display = static_cast<Display*>(lv_event_get_user_data(e));
+        if (display->ui_drain_requested_) {
+            lv_timer_ready(display->ui_timer_);
+        }
+    }, LV_EVENT_REFR_READY, this);
+}
+
+bool Display::PostUiMessage(UiMessage&& message) {
+    if (ui_timer_ == nullptr || xTaskGetCurrentTaskHandle() == ui_task_) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ui_mutex_);
+        int slot = GetUiMessageSlot(message.type);
+        if (slot >= 0) {
+            ui_messages_.remove_if([slot](const UiMessage& pending) {
+                return GetUiMessageSlot(pending.type) == slot;
+            });
+        }
+        if (message.type == kUiMessageFaceImage) {
+            face_image_pending_ = true;
+        }
+        ui_messages_.push_back(std::move(message));
+        if (ui_messages_.size() > UI_MAX_PENDING_MESSAGES) {
+            // 视频帧已经按槽位合并成最新一帧，不能丢弃：丢掉后 face_image_pending_ 不会被清除，播放器会一直跳帧
+            auto oldest = std::find_if(ui_messages_.begin(), ui_messages_.end(), [](const UiMessage& pending) {
+                return pending.type != kUiMessageFaceImage;
+            });
+            ui_messages_.erase(oldest);
+        }
+    }
+
+    if (!ui_drain_requested_.exchange(true)) {
+        // 只尝试加锁，不等待（1ms 不足一个 tick）
+        if (Lock(1)) {
+            lv_timer_ready(ui_timer_);
+            Unlock();
+        } else {
+            // 锁被 LVGL 任务或其他任务占用，之后不一定有刷新。lv_timer_ready 只改写定时器的 last_run，
+            // 与 LVGL 任务并发时最坏是队列定时器多运行一次，DrainUiMessages 检查 ui_drain_requested_ 后空返回
+            lv_timer_ready(ui_timer_);
+        }
+    }
+    // 每次投递都唤醒：LVGL 任务可能已经算好了睡眠时间，不唤醒要等到 RENDER_MAX_SLEEP_MS 才会处理
+    render_scheduler_.Wake();
+    return true;
+}
+
+// 在 LVGL 任务中运行，已经持有 LVGL 锁
+void Display::DrainUiMessages() {
+    ui_task_ = xTaskGetCurrentTaskHandle();
+    if (!ui_drain_requested_.exchange(false)) {
+        return;
+    }
+
+    std::list<UiMessage> messages;
+    {
+        std::lock_guard<std::mutex> lock(ui_mutex_);
+        messages.swap(ui_messages_);
+    }
+    for (auto& message : messages) {
+        ApplyUiMessage(message);
+    }
+}
+
+void Display::ApplyUiMessage(const UiMessage& message) {
+    switch (message.type) {
+    case kUiMessageStatus:
+        SetStatus(message.text.c_str());
+        break;
+    case kUiMessageNotification:
+        ShowNotification(message.text.c_str(), message.duration_ms);
+        break;
+    case kUiMessageHideNotification:
+        HideNotification();
+        break;
+    case kUiMessageEmotion:
+        SetEmotion(message.text.c_str());
+        break;
+    case kUiMessageIcon:
+        SetIcon(message.text.c_str());
+        break;
+    case kUiMessageChat:
+#if CONFIG_USE_FLASH_FONT
+        // 整句的字形先展开进缓存，渲染时不再逐字读取 flash
+        if (flash_font_ != nullptr) {
+            flash_font_->Prewarm(message.text.c_str());
+        }
+#endif
+        SetChatMessage(message.role.c_str(), message.text.c_str());
+        break;
+    case kUiMessagePosture:
+        SetSittingPostureText(message.text.c_str());
+        break;
+    case kUiMessageHand:
+        SetSittingHandText(message.text.c_str());
+        break;
+    case kUiMessageFaceImage:
+        SetFaceImage(message.image, message.width, message.height);
+        face_image_pending_ = false;
+        break;
+    case kUiMessageFrameRate:
+        SetFrameRate(message.fps);
+        break;
+    }
+}
+
 void Display::SetStatus(const char* status) {
+    if (PostUiMessage({kUiMessageStatus, status})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (status_label_ == nullptr) {
         return;
@@ -96,6 +241,9 @@ void Display::ShowNotification(const std::string &notification, int duration_ms)
 }
 
 void Display::ShowNotification(const char* notification, int duration_ms) {
+    if (PostUiMessage({kUiMessageNotification, notification, "", duration_ms})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (notification_label_ == nullptr) {
         return;
@@ -108,6 +256,18 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
 }
 
+void Display::HideNotification() {
+    if (PostUiMessage({kUiMessageHideNotification})) {
+        return;
+    }
+    DisplayLockGuard lock(this);
+    if (notification_label_ == nullptr) {
+        return;
+    }
+    lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+}
+
 void Display::Update() {
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
@@ -158,7 +318,7 @@ void Display::Update() {
                 if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
                     lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
                     auto& app = Application::GetInstance();
-                    app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
+                    app.PlaySound(Lang::Sounds::P3_LOW_BATTERY, kAudioStreamNotification);
                 }
             } else {
                 // Hide the low battery popup when the battery is not empty
@@ -220,6 +380,10 @@ void Display::SetEmotion(const char* emotion) {
         {FONT_AWESOME_EMOJI_CONFUSED, "confused"}
     };
     
+    if (PostUiMessage({kUiMessageEmotion, emotion})) {
+        return;
+    }
+
     // 查找匹配的表情
     std::string_view emotion_view(emotion);
     auto it = std::find_if(emotions.begin(), emotions.end(),
@@ -239,6 +403,9 @@ void Display::SetEmotion(const char* emotion) {
 }
 
 void Display::SetIcon(const char* icon) {
+    if (PostUiMessage({kUiMessageIcon, icon})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
@@ -247,6 +414,9 @@ void Display::SetIcon(const char* icon) {
 }
 
 void Display::SetChatMessage(const char* role, const char* content) {
+    if (PostUiMessage({kUiMessageChat, content, role})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -258,6 +428,31 @@ void Display::SetChatMessage(const char* role, const char* content) {
 void Display::SetFaceImage(uint8_t* frame_buffer, int width, int height) {
     DisplayLockGuard lock(this);
 }
+
+void Display::SetFrameRate(int fps) {
+    UiMessage message = {kUiMessageFrameRate};
+    message.fps = fps;
+    if (PostUiMessage(std::move(message))) {
+        return;
+    }
+    DisplayLockGuard lock(this);
+    render_scheduler_.SetFrameRate(fps);
+}
+
+const lv_font_t* Display::LoadTextFont(const lv_font_t* builtin_font) {
+#if CONFIG_USE_FLASH_FONT
+    auto data = Assets::GetInstance().Get(CONFIG_FLASH_FONT_ASSET_NAME);
+    if (!data.empty()) {
+        flash_font_ = FlashFont::Create(data, builtin_font, CONFIG_FLASH_FONT_CACHE_KB * 1024);
+        if (flash_font_ != nullptr) {
+            return flash_font_->font();
+        }
+    } else {
+        ESP_LOGW(TAG, "Font %s not found in assets, using builtin font", CONFIG_FLASH_FONT_ASSET_NAME);
+    }
+#endif
+    return builtin_font;
+}
     
 void Display::SetTheme(const std::string& theme_name) {
     current_theme_name_ = theme_name;
@@ -265,6 +460,9 @@ void Display::SetTheme(const std::string& theme_name) {
     settings.SetString("theme", theme_name);
 }
 void Display::SetSittingHandText(const char* postureText) {
+    if (PostUiMessage({kUiMessageHand, postureText})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (hand_label_ == nullptr) {
         return;
@@ -273,6 +471,9 @@ void Display::SetSittingHandText(const char* postureText) {
     lv_label_set_text(hand_label_, postureText);
 }
 void Display::SetSittingPostureText(const char* postureText) {
+    if (PostUiMessage({kUiMessagePosture, postureText})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (sit_label_ == nullptr) {
         return;
@@ -5,8 +5,43 @@
 #include <esp_timer.h>
 #include <esp_log.h>
 #include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include <string>
+#include <list>
+#include <mutex>
+#include <atomic>
+
+#include "render_scheduler.h"
+#if CONFIG_USE_FLASH_FONT
+#include "flash_font.h"
+#endif
+
+enum UiMessageType {
+    kUiMessageStatus,
+    kUiMessageNotification,
+    kUiMessageHideNotification,
+    kUiMessageEmotion,
+    kUiMessageIcon,
+    kUiMessageChat,
+    kUiMessagePosture,
+    kUiMessageHand,
+    kUiMessageFaceImage,
+    kUiMessageFrameRate,
+};
+
+// 其他任务投递给 LVGL 任务的一次界面修改
+struct UiMessage {
+    UiMessageType type;
+    std::string text;
+    std::string role;
+    int duration_ms = 0;
+    uint8_t* image = nullptr;
+    int width = 0;
+    int height = 0;
+    int fps = 0;
+};
 
 struct DisplayFonts {
     const lv_font_t* text_font = nullptr;
@@ -26,6 +61,10 @@ public:
     virtual void SetChatMessage(const char* role, const char* content);
     virtual void SetIcon(const char* icon);
     virtual void SetFaceImage(uint8_t* frame_buffer, int width, int height);
+    // 视频播放时按视频帧率刷新，0 恢复默认刷新周期；和其他界面修改一样投递给 LVGL 任务，不等待锁
+    virtual void SetFrameRate(int fps);
+    // 上一帧还在队列中没有显示
+    bool IsFaceImagePending() const { return face_image_pending_; }
 
     virtual void SetTheme(const std::string& theme_name);
     virtual std::string GetTheme() { return current_theme_name_; }
@@ -41,6 +80,7 @@ protected:
     
     esp_pm_lock_handle_t pm_lock_ = nullptr;
     lv_display_t *display_ = nullptr;
+    RenderScheduler render_scheduler_;
 
     lv_obj_t *emotion_label_ = nullptr;
     lv_obj_t *network_label_ = nullptr;
@@ -62,6 +102,27 @@ protected:
     esp_timer_handle_t notification_timer_ = nullptr;
     esp_timer_handle_t update_timer_ = nullptr;
 
+    // 界面修改队列：其他任务调用 SetXxx 时只投递消息，不等待 LVGL 锁，由 LVGL 任务每帧取出后应用
+    std::mutex ui_mutex_;
+    std::list<UiMessage> ui_messages_;
+    lv_timer_t* ui_timer_ = nullptr;
+    std::atomic<TaskHandle_t> ui_task_ = nullptr;
+    std::atomic<bool> ui_drain_requested_ = false;
+    std::atomic<bool> face_image_pending_ = false;
+#if CONFIG_USE_FLASH_FONT
+    FlashFont* flash_font_ = nullptr;
+#endif
+
+    // 添加显示之后调用，启用按需渲染和界面修改队列
+    void InitializeRendering();
+    // 不在 LVGL 任务中调用时放入队列并返回 true，调用方直接返回；否则返回 false，由调用方立即修改控件
+    bool PostUiMessage(UiMessage&& message);
+    void DrainUiMessages();
+    void ApplyUiMessage(const UiMessage& message);
+    void HideNotification();
+    // 启用 USE_FLASH_FONT 且 assets 分区中有字体数据时返回按需加载的字体，builtin_font 作为缺字时的回退
+    const lv_font_t* LoadTextFont(const lv_font_t* builtin_font);
+
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
@@ -0,0 +1,182 @@
+#include "flash_font.h"
+#include "memory_tracker.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#define TAG "FlashFont"
+
+#define FLASH_FONT_MAGIC 0x544E4658 // "XFNT"
+#define FLASH_FONT_VERSION 1
+
+struct FlashFont::Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t bpp;
+    uint32_t glyph_count;
+    int16_t line_height;
+    int16_t base_line;
+    int16_t underline_position;
+    int16_t underline_thickness;
+    uint32_t glyph_table_offset;
+    uint32_t bitmap_offset;
+    uint32_t reserved;
+};
+
+struct FlashFont::Glyph {
+    uint32_t unicode;
+    uint32_t bitmap_offset;
+    uint16_t adv_w;
+    uint8_t box_w;
+    uint8_t box_h;
+    int8_t ofs_x;
+    int8_t ofs_y;
+    uint16_t reserved;
+};
+
+FlashFont* FlashFont::Create(std::string_view data, const lv_font_t* fallback, size_t cache_size) {
+    static_assert(sizeof(Header) == 32, "font header must match gen_font_blob.py");
+    static_assert(sizeof(Glyph) == 16, "glyph entry must match gen_font_blob.py");
+    if (data.size() < sizeof(Header)) {
+        ESP_LOGE(TAG, "Font data too small: %u bytes", (unsigned)data.size());
+        return nullptr;
+    }
+    auto header = reinterpret_cast<const Header*>(data.data());
+    if (header->magic != FLASH_FONT_MAGIC || header->version != FLASH_FONT_VERSION || header->bpp != 4) {
+        ESP_LOGE(TAG, "Invalid font data: magic 0x%08lx, version %u, bpp %u",
+            (unsigned long)header->magic, header->version, header->bpp);
+        return nullptr;
+    }
+    if (header->glyph_table_offset + header->glyph_count * sizeof(Glyph) > header->bitmap_offset ||
+        header->bitmap_offset > data.size()) {
+        ESP_LOGE(TAG, "Font data truncated");
+        return nullptr;
+    }
+    ESP_LOGI(TAG, "%lu glyphs, line height %d, cache %u KB", (unsigned long)header->glyph_count,
+        header->line_height, (unsigned)(cache_size / 1024));
+    return new FlashFont(reinterpret_cast<const uint8_t*>(data.data()), fallback, cache_size);
+}
+
+FlashFont::FlashFont(const uint8_t* data, const lv_font_t* fallback, size_t cache_size)
+    : cache_capacity_(cache_size) {
+    auto header = reinterpret_cast<const Header*>(data);
+    glyphs_ = reinterpret_cast<const Glyph*>(data + header->glyph_table_offset);
+    glyph_count_ = header->glyph_count;
+    bitmaps_ = data + header->bitmap_offset;
+
+    font_.get_glyph_dsc = GetGlyphDsc;
+    font_.get_glyph_bitmap = GetGlyphBitmap;
+    font_.line_height = header->line_height;
+    font_.base_line = header->base_line;
+    font_.subpx = LV_FONT_SUBPX_NONE;
+    font_.underline_position = header->underline_position;
+    font_.underline_thickness = header->underline_thickness;
+    font_.dsc = this;
+    font_.fallback = fallback;
+}
+
+const FlashFont::Glyph* FlashFont::FindGlyph(uint32_t unicode) const {
+    uint32_t low = 0;
+    uint32_t high = glyph_count_;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (glyphs_[mid].unicode < unicode) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < glyph_count_ && glyphs_[low].unicode == unicode) {
+        return &glyphs_[low];
+    }
+    return nullptr;
+}
+
+lv_draw_buf_t* FlashFont::GetBitmap(uint32_t index) {
+    auto it = cache_.find(index);
+    if (it != cache_.end()) {
+        hits_++;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return &it->second->draw_buf;
+    }
+    misses_++;
+
+    auto& glyph = glyphs_[index];
+    uint32_t stride = lv_draw_buf_width_to_stride(glyph.box_w, LV_COLOR_FORMAT_A8);
+    size_t size = stride * glyph.box_h;
+    while (cache_size_ + size > cache_capacity_ && !lru_.empty()) {
+        auto& oldest = lru_.back();
+        cache_size_ -= oldest.size;
+        MemoryTracker::GetInstance().Free(oldest.data);
+        cache_.erase(oldest.index);
+        lru_.pop_back();
+    }
+
+    auto& tracker = MemoryTracker::GetInstance();
+    auto data = (uint8_t*)tracker.Malloc(kMemoryTagUi, size, MALLOC_CAP_SPIRAM);
+    if (data == nullptr) {
+        data = (uint8_t*)tracker.Malloc(kMemoryTagUi, size, MALLOC_CAP_8BIT);
+        if (data == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate glyph U+%04lX", (unsigned long)glyph.unicode);
+            return nullptr;
+        }
+    }
+
+    // 4bpp 每行按字节对齐，高 4 位在前，展开成 A8
+    const uint8_t* src = bitmaps_ + glyph.bitmap_offset;
+    uint32_t src_stride = (glyph.box_w + 1) / 2;
+    for (int y = 0; y < glyph.box_h; y++) {
+        uint8_t* dst = data + y * stride;
+        for (int x = 0; x < glyph.box_w; x++) {
+            uint8_t value = src[x / 2];
+            value = (x & 1) ? (value & 0x0F) : (value >> 4);
+            dst[x] = value * 17;
+        }
+        src += src_stride;
+    }
+
+    lru_.push_front({index, data, size, {}});
+    auto& entry = lru_.front();
+    lv_draw_buf_init(&entry.draw_buf, glyph.box_w, glyph.box_h, LV_COLOR_FORMAT_A8, stride, data, size);
+    cache_[index] = lru_.begin();
+    cache_size_ += size;
+    return &entry.draw_buf;
+}
+
+void FlashFont::Prewarm(const char* text) {
+    uint32_t i = 0;
+    while (text[i] != '\0') {
+        uint32_t letter = lv_text_encoded_next(text, &i);
+        auto glyph = FindGlyph(letter);
+        if (glyph != nullptr && glyph->box_w > 0 && glyph->box_h > 0) {
+            GetBitmap(glyph - glyphs_);
+        }
+    }
+    ESP_LOGD(TAG, "Cache %u/%u bytes, %u glyphs, hits %lu, misses %lu", (unsigned)cache_size_,
+        (unsigned)cache_capacity_, (unsigned)lru_.size(), (unsigned long)hits_, (unsigned long)misses_);
+}
+
+bool FlashFont::GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next) {
+    auto self = (FlashFont*)font->dsc;
+    auto glyph = self->FindGlyph(letter);
+    if (glyph == nullptr) {
+        return false;
+    }
+    dsc->adv_w = glyph->adv_w;
+    dsc->box_w = glyph->box_w;
+    dsc->box_h = glyph->box_h;
+    dsc->ofs_x = glyph->ofs_x;
+    dsc->ofs_y = glyph->ofs_y;
+    dsc->format = LV_FONT_GLYPH_FORMAT_A8;
+    dsc->is_placeholder = false;
+    dsc->gid.index = glyph - self->glyphs_;
+    return true;
+}
+
+const void* FlashFont::GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf) {
+    auto self = (FlashFont*)dsc->resolved_font->dsc;
+    if (dsc->box_w == 0 || dsc->box_h == 0) {
+        return nullptr;
+    }
+    return self->GetBitmap(dsc->gid.index);
+}
@@ -0,0 +1,54 @@
+#ifndef FLASH_FONT_H
+#define FLASH_FONT_H
+
+#include <lvgl.h>
+
+#include <cstdint>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+
+// 从 flash 映射的字体数据（scripts/gen_font_blob.py 生成）按需读取字形：
+// 字形表和 4bpp 位图都留在 flash 中，用到的字形展开成 A8 后放进 PSRAM 的 LRU 缓存，
+// 常用字只展开一次；字体数据中没有的字符交给 fallback 字体
+class FlashFont {
+public:
+    // data 需要在整个运行期间有效；数据格式不对时返回 nullptr
+    static FlashFont* Create(std::string_view data, const lv_font_t* fallback, size_t cache_size);
+
+    const lv_font_t* font() const { return &font_; }
+    // 在渲染之前把 text 中的字形展开进缓存，需要持有 LVGL 锁
+    void Prewarm(const char* text);
+
+private:
+    struct Header;
+    struct Glyph;
+    struct CacheEntry {
+        uint32_t index;
+        uint8_t* data;
+        size_t size;
+        lv_draw_buf_t draw_buf;
+    };
+
+    lv_font_t font_ = {};
+    const Glyph* glyphs_ = nullptr;
+    uint32_t glyph_count_ = 0;
+    const uint8_t* bitmaps_ = nullptr;
+
+    size_t cache_capacity_;
+    size_t cache_size_ = 0;
+    std::list<CacheEntry> lru_;
+    std::unordered_map<uint32_t, std::list<CacheEntry>::iterator> cache_;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+
+    FlashFont(const uint8_t* data, const lv_font_t* fallback, size_t cache_size);
+
+    const Glyph* FindGlyph(uint32_t unicode) const;
+    lv_draw_buf_t* GetBitmap(uint32_t index);
+
+    static bool GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next);
+    static const void* GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf);
+};
+
+#endif // FLASH_FONT_H
@@ -2,6 +2,9 @@
 #define LCD_DISPLAY_H
 
 #include "display.h"
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+#include "chat_history_view.h"
+#endif
 
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
@@ -20,6 +23,9 @@ protected:
     lv_obj_t* container_ = nullptr;
     lv_obj_t* side_bar_ = nullptr;
     DisplayFonts fonts_;
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    ChatHistoryView chat_view_;
+#endif
 
     void SetupUI();
     virtual bool Lock(int timeout_ms = 0) override;
@@ -28,7 +34,9 @@ protected:
 protected:
     // 添加protected构造函数
     LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, DisplayFonts fonts)
-        : panel_io_(panel_io), panel_(panel), fonts_(fonts) {}
+        : panel_io_(panel_io), panel_(panel), fonts_(fonts) {
+        fonts_.text_font = LoadTextFont(fonts.text_font);
+    }
     
 public:
     ~LcdDisplay();
@@ -22,7 +22,9 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
     ESP_LOGI(TAG, "Initialize LVGL");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
     port_cfg.task_priority = 1;
-    port_cfg.timer_period_ms = 50;
+    // LVGL 的时间由 RenderScheduler 从 esp_timer 读取，节拍定时器低频运行即可，LVGL 任务只在需要渲染时被唤醒
+    port_cfg.timer_period_ms = RENDER_MAX_SLEEP_MS;
+    port_cfg.task_max_sleep_ms = RENDER_MAX_SLEEP_MS;
     lvgl_port_init(&port_cfg);
 
     ESP_LOGI(TAG, "Adding LCD screen");
@@ -55,6 +57,7 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    InitializeRendering();
 
     if (height_ == 64) {
         SetupUI_128x64();
@@ -95,6 +98,9 @@ void OledDisplay::Unlock() {
 }
 
 void OledDisplay::SetChatMessage(const char* role, const char* content) {
+    if (PostUiMessage({kUiMessageChat, content, role})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -116,6 +122,9 @@ void OledDisplay::SetChatMessage(const char* role, const char* content) {
     }
 }
 void OledDisplay::SetSittingPostureText(const char* postureText) {
+    if (PostUiMessage({kUiMessagePosture, postureText})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (sit_label_ == nullptr) {
         return;
@@ -124,6 +133,9 @@ void OledDisplay::SetSittingPostureText(const char* postureText) {
     lv_label_set_text(sit_label_, postureText);
 }
 void OledDisplay::SetSittingHandText(const char* postureText) {
+    if (PostUiMessage({kUiMessageHand, postureText})) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (hand_label_ == nullptr) {
         return;
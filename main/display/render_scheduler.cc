@@ -0,0 +1,49 @@
+#include "render_scheduler.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_lvgl_port.h>
+
+#define TAG "RenderScheduler"
+
+// LVGL 的时间直接从 esp_timer 读取，不依赖端口的节拍定时器，定时器和动画的时间精度不受节拍周期影响
+static uint32_t GetTick() {
+    return esp_timer_get_time() / 1000;
+}
+
+void RenderScheduler::Attach(lv_display_t* display) {
+    display_ = display;
+    lv_tick_set_cb(GetTick);
+    lv_display_add_event_cb(display_, OnInvalidateArea, LV_EVENT_INVALIDATE_AREA, this);
+    lv_display_add_event_cb(display_, OnRefreshStart, LV_EVENT_REFR_START, this);
+}
+
+void RenderScheduler::SetFrameRate(int fps) {
+    if (display_ == nullptr) {
+        return;
+    }
+    auto timer = lv_display_get_refr_timer(display_);
+    if (timer == nullptr) {
+        return;
+    }
+    uint32_t period = fps > 0 ? 1000 / fps : LV_DEF_REFR_PERIOD;
+    ESP_LOGI(TAG, "Refresh period %lu ms", (unsigned long)period);
+    lv_timer_set_period(timer, period);
+}
+
+void RenderScheduler::Wake() {
+    lvgl_port_task_wake(LVGL_PORT_EVENT_USER, nullptr);
+}
+
+// 失效区域由持有 LVGL 锁的其他任务产生时，LVGL 任务可能正在睡眠，需要立即唤醒
+void RenderScheduler::OnInvalidateArea(lv_event_t* e) {
+    auto scheduler = static_cast<RenderScheduler*>(lv_event_get_user_data(e));
+    if (xTaskGetCurrentTaskHandle() != scheduler->lvgl_task_) {
+        scheduler->Wake();
+    }
+}
+
+void RenderScheduler::OnRefreshStart(lv_event_t* e) {
+    auto scheduler = static_cast<RenderScheduler*>(lv_event_get_user_data(e));
+    scheduler->lvgl_task_ = xTaskGetCurrentTaskHandle();
+}
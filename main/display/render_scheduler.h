@@ -0,0 +1,32 @@
+#ifndef RENDER_SCHEDULER_H
+#define RENDER_SCHEDULER_H
+
+#include <lvgl.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+
+// 没有动画和失效区域时 LVGL 任务最长的睡眠时间
+#define RENDER_MAX_SLEEP_MS 2000
+
+// 按需渲染：画面静止时 LVGL 任务一直睡眠（LVGL 会在刷新后暂停刷新定时器，动画结束后暂停动画定时器），
+// 控件修改、视频新帧等使显示区域失效时立即唤醒 LVGL 任务渲染，动画运行期间按刷新周期持续渲染
+class RenderScheduler {
+public:
+    // 在添加显示之后、持有 LVGL 锁时调用
+    void Attach(lv_display_t* display);
+    // 刷新帧率上限，视频播放时设置为视频帧率，0 恢复 LVGL 默认刷新周期；需要持有 LVGL 锁
+    void SetFrameRate(int fps);
+    // 唤醒 LVGL 任务，可以在任意任务中调用
+    void Wake();
+
+private:
+    lv_display_t* display_ = nullptr;
+    // LVGL 任务自己产生的失效不需要唤醒，刷新开始时记录任务句柄
+    std::atomic<TaskHandle_t> lvgl_task_ = nullptr;
+
+    static void OnInvalidateArea(lv_event_t* e);
+    static void OnRefreshStart(lv_event_t* e);
+};
+
+#endif // RENDER_SCHEDULER_H
@@ -2,6 +2,7 @@
 #include "application.h"
 
 #include <esp_log.h>
+#include <cassert>
 
 #define TAG "Thing"
 
@@ -26,6 +27,25 @@ Thing* CreateThing(const std::string& type) {
     return creator->second();
 }
 
+void MethodList::AddMethod(const Method& method) {
+    uint32_t id = InternName(method.name().c_str());
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        auto& existing = methods_[it->second];
+        if (existing.name() == method.name()) {
+            ESP_LOGE(TAG, "Duplicate method: %s", method.name().c_str());
+        } else {
+            // 不同名称的 id 相同时后者无法分发，需要改名
+            ESP_LOGE(TAG, "Method id collision: %s and %s (0x%08lx)", existing.name().c_str(),
+                method.name().c_str(), (unsigned long)id);
+            assert(false);
+        }
+        return;
+    }
+    index_[id] = methods_.size();
+    methods_.push_back(method);
+}
+
 std::string Thing::GetDescriptorJson() {
     std::string json_str = "{";
     json_str += "\"name\":\"" + name_ + "\",";
@@ -44,34 +64,47 @@ std::string Thing::GetStateJson() {
     return json_str;
 }
 
-void Thing::Invoke(const cJSON* command) {
+bool Thing::Invoke(const cJSON* command) {
     auto method_name = cJSON_GetObjectItem(command, "method");
     auto input_params = cJSON_GetObjectItem(command, "parameters");
+    if (!cJSON_IsString(method_name)) {
+        ESP_LOGE(TAG, "Invalid method for %s", name_.c_str());
+        return false;
+    }
 
-    try {
-        auto& method = methods_[method_name->valuestring];
-        for (auto& param : method.parameters()) {
-            auto input_param = cJSON_GetObjectItem(input_params, param.name().c_str());
-            if (param.required() && input_param == nullptr) {
-                throw std::runtime_error("Parameter " + param.name() + " is required");
-            }
-            if (param.type() == kValueTypeNumber) {
-                param.set_number(input_param->valueint);
-            } else if (param.type() == kValueTypeString) {
-                param.set_string(input_param->valuestring);
-            } else if (param.type() == kValueTypeBoolean) {
-                param.set_boolean(input_param->valueint == 1);
+    auto method = methods_.Find(method_name->valuestring);
+    if (method == nullptr) {
+        ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
+        return false;
+    }
+
+    // 每次调用复制一份参数列表并绑定输入值，避免与下一条指令竞争
+    ParameterList parameters = method->parameters();
+    for (auto& param : parameters) {
+        auto input_param = cJSON_GetObjectItem(input_params, param.name().c_str());
+        if (input_param == nullptr) {
+            if (param.required()) {
+                ESP_LOGE(TAG, "Parameter %s is required", param.name().c_str());
+                return false;
             }
+            continue;
+        }
+        if (param.type() == kValueTypeNumber && cJSON_IsNumber(input_param)) {
+            param.set_number(input_param->valueint);
+        } else if (param.type() == kValueTypeString && cJSON_IsString(input_param)) {
+            param.set_string(input_param->valuestring);
+        } else if (param.type() == kValueTypeBoolean && (cJSON_IsBool(input_param) || cJSON_IsNumber(input_param))) {
+            param.set_boolean(cJSON_IsTrue(input_param) || input_param->valueint == 1);
+        } else {
+            ESP_LOGE(TAG, "Parameter %s has wrong type", param.name().c_str());
+            return false;
         }
-
-        Application::GetInstance().Schedule([&method]() {
-            method.Invoke();
-        });
-    } catch (const std::runtime_error& e) {
-        ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
-        return;
     }
-}
 
+    Application::GetInstance().Schedule([method, parameters = std::move(parameters)]() {
+        method->Invoke(parameters);
+    });
+    return true;
+}
 
 } // namespace iot
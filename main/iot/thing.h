@@ -5,11 +5,23 @@
 #include <map>
 #include <functional>
 #include <vector>
-#include <stdexcept>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
 #include <cJSON.h>
 
 namespace iot {
 
+// 名称驻留为 32 位 id (FNV-1a)，分发时不需要构造 std::string
+inline uint32_t InternName(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= static_cast<uint8_t>(*name++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 enum ValueType {
     kValueTypeBoolean,
     kValueTypeNumber,
@@ -85,13 +97,13 @@ public:
         properties_.push_back(Property(name, description, getter));
     }
 
-    const Property& operator[](const std::string& name) const {
+    const Property* Find(const std::string& name) const {
         for (auto& property : properties_) {
             if (property.name() == name) {
-                return property;
+                return &property;
             }
         }
-        throw std::runtime_error("Property not found: " + name);
+        return nullptr;
     }
 
     std::string GetDescriptorJson() {
@@ -125,8 +137,8 @@ private:
     std::string description_;
     ValueType type_;
     bool required_;
-    bool boolean_;
-    int number_;
+    bool boolean_ = false;
+    int number_ = 0;
     std::string string_;
 
 public:
@@ -172,18 +184,22 @@ public:
         parameters_.push_back(parameter);
     }
 
+    // 未声明的参数返回一个空值参数，而不是抛出异常
     const Parameter& operator[](const std::string& name) const {
         for (auto& parameter : parameters_) {
             if (parameter.name() == name) {
                 return parameter;
             }
         }
-        throw std::runtime_error("Parameter not found: " + name);
+        static const Parameter empty("", "", kValueTypeNumber, false);
+        return empty;
     }
 
     // iterator
     auto begin() { return parameters_.begin(); }
     auto end() { return parameters_.end(); }
+    auto begin() const { return parameters_.begin(); }
+    auto end() const { return parameters_.end(); }
 
     std::string GetDescriptorJson() {
         std::string json_str = "{";
@@ -211,7 +227,7 @@ public:
 
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
-    ParameterList& parameters() { return parameters_; }
+    const ParameterList& parameters() const { return parameters_; }
 
     std::string GetDescriptorJson() {
         std::string json_str = "{";
@@ -221,30 +237,39 @@ public:
         return json_str;
     }
 
-    void Invoke() {
-        callback_(parameters_);
+    // 参数按每次调用单独绑定，不共享 Method 内的参数列表
+    void Invoke(const ParameterList& parameters) const {
+        callback_(parameters);
     }
 };
 
 class MethodList {
 private:
     std::vector<Method> methods_;
+    std::unordered_map<uint32_t, size_t> index_;
 
 public:
     MethodList() = default;
-    MethodList(const std::vector<Method>& methods) : methods_(methods) {}
+    MethodList(const std::vector<Method>& methods) {
+        for (auto& method : methods) {
+            AddMethod(method);
+        }
+    }
 
     void AddMethod(const std::string& name, const std::string& description, const ParameterList& parameters, std::function<void(const ParameterList&)> callback) {
-        methods_.push_back(Method(name, description, parameters, callback));
+        AddMethod(Method(name, description, parameters, callback));
     }
 
-    Method& operator[](const std::string& name) {
-        for (auto& method : methods_) {
-            if (method.name() == name) {
-                return method;
-            }
+    // 重名或名称 id 冲突时不添加，保留先注册的方法
+    void AddMethod(const Method& method);
+
+    const Method* Find(const char* name) const {
+        auto it = index_.find(InternName(name));
+        if (it == index_.end()) {
+            return nullptr;
         }
-        throw std::runtime_error("Method not found: " + name);
+        auto& method = methods_[it->second];
+        return strcmp(method.name().c_str(), name) == 0 ? &method : nullptr;
     }
 
     std::string GetDescriptorJson() {
@@ -268,7 +293,7 @@ public:
 
     virtual std::string GetDescriptorJson();
     virtual std::string GetStateJson();
-    virtual void Invoke(const cJSON* command);
+    virtual bool Invoke(const cJSON* command);
 
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
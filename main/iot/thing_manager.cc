@@ -1,12 +1,25 @@
 #include "thing_manager.h"
 
 #include <esp_log.h>
+#include <cassert>
 
 #define TAG "ThingManager"
 
 namespace iot {
 
 void ThingManager::AddThing(Thing* thing) {
+    if (thing == nullptr) {
+        return;
+    }
+    auto id = InternName(thing->name().c_str());
+    if (thing_table_.find(id) != thing_table_.end()) {
+        // 重名或名称 id 冲突是板子代码的错误，调试版直接断言；发布版释放后来的设备，保留先注册的
+        ESP_LOGE(TAG, "Thing id conflict: %s", thing->name().c_str());
+        assert(false);
+        delete thing;
+        return;
+    }
+    thing_table_[id] = thing;
     things_.push_back(thing);
 }
 
@@ -50,14 +63,37 @@ bool ThingManager::GetStatesJson(std::string& json, bool delta) {
     return changed;
 }
 
-void ThingManager::Invoke(const cJSON* command) {
+bool ThingManager::Invoke(const cJSON* command) {
     auto name = cJSON_GetObjectItem(command, "name");
-    for (auto& thing : things_) {
-        if (thing->name() == name->valuestring) {
-            thing->Invoke(command);
-            return;
-        }
+    if (!cJSON_IsString(name)) {
+        ESP_LOGE(TAG, "Invalid thing name");
+        return false;
+    }
+    auto it = thing_table_.find(InternName(name->valuestring));
+    if (it == thing_table_.end() || it->second->name() != name->valuestring) {
+        ESP_LOGE(TAG, "Thing not found: %s", name->valuestring);
+        return false;
+    }
+    return it->second->Invoke(command);
+}
+
+bool ThingManager::GetPropertyNumber(const std::string& thing_name, const std::string& property, int& value) {
+    auto it = thing_table_.find(InternName(thing_name.c_str()));
+    if (it == thing_table_.end() || it->second->name() != thing_name) {
+        return false;
+    }
+    auto root = cJSON_Parse(it->second->GetStateJson().c_str());
+    if (root == nullptr) {
+        return false;
+    }
+    auto state = cJSON_GetObjectItem(root, "state");
+    auto item = cJSON_GetObjectItem(state, property.c_str());
+    bool found = cJSON_IsNumber(item);
+    if (found) {
+        value = item->valueint;
     }
+    cJSON_Delete(root);
+    return found;
 }
 
 } // namespace iot
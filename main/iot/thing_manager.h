@@ -10,6 +10,7 @@
 #include <memory>
 #include <functional>
 #include <map>
+#include <unordered_map>
 
 namespace iot {
 
@@ -22,17 +23,21 @@ public:
     ThingManager(const ThingManager&) = delete;
     ThingManager& operator=(const ThingManager&) = delete;
 
+    // 接管 thing 的所有权；名称 id 与已注册的设备冲突时断言，发布版中释放 thing
     void AddThing(Thing* thing);
 
     std::string GetDescriptorsJson();
     bool GetStatesJson(std::string& json, bool delta = false);
-    void Invoke(const cJSON* command);
+    bool Invoke(const cJSON* command);
+    // 读取设备的数值属性，供本地命令按当前值做相对调整
+    bool GetPropertyNumber(const std::string& thing_name, const std::string& property, int& value);
 
 private:
     ThingManager() = default;
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
+    std::unordered_map<uint32_t, Thing*> thing_table_;
     std::map<std::string, std::string> last_states_;
 };
 
@@ -0,0 +1,110 @@
+#include "media_memory.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+
+#define TAG "MediaMemory"
+
+#define MEDIA_MEMORY_ALIGNMENT 16
+
+static MemoryRegion GetRegion(uint32_t caps) {
+    if (caps & MALLOC_CAP_SPIRAM) {
+        return kMemoryRegionPsram;
+    }
+    return (caps & MALLOC_CAP_DMA) ? kMemoryRegionDma : kMemoryRegionInternal;
+}
+
+MemoryPool::MemoryPool(MemoryTag tag, uint32_t caps, size_t block_size, size_t block_count)
+    : tag_(tag), block_count_(block_count) {
+    // 块大小按 16 字节对齐，满足 JPEG 解码输出和 DMA 的要求，同时能放下空闲链表指针
+    block_size_ = std::max(block_size, sizeof(void*));
+    block_size_ = (block_size_ + MEDIA_MEMORY_ALIGNMENT - 1) / MEDIA_MEMORY_ALIGNMENT * MEDIA_MEMORY_ALIGNMENT;
+    if (block_count_ == 0) {
+        return;
+    }
+
+    storage_ = (uint8_t*)heap_caps_aligned_alloc(MEDIA_MEMORY_ALIGNMENT, block_size_ * block_count_, caps);
+    if (storage_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate pool of %u x %u bytes", (unsigned)block_count_, (unsigned)block_size_);
+        block_count_ = 0;
+        return;
+    }
+    MemoryTracker::GetInstance().Track(tag_, GetRegion(caps), block_size_ * block_count_);
+
+    for (size_t i = block_count_; i > 0; i--) {
+        auto block = storage_ + (i - 1) * block_size_;
+        *(void**)block = free_list_;
+        free_list_ = block;
+    }
+    available_ = block_count_;
+}
+
+MemoryPool::~MemoryPool() {
+    if (storage_ != nullptr) {
+        heap_caps_free(storage_);
+    }
+}
+
+void* MemoryPool::Allocate(size_t size) {
+    if (size > block_size_) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_list_ == nullptr) {
+        return nullptr;
+    }
+    void* block = free_list_;
+    free_list_ = *(void**)block;
+    available_--;
+    return block;
+}
+
+void MemoryPool::Free(void* ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    *(void**)ptr = free_list_;
+    free_list_ = ptr;
+    available_++;
+}
+
+bool MemoryPool::Contains(const void* ptr) const {
+    return storage_ != nullptr && ptr >= storage_ && ptr < storage_ + block_size_ * block_count_;
+}
+
+MediaMemory::MediaMemory() {
+    pools_[kMediaPoolFrame] = new MemoryPool(kMemoryTagVideo, MALLOC_CAP_SPIRAM,
+        CONFIG_MEDIA_FRAME_POOL_BLOCK_SIZE, CONFIG_MEDIA_FRAME_POOL_BLOCKS);
+    fallback_caps_[kMediaPoolFrame] = MALLOC_CAP_SPIRAM;
+    tags_[kMediaPoolFrame] = kMemoryTagVideo;
+}
+
+MediaMemory::~MediaMemory() {
+    for (auto pool : pools_) {
+        delete pool;
+    }
+}
+
+void* MediaMemory::Allocate(MediaPool pool, size_t size) {
+    void* ptr = pools_[pool]->Allocate(size);
+    if (ptr != nullptr) {
+        return ptr;
+    }
+
+    if (fallback_count_[pool]++ == 0) {
+        ESP_LOGW(TAG, "Pool %d cannot serve %u bytes (block %u, %u free), falling back to heap", pool,
+            (unsigned)size, (unsigned)pools_[pool]->block_size(), (unsigned)pools_[pool]->available());
+    }
+    return MemoryTracker::GetInstance().Malloc(tags_[pool], size, fallback_caps_[pool]);
+}
+
+void MediaMemory::Free(MediaPool pool, void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    if (pools_[pool]->Contains(ptr)) {
+        pools_[pool]->Free(ptr);
+    } else {
+        MemoryTracker::GetInstance().Free(ptr);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef _MEDIA_MEMORY_H_
+#define _MEDIA_MEMORY_H_
+
+#include "memory_tracker.h"
+
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+// 固定大小块的内存池，启动时一次性从指定的内存区域分配，运行期间不再碎片化堆
+class MemoryPool {
+public:
+    MemoryPool(MemoryTag tag, uint32_t caps, size_t block_size, size_t block_count);
+    ~MemoryPool();
+
+    // size 超过块大小或池已用完时返回 nullptr
+    void* Allocate(size_t size);
+    void Free(void* ptr);
+    bool Contains(const void* ptr) const;
+
+    size_t block_size() const { return block_size_; }
+    size_t block_count() const { return block_count_; }
+    size_t available() const { return available_; }
+
+private:
+    MemoryTag tag_;
+    uint8_t* storage_ = nullptr;
+    size_t block_size_;
+    size_t block_count_;
+    size_t available_ = 0;
+    void* free_list_ = nullptr;
+    std::mutex mutex_;
+};
+
+enum MediaPool {
+    kMediaPoolFrame,    // 视频解码输出，PSRAM，16 字节对齐
+    kMediaPoolCount
+};
+
+// 媒体缓冲区的统一入口，池满或尺寸超出时回退到对应区域的堆上
+class MediaMemory {
+public:
+    static MediaMemory& GetInstance() {
+        static MediaMemory instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    MediaMemory(const MediaMemory&) = delete;
+    MediaMemory& operator=(const MediaMemory&) = delete;
+
+    void* Allocate(MediaPool pool, size_t size);
+    void Free(MediaPool pool, void* ptr);
+    MemoryPool& pool(MediaPool pool) { return *pools_[pool]; }
+
+private:
+    MediaMemory();
+    ~MediaMemory();
+
+    MemoryPool* pools_[kMediaPoolCount];
+    uint32_t fallback_caps_[kMediaPoolCount];
+    MemoryTag tags_[kMediaPoolCount];
+    uint32_t fallback_count_[kMediaPoolCount] = {};
+};
+
+#endif // _MEDIA_MEMORY_H_
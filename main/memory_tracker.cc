@@ -0,0 +1,253 @@
+#include "memory_tracker.h"
+#include "debug_console.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_memory_utils.h>
+#include <cJSON.h>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "MemoryTracker"
+
+#define BLOCK_MAGIC 0x4d54
+#define BLOCK_HEADER_SIZE 16
+
+// 放在每个块前面，块按 16 字节对齐分配，返回地址同样 16 字节对齐
+struct BlockHeader {
+    uint16_t magic;
+    uint8_t tag;
+    uint8_t region;
+    uint32_t size;
+};
+static_assert(sizeof(BlockHeader) <= BLOCK_HEADER_SIZE, "BlockHeader too large");
+
+static const char* const kTagNames[kMemoryTagCount] = {
+    "audio", "video", "protocol", "ui", "iot", "ota"
+};
+
+static const char* const kRegionNames[kMemoryRegionCount] = {
+    "internal", "dma", "psram"
+};
+
+static const uint32_t kRegionCaps[kMemoryRegionCount] = {
+    MALLOC_CAP_INTERNAL, MALLOC_CAP_DMA, MALLOC_CAP_SPIRAM
+};
+
+MemoryTracker::MemoryTracker() {
+    last_rate_time_ = esp_timer_get_time();
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag) {
+    return tag < kMemoryTagCount ? kTagNames[tag] : "unknown";
+}
+
+const char* MemoryTracker::GetRegionName(MemoryRegion region) {
+    return region < kMemoryRegionCount ? kRegionNames[region] : "unknown";
+}
+
+MemoryRegion MemoryTracker::GetRegion(const void* ptr) {
+    return esp_ptr_external_ram(ptr) ? kMemoryRegionPsram : kMemoryRegionInternal;
+}
+
+void* MemoryTracker::Malloc(MemoryTag tag, size_t size, uint32_t caps) {
+    auto block = (uint8_t*)heap_caps_aligned_alloc(BLOCK_HEADER_SIZE, size + BLOCK_HEADER_SIZE, caps);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    // 按实际分到的内存归类，调用方常在 PSRAM 不足时回退到内部 SRAM
+    MemoryRegion region = kMemoryRegionInternal;
+    if (esp_ptr_external_ram(block)) {
+        region = kMemoryRegionPsram;
+    } else if (caps & MALLOC_CAP_DMA) {
+        region = kMemoryRegionDma;
+    }
+
+    auto header = (BlockHeader*)block;
+    header->magic = BLOCK_MAGIC;
+    header->tag = tag;
+    header->region = region;
+    header->size = size;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& counter = counters_[tag][region];
+    counter.live += size;
+    counter.peak = std::max(counter.peak, counter.live);
+    counter.allocations++;
+    counter.allocated_bytes += size;
+    return block + BLOCK_HEADER_SIZE;
+}
+
+void MemoryTracker::Free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    auto block = (uint8_t*)ptr - BLOCK_HEADER_SIZE;
+    auto header = (BlockHeader*)block;
+    if (header->magic != BLOCK_MAGIC || header->tag >= kMemoryTagCount || header->region >= kMemoryRegionCount) {
+        ESP_LOGE(TAG, "Freeing a block not allocated by MemoryTracker: %p", ptr);
+        heap_caps_free(ptr);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& counter = counters_[header->tag][header->region];
+        counter.live -= std::min<size_t>(counter.live, header->size);
+    }
+    header->magic = 0;
+    heap_caps_free(block);
+}
+
+void MemoryTracker::Track(MemoryTag tag, MemoryRegion region, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& counter = counters_[tag][region];
+    counter.live += size;
+    counter.peak = std::max(counter.peak, counter.live);
+    counter.allocations++;
+    counter.allocated_bytes += size;
+}
+
+void MemoryTracker::Untrack(MemoryTag tag, MemoryRegion region, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& counter = counters_[tag][region];
+    counter.live -= std::min(counter.live, size);
+}
+
+void MemoryTracker::TrackStartup(MemoryTag tag, MemoryRegion region, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    startup_[tag][region] += size;
+}
+
+std::string MemoryTracker::GetReportJson() {
+    Counter counters[kMemoryTagCount][kMemoryRegionCount];
+    size_t startup[kMemoryTagCount][kMemoryRegionCount];
+    RateSnapshot rates[kMemoryTagCount];
+    int64_t elapsed_us;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memcpy(counters, counters_, sizeof(counters));
+        memcpy(startup, startup_, sizeof(startup));
+        auto now = esp_timer_get_time();
+        elapsed_us = std::max<int64_t>(now - last_rate_time_, 1);
+        last_rate_time_ = now;
+        for (int tag = 0; tag < kMemoryTagCount; tag++) {
+            RateSnapshot total;
+            for (int region = 0; region < kMemoryRegionCount; region++) {
+                total.allocations += counters_[tag][region].allocations;
+                total.allocated_bytes += counters_[tag][region].allocated_bytes;
+            }
+            rates[tag].allocations = total.allocations - last_rate_[tag].allocations;
+            rates[tag].allocated_bytes = total.allocated_bytes - last_rate_[tag].allocated_bytes;
+            last_rate_[tag] = total;
+        }
+    }
+
+    cJSON* root = cJSON_CreateObject();
+    cJSON* heaps = cJSON_CreateObject();
+    for (int region = 0; region < kMemoryRegionCount; region++) {
+        cJSON* heap = cJSON_CreateObject();
+        cJSON_AddNumberToObject(heap, "total", heap_caps_get_total_size(kRegionCaps[region]));
+        cJSON_AddNumberToObject(heap, "free", heap_caps_get_free_size(kRegionCaps[region]));
+        cJSON_AddNumberToObject(heap, "min_free", heap_caps_get_minimum_free_size(kRegionCaps[region]));
+        cJSON_AddNumberToObject(heap, "largest_free", heap_caps_get_largest_free_block(kRegionCaps[region]));
+        cJSON_AddItemToObject(heaps, kRegionNames[region], heap);
+    }
+    cJSON_AddItemToObject(root, "heaps", heaps);
+
+    cJSON* tags = cJSON_CreateObject();
+    for (int tag = 0; tag < kMemoryTagCount; tag++) {
+        cJSON* item = cJSON_CreateObject();
+        for (int region = 0; region < kMemoryRegionCount; region++) {
+            auto& counter = counters[tag][region];
+            if (counter.allocations == 0 && startup[tag][region] == 0) {
+                continue;
+            }
+            // startup 是初始化时的堆增长快照，live / peak 只来自实时统计的分配
+            cJSON* usage = cJSON_CreateObject();
+            if (counter.allocations > 0) {
+                cJSON_AddNumberToObject(usage, "live", counter.live);
+                cJSON_AddNumberToObject(usage, "peak", counter.peak);
+                cJSON_AddNumberToObject(usage, "allocations", counter.allocations);
+            }
+            if (startup[tag][region] > 0) {
+                cJSON_AddNumberToObject(usage, "startup", startup[tag][region]);
+            }
+            cJSON_AddItemToObject(item, kRegionNames[region], usage);
+        }
+        cJSON_AddNumberToObject(item, "alloc_per_sec", rates[tag].allocations * 1000000.0 / elapsed_us);
+        cJSON_AddNumberToObject(item, "bytes_per_sec", rates[tag].allocated_bytes * 1000000.0 / elapsed_us);
+        cJSON_AddItemToObject(tags, kTagNames[tag], item);
+    }
+    cJSON_AddItemToObject(root, "tags", tags);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
+void MemoryTracker::PrintReport() {
+    Counter counters[kMemoryTagCount][kMemoryRegionCount];
+    size_t startup[kMemoryTagCount][kMemoryRegionCount];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memcpy(counters, counters_, sizeof(counters));
+        memcpy(startup, startup_, sizeof(startup));
+    }
+
+    printf("| Heap     | Free     | Min Free | Largest\n");
+    for (int region = 0; region < kMemoryRegionCount; region++) {
+        printf("| %-8s | %8u | %8u | %8u\n", kRegionNames[region],
+            (unsigned)heap_caps_get_free_size(kRegionCaps[region]),
+            (unsigned)heap_caps_get_minimum_free_size(kRegionCaps[region]),
+            (unsigned)heap_caps_get_largest_free_block(kRegionCaps[region]));
+    }
+
+    // Startup 列是初始化时 MemoryScope 记录的堆增长，不随之后的分配释放变化
+    printf("| Tag      | Region   | Live     | Peak     | Allocs | Startup\n");
+    for (int tag = 0; tag < kMemoryTagCount; tag++) {
+        for (int region = 0; region < kMemoryRegionCount; region++) {
+            auto& counter = counters[tag][region];
+            if (counter.allocations == 0 && startup[tag][region] == 0) {
+                continue;
+            }
+            printf("| %-8s | %-8s | %8u | %8u | %6lu | %8u\n", kTagNames[tag], kRegionNames[region],
+                (unsigned)counter.live, (unsigned)counter.peak, (unsigned long)counter.allocations,
+                (unsigned)startup[tag][region]);
+        }
+    }
+}
+
+void MemoryTracker::RegisterConsoleCommand() {
+    DebugConsole::GetInstance().RegisterCommand("mem", "Print heap usage per subsystem, 'mem json' for JSON",
+        [this](int argc, char** argv) {
+            if (argc > 1 && strcmp(argv[1], "json") == 0) {
+                printf("%s\n", GetReportJson().c_str());
+            } else {
+                PrintReport();
+            }
+            return 0;
+        });
+}
+
+MemoryScope::MemoryScope(MemoryTag tag) : tag_(tag) {
+    for (int region = 0; region < kMemoryRegionCount; region++) {
+        free_[region] = heap_caps_get_free_size(kRegionCaps[region]);
+    }
+}
+
+MemoryScope::~MemoryScope() {
+    // DMA 内存属于内部 SRAM，只按内部 SRAM 和 PSRAM 归属，避免重复计数
+    for (auto region : {kMemoryRegionInternal, kMemoryRegionPsram}) {
+        size_t free = heap_caps_get_free_size(kRegionCaps[region]);
+        if (free < free_[region]) {
+            MemoryTracker::GetInstance().TrackStartup(tag_, region, free_[region] - free);
+        }
+    }
+}
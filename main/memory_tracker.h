@@ -0,0 +1,94 @@
+#ifndef _MEMORY_TRACKER_H_
+#define _MEMORY_TRACKER_H_
+
+#include <esp_heap_caps.h>
+
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+enum MemoryTag {
+    kMemoryTagAudio,
+    kMemoryTagVideo,
+    kMemoryTagProtocol,
+    kMemoryTagUi,
+    kMemoryTagIot,
+    kMemoryTagOta,
+    kMemoryTagCount
+};
+
+enum MemoryRegion {
+    kMemoryRegionInternal,
+    kMemoryRegionDma,
+    kMemoryRegionPsram,
+    kMemoryRegionCount
+};
+
+// 按子系统统计内存占用：当前占用、峰值和分配速率，区分内部 SRAM / DMA / PSRAM
+// 自己管理的大块缓冲区（OTA 缓冲、视频帧池、字库缓存、回放日志、版本检查响应）用 Malloc / Track 实时统计；
+// 第三方库内部的内存（Opus、AFE、LVGL、MQTT / WebSocket 客户端）只能用 MemoryScope 按堆变化量归属，
+// 只是初始化时的一次快照，报告中单独列为 startup，不计入 live / peak / 分配速率，运行期的增长不会体现
+class MemoryTracker {
+public:
+    static MemoryTracker& GetInstance() {
+        static MemoryTracker instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    void* Malloc(MemoryTag tag, size_t size, uint32_t caps);
+    // 释放由 Malloc 分配的内存，其他指针记录错误后直接交给 heap_caps_free
+    void Free(void* ptr);
+
+    // 记录不经过 Malloc 的内存
+    void Track(MemoryTag tag, MemoryRegion region, size_t size);
+    void Untrack(MemoryTag tag, MemoryRegion region, size_t size);
+    // MemoryScope 记录的启动阶段堆增长量
+    void TrackStartup(MemoryTag tag, MemoryRegion region, size_t size);
+
+    std::string GetReportJson();
+    void PrintReport();
+    void RegisterConsoleCommand();
+
+    static const char* GetTagName(MemoryTag tag);
+    static const char* GetRegionName(MemoryRegion region);
+    // 按地址判断已分配内存所在的区域，用于 Track 由其他分配器分配的内存
+    static MemoryRegion GetRegion(const void* ptr);
+
+private:
+    MemoryTracker();
+
+    struct Counter {
+        size_t live = 0;
+        size_t peak = 0;
+        uint32_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+    };
+
+    struct RateSnapshot {
+        uint32_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+    };
+
+    std::mutex mutex_;
+    Counter counters_[kMemoryTagCount][kMemoryRegionCount];
+    size_t startup_[kMemoryTagCount][kMemoryRegionCount] = {};
+    RateSnapshot last_rate_[kMemoryTagCount];
+    int64_t last_rate_time_ = 0;
+};
+
+// 把作用域内各区域堆占用的增长量记到 tag 的 startup 名下，用于 Opus / AFE / LVGL 等自己分配内存的组件
+// 其他任务同时分配的内存也会被计入，之后的释放也不会扣除，只适合在启动阶段粗略归属
+class MemoryScope {
+public:
+    MemoryScope(MemoryTag tag);
+    ~MemoryScope();
+
+private:
+    MemoryTag tag_;
+    size_t free_[kMemoryRegionCount];
+};
+
+#endif // _MEMORY_TRACKER_H_
@@ -2,14 +2,24 @@
 #include "system_info.h"
 #include "board.h"
 #include "settings.h"
+#include "ota_ring_buffer.h"
+#include "ota_decoder.h"
+#include "memory_tracker.h"
 
 #include <cJSON.h>
 #include <esp_log.h>
 #include <esp_partition.h>
 #include <esp_ota_ops.h>
 #include <esp_app_format.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <mbedtls/sha256.h>
 
+#include <atomic>
 #include <cstring>
+#include <strings.h>
+#include <memory>
 #include <vector>
 #include <sstream>
 #include <algorithm>
@@ -61,11 +71,18 @@ bool Ota::CheckVersion() {
     http->Close();
     delete http;
 
-    // Response: { "firmware": { "version": "1.0.0", "url": "http://" } }
+    // Response: { "firmware": { "version": "1.0.0", "url": "http://", "sha256": "...", "encoding": "raw" } }
     // Parse the JSON response and check if the version is newer
     // If it is, set has_new_version_ to true and store the new version and URL
-    
+
+    // 响应体和解析出的 JSON 树同时驻留内部 SRAM，计入 ota 的占用，解析后立即释放响应体
+    auto& tracker = MemoryTracker::GetInstance();
+    auto region = MemoryTracker::GetRegion(response.data());
+    size_t response_size = response.capacity();
+    tracker.Track(kMemoryTagOta, region, response_size);
     cJSON *root = cJSON_Parse(response.c_str());
+    std::string().swap(response);
+    tracker.Untrack(kMemoryTagOta, region, response_size);
     if (root == NULL) {
         ESP_LOGE(TAG, "Failed to parse JSON response");
         return false;
@@ -144,6 +161,12 @@ bool Ota::CheckVersion() {
 
     firmware_version_ = version->valuestring;
     firmware_url_ = url->valuestring;
+    // Optional, used to verify the downloaded image
+    cJSON *sha256 = cJSON_GetObjectItem(firmware, "sha256");
+    firmware_sha256_ = cJSON_IsString(sha256) ? sha256->valuestring : "";
+    // Optional, "lz" / "delta" / "delta+lz" images are generated by scripts/ota_pack.py
+    cJSON *encoding = cJSON_GetObjectItem(firmware, "encoding");
+    firmware_encoding_ = cJSON_IsString(encoding) ? encoding->valuestring : "raw";
     cJSON_Delete(root);
 
     // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -176,112 +199,408 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
+#define OTA_SECTOR_SIZE 4096
+#define OTA_IMAGE_HEADER_SIZE (sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t))
+
+// 断点只在扇区边界保存，每次写入的块必须覆盖整数个扇区
+static_assert(CONFIG_OTA_FLASH_WRITE_CHUNK_SIZE % OTA_SECTOR_SIZE == 0,
+    "CONFIG_OTA_FLASH_WRITE_CHUNK_SIZE must be a multiple of the flash sector size");
+
+static std::string ToHex(const uint8_t* data, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(length * 2);
+    for (size_t i = 0; i < length; i++) {
+        result.push_back(hex[data[i] >> 4]);
+        result.push_back(hex[data[i] & 0x0f]);
+    }
+    return result;
+}
+
+static std::string GetSha256Hex(const mbedtls_sha256_context* sha256) {
+    mbedtls_sha256_context copy;
+    mbedtls_sha256_init(&copy);
+    mbedtls_sha256_clone(&copy, sha256);
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&copy, digest);
+    mbedtls_sha256_free(&copy);
+    return ToHex(digest, sizeof(digest));
+}
+
+// 断点信息保存在 NVS 的 ota 命名空间：目标版本、分区、已写入偏移和已写入部分的 SHA-256
+static void SaveCheckpoint(const std::string& version, const esp_partition_t* partition, size_t offset,
+    const mbedtls_sha256_context* sha256) {
+    Settings settings("ota", true);
+    settings.SetString("version", version);
+    settings.SetString("partition", partition->label);
+    settings.SetString("sha256", GetSha256Hex(sha256));
+    settings.SetInt("offset", offset);
+    // 断点要在掉电前落盘，不等延迟提交
+    Settings::Flush();
+    ESP_LOGI(TAG, "Checkpoint saved at offset %zu", offset);
+}
+
+static void ClearCheckpoint() {
+    Settings settings("ota", true);
+    settings.EraseAll();
+}
+
+// 校验已写入分区的数据与断点记录一致，返回可续传的偏移，并把已写入部分累加进 sha256
+static size_t LoadCheckpoint(const std::string& version, const esp_partition_t* partition,
+    mbedtls_sha256_context* sha256) {
+    Settings settings("ota");
+    size_t offset = settings.GetInt("offset", 0);
+    if (offset == 0 || offset % OTA_SECTOR_SIZE != 0 || offset > partition->size ||
+        settings.GetString("version") != version || settings.GetString("partition") != partition->label) {
+        return 0;
+    }
+
+    std::vector<uint8_t> buffer(OTA_SECTOR_SIZE);
+    for (size_t position = 0; position < offset; position += buffer.size()) {
+        if (esp_partition_read(partition, position, buffer.data(), buffer.size()) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read partition at %zu", position);
+            mbedtls_sha256_starts(sha256, 0);
+            return 0;
+        }
+        mbedtls_sha256_update(sha256, buffer.data(), buffer.size());
+    }
+    if (GetSha256Hex(sha256) != settings.GetString("sha256")) {
+        ESP_LOGW(TAG, "Checkpoint hash mismatch, restart from the beginning");
+        mbedtls_sha256_starts(sha256, 0);
+        return 0;
+    }
+    ESP_LOGI(TAG, "Resuming upgrade of %s from offset %zu", version.c_str(), offset);
+    return offset;
+}
+
+// 写 flash 任务：从环形缓冲区取出数据块，解码后写入 OTA 分区，与网络接收并行
+struct FlashWriterContext {
+    OtaRingBuffer* ring;
+    const esp_partition_t* partition;
+    const std::string* version;
+    OtaDecoder* decoder;
+    size_t chunk_size;
+    size_t offset;
+    mbedtls_sha256_context* sha256;
+    esp_err_t result = ESP_OK;
+    size_t written = 0;
+    size_t erased_end = 0;
+    size_t last_checkpoint = 0;
+    int64_t flash_time_us = 0;
+    // offset 的副本，供下载任务打印进度
+    std::atomic<size_t> flashed = 0;
+    SemaphoreHandle_t done = nullptr;
+};
+
+// 写入还原后的镜像数据：首块检查版本，按需擦除扇区，累加 SHA-256，原始镜像定期保存断点
+static bool WriteImage(FlashWriterContext* context, const uint8_t* data, size_t length) {
+    if (context->offset == 0) {
+        if (length < OTA_IMAGE_HEADER_SIZE) {
+            ESP_LOGE(TAG, "Image header is too short");
+            context->result = ESP_ERR_INVALID_SIZE;
+            return false;
+        }
+        esp_app_desc_t new_app_info;
+        memcpy(&new_app_info, data + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
+        ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
+
+        auto current_version = esp_app_get_description()->version;
+        if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
+            ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
+            context->result = ESP_ERR_INVALID_VERSION;
+            return false;
+        }
+    }
+
+    if (context->offset + length > context->partition->size) {
+        ESP_LOGE(TAG, "Image is larger than partition %s", context->partition->label);
+        context->result = ESP_ERR_INVALID_SIZE;
+        return false;
+    }
+
+    auto start_time = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (context->offset + length > context->erased_end) {
+        size_t erase_end = (context->offset + length + OTA_SECTOR_SIZE - 1) / OTA_SECTOR_SIZE * OTA_SECTOR_SIZE;
+        erase_end = std::min<size_t>(erase_end, context->partition->size);
+        err = esp_partition_erase_range(context->partition, context->erased_end, erase_end - context->erased_end);
+        context->erased_end = erase_end;
+    }
+    if (err == ESP_OK) {
+        err = esp_partition_write(context->partition, context->offset, data, length);
+    }
+    context->flash_time_us += esp_timer_get_time() - start_time;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
+        context->result = err;
+        return false;
+    }
+
+    mbedtls_sha256_update(context->sha256, data, length);
+    context->offset += length;
+    context->written += length;
+    context->flashed = context->offset;
+    if (context->decoder == nullptr && context->offset % OTA_SECTOR_SIZE == 0 &&
+        context->offset - context->last_checkpoint >= CONFIG_OTA_CHECKPOINT_INTERVAL * 1024) {
+        SaveCheckpoint(*context->version, context->partition, context->offset, context->sha256);
+        context->last_checkpoint = context->offset;
+    }
+    return true;
+}
+
+static void FlashWriterTask(void* arg) {
+    auto context = (FlashWriterContext*)arg;
+    auto chunk = (uint8_t*)malloc(context->chunk_size);
+    if (chunk == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate flash write chunk");
+        context->result = ESP_ERR_NO_MEM;
+        context->ring->Cancel();
+    }
+
+    // Decoded data comes in arbitrary sizes, write it to flash in whole chunks
+    std::vector<uint8_t> pending;
+    auto sink = [context, &pending](const uint8_t* data, size_t length) {
+        pending.insert(pending.end(), data, data + length);
+        size_t position = 0;
+        while (pending.size() - position >= context->chunk_size) {
+            if (!WriteImage(context, pending.data() + position, context->chunk_size)) {
+                return false;
+            }
+            position += context->chunk_size;
+        }
+        pending.erase(pending.begin(), pending.begin() + position);
+        return true;
+    };
+
+    context->erased_end = context->offset;
+    context->last_checkpoint = context->offset;
+    while (chunk != nullptr) {
+        size_t length = context->ring->Read((char*)chunk, context->chunk_size);
+        if (length == 0) {
+            break;
+        }
+        bool ok;
+        if (context->decoder != nullptr) {
+            ok = context->decoder->Decode(chunk, length, sink);
+        } else {
+            ok = WriteImage(context, chunk, length);
+        }
+        if (!ok) {
+            if (context->result == ESP_OK) {
+                context->result = ESP_ERR_INVALID_RESPONSE;
+            }
+            context->ring->Cancel();
+            break;
+        }
+    }
+
+    if (context->decoder != nullptr && context->result == ESP_OK && !context->ring->cancelled()) {
+        bool ok = context->decoder->Finish(sink);
+        if (ok && !pending.empty()) {
+            ok = WriteImage(context, pending.data(), pending.size());
+        }
+        if (!ok && context->result == ESP_OK) {
+            context->result = ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    // Keep the progress for the next attempt if the download is interrupted
+    if (context->decoder == nullptr && context->result == ESP_OK && context->ring->cancelled() &&
+        context->offset > context->last_checkpoint && context->offset % OTA_SECTOR_SIZE == 0) {
+        SaveCheckpoint(*context->version, context->partition, context->offset, context->sha256);
+    }
+
+    free(chunk);
+    xSemaphoreGive(context->done);
+    vTaskDelete(NULL);
+}
+
 void Ota::Upgrade(const std::string& firmware_url) {
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
-    esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
         ESP_LOGE(TAG, "Failed to get update partition");
         return;
     }
-
     ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
-    bool image_header_checked = false;
-    std::string image_header;
 
-    auto http = Board::GetInstance().CreateHttp();
-    if (!http->Open("GET", firmware_url)) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection");
-        delete http;
+    bool supported;
+    auto decoder = CreateOtaDecoder(firmware_encoding_, esp_ota_get_running_partition(), supported);
+    if (!supported) {
+        ESP_LOGE(TAG, "Unsupported firmware encoding: %s", firmware_encoding_.c_str());
         return;
     }
 
-    size_t content_length = http->GetBodyLength();
-    if (content_length == 0) {
-        ESP_LOGE(TAG, "Failed to get content length");
-        delete http;
-        return;
+    // The decoder state does not survive a reboot, so only raw images are resumed from a checkpoint
+    mbedtls_sha256_context sha256;
+    mbedtls_sha256_init(&sha256);
+    mbedtls_sha256_starts(&sha256, 0);
+    size_t resume_offset = 0;
+    if (decoder == nullptr) {
+        resume_offset = LoadCheckpoint(firmware_version_, update_partition, &sha256);
+    } else {
+        ESP_LOGI(TAG, "Firmware encoding: %s", firmware_encoding_.c_str());
     }
 
-    char buffer[512];
-    size_t total_read = 0, recent_read = 0;
-    auto last_calc_time = esp_timer_get_time();
-    while (true) {
-        int ret = http->Read(buffer, sizeof(buffer));
-        if (ret < 0) {
-            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
-            delete http;
-            return;
-        }
+    OtaRingBuffer ring(CONFIG_OTA_RING_BUFFER_SIZE * 1024);
+    if (!ring.valid()) {
+        ESP_LOGE(TAG, "Failed to allocate OTA ring buffer");
+        mbedtls_sha256_free(&sha256);
+        return;
+    }
 
-        // Calculate speed and progress every second
-        recent_read += ret;
-        total_read += ret;
-        if (esp_timer_get_time() - last_calc_time >= 1000000 || ret == 0) {
-            size_t progress = total_read * 100 / content_length;
-            ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s", progress, total_read, content_length, recent_read);
-            if (upgrade_callback_) {
-                upgrade_callback_(progress, recent_read);
-            }
-            last_calc_time = esp_timer_get_time();
-            recent_read = 0;
+    FlashWriterContext writer = {
+        .ring = &ring,
+        .partition = update_partition,
+        .version = &firmware_version_,
+        .decoder = decoder.get(),
+        .chunk_size = CONFIG_OTA_FLASH_WRITE_CHUNK_SIZE,
+        .offset = resume_offset,
+        .sha256 = &sha256,
+    };
+    writer.flashed = resume_offset;
+    writer.done = xSemaphoreCreateBinary();
+    if (writer.done == nullptr ||
+        xTaskCreate(FlashWriterTask, "ota_flash_writer", 4096 * 2, &writer, 3, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create OTA flash writer task");
+        if (writer.done != nullptr) {
+            vSemaphoreDelete(writer.done);
         }
+        mbedtls_sha256_free(&sha256);
+        return;
+    }
 
-        if (ret == 0) {
-            break;
+    std::vector<char> buffer(CONFIG_OTA_NETWORK_READ_SIZE);
+    size_t received = resume_offset, content_length = 0, recent_read = 0;
+    auto start_time = esp_timer_get_time();
+    auto last_calc_time = start_time;
+    const int max_retry = 5;
+    int retry_count = 0;
+    bool finished = false, failed = false;
+
+    while (!finished && !failed) {
+        auto http = std::unique_ptr<Http>(Board::GetInstance().CreateHttp());
+        if (received > 0) {
+            http->SetHeader("Range", "bytes=" + std::to_string(received) + "-");
         }
+        if (http->Open("GET", firmware_url)) {
+            // The server may ignore the Range header, drop the bytes we already have in that case
+            size_t skip = 0;
+            size_t body_length = http->GetBodyLength();
+            int status_code = http->GetStatusCode();
+            if (status_code == 206) {
+                content_length = received + body_length;
+            } else if (status_code == 200) {
+                content_length = body_length;
+                skip = received;
+            } else if (status_code == 416 && received > 0) {
+                // Everything was downloaded before the interruption
+                finished = true;
+            } else {
+                ESP_LOGE(TAG, "Unexpected HTTP status: %d", status_code);
+            }
+            if ((status_code == 200 || status_code == 206) && body_length == 0) {
+                ESP_LOGE(TAG, "Failed to get content length");
+                failed = true;
+            } else if (decoder == nullptr && content_length > update_partition->size) {
+                ESP_LOGE(TAG, "Image size %zu exceeds partition size", content_length);
+                failed = true;
+            }
 
-        if (!image_header_checked) {
-            image_header.append(buffer, ret);
-            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
-                esp_app_desc_t new_app_info;
-                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
-                ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
-
-                auto current_version = esp_app_get_description()->version;
-                if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
-                    ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
-                    delete http;
-                    return;
+            while ((status_code == 200 || status_code == 206) && !failed) {
+                int ret = http->Read(buffer.data(), buffer.size());
+                if (ret < 0) {
+                    ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
+                    break;
+                }
+                if (ret == 0) {
+                    finished = content_length > 0 && received >= content_length;
+                    break;
                 }
 
-                if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
-                    esp_ota_abort(update_handle);
-                    delete http;
-                    ESP_LOGE(TAG, "Failed to begin OTA");
-                    return;
+                const char* data = buffer.data();
+                size_t length = ret;
+                if (skip > 0) {
+                    size_t count = std::min(skip, length);
+                    skip -= count;
+                    data += count;
+                    length -= count;
+                }
+                received += length;
+                recent_read += length;
+                retry_count = 0;
+                if (length > 0 && !ring.Write(data, length)) {
+                    failed = true;
+                    break;
                 }
 
-                image_header_checked = true;
-                std::string().swap(image_header);
+                // Calculate speed and progress every second
+                if (esp_timer_get_time() - last_calc_time >= 1000000) {
+                    size_t progress = received * 100 / content_length;
+                    ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s, Flash: %zu", progress, received, content_length,
+                        recent_read, writer.flashed.load());
+                    if (upgrade_callback_) {
+                        upgrade_callback_(progress, recent_read);
+                    }
+                    last_calc_time = esp_timer_get_time();
+                    recent_read = 0;
+                }
             }
+        } else {
+            ESP_LOGE(TAG, "Failed to open HTTP connection");
         }
-        auto err = esp_ota_write(update_handle, buffer, ret);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
-            esp_ota_abort(update_handle);
-            delete http;
-            return;
+        http.reset();
+
+        if (!finished && !failed) {
+            if (++retry_count > max_retry) {
+                ESP_LOGE(TAG, "Too many retries, giving up at offset %zu", received);
+                failed = true;
+            } else {
+                ESP_LOGW(TAG, "Download interrupted at %zu, resuming in %d seconds (%d/%d)", received, 3 * retry_count,
+                    retry_count, max_retry);
+                vTaskDelay(pdMS_TO_TICKS(3000 * retry_count));
+            }
         }
     }
-    delete http;
 
-    esp_err_t err = esp_ota_end(update_handle);
+    if (finished) {
+        ring.Finish();
+    } else {
+        ring.Cancel();
+    }
+    xSemaphoreTake(writer.done, portMAX_DELAY);
+    vSemaphoreDelete(writer.done);
+
+    auto elapsed_us = std::max<int64_t>(esp_timer_get_time() - start_time, 1);
+    ESP_LOGI(TAG, "OTA stats: received %zu written %zu in %lldms, avg %lluB/s, flash busy %lldms, "
+        "network stalled %lldms, flash idle %lldms", received - resume_offset, writer.written, elapsed_us / 1000,
+        (uint64_t)(received - resume_offset) * 1000000 / elapsed_us, writer.flash_time_us / 1000,
+        ring.producer_wait_us() / 1000, ring.consumer_wait_us() / 1000);
+
+    std::string image_sha256 = GetSha256Hex(&sha256);
+    mbedtls_sha256_free(&sha256);
+    if (!finished || writer.result != ESP_OK) {
+        return;
+    }
+
+    if (!firmware_sha256_.empty() && strcasecmp(image_sha256.c_str(), firmware_sha256_.c_str()) != 0) {
+        ESP_LOGE(TAG, "SHA-256 mismatch, expected %s got %s", firmware_sha256_.c_str(), image_sha256.c_str());
+        ClearCheckpoint();
+        return;
+    }
+
+    // esp_ota_set_boot_partition verifies the image before switching
+    esp_err_t err = esp_ota_set_boot_partition(update_partition);
+    ClearCheckpoint();
     if (err != ESP_OK) {
         if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
             ESP_LOGE(TAG, "Image validation failed, image is corrupted");
         } else {
-            ESP_LOGE(TAG, "Failed to end OTA: %s", esp_err_to_name(err));
+            ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
         }
         return;
     }
 
-    err = esp_ota_set_boot_partition(update_partition);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
-        return;
-    }
-
     ESP_LOGI(TAG, "Firmware upgrade successful, rebooting in 3 seconds...");
     vTaskDelay(pdMS_TO_TICKS(3000));
     esp_restart();
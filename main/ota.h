@@ -37,6 +37,8 @@ private:
     std::string current_version_;
     std::string firmware_version_;
     std::string firmware_url_;
+    std::string firmware_sha256_;
+    std::string firmware_encoding_;
     std::string post_data_;
     std::map<std::string, std::string> headers_;
 
@@ -0,0 +1,336 @@
+#include "ota_decoder.h"
+#include "memory_tracker.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <mbedtls/sha256.h>
+
+#include <cstring>
+#include <algorithm>
+
+#define TAG "OtaDecoder"
+
+#define LZ_HEADER_SIZE 12
+#define LZ_MIN_MATCH 4
+#define LZ_OUTPUT_SIZE 4096
+#define DELTA_COPY_SIZE 4096
+
+static uint32_t ReadU32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+LzDecoder::LzDecoder() {
+    output_.reserve(LZ_OUTPUT_SIZE);
+}
+
+LzDecoder::~LzDecoder() {
+    MemoryTracker::GetInstance().Free(window_);
+}
+
+void LzDecoder::Emit(uint8_t byte) {
+    window_[position_ & window_mask_] = byte;
+    position_++;
+    output_.push_back(byte);
+}
+
+bool LzDecoder::Flush(const Sink& sink) {
+    if (output_.empty()) {
+        return true;
+    }
+    bool ok = sink(output_.data(), output_.size());
+    output_.clear();
+    if (!ok) {
+        state_ = kStateError;
+    }
+    return ok;
+}
+
+bool LzDecoder::CopyMatch(const Sink& sink) {
+    if (offset_ == 0 || offset_ > window_mask_ + 1 || offset_ > position_ || position_ + match_length_ > image_size_) {
+        ESP_LOGE(TAG, "Invalid match at %zu: offset %zu length %zu", position_, offset_, match_length_);
+        state_ = kStateError;
+        return false;
+    }
+    for (size_t i = 0; i < match_length_; i++) {
+        Emit(window_[(position_ - offset_) & window_mask_]);
+        if (output_.size() >= LZ_OUTPUT_SIZE && !Flush(sink)) {
+            return false;
+        }
+    }
+    state_ = position_ >= image_size_ ? kStateDone : kStateToken;
+    return true;
+}
+
+bool LzDecoder::Decode(const uint8_t* data, size_t length, const Sink& sink) {
+    size_t i = 0;
+    while (i < length && state_ != kStateError) {
+        switch (state_) {
+        case kStateHeader:
+            header_[header_size_++] = data[i++];
+            if (header_size_ == LZ_HEADER_SIZE) {
+                int window_bits = header_[5];
+                if (memcmp(header_, "XZLZ", 4) != 0 || header_[4] != 1 || window_bits < 8 || window_bits > 16) {
+                    ESP_LOGE(TAG, "Invalid LZ header");
+                    state_ = kStateError;
+                    break;
+                }
+                size_t window_size = 1 << window_bits;
+                auto& tracker = MemoryTracker::GetInstance();
+                window_ = (uint8_t*)tracker.Malloc(kMemoryTagOta, window_size, MALLOC_CAP_SPIRAM);
+                if (window_ == nullptr) {
+                    window_ = (uint8_t*)tracker.Malloc(kMemoryTagOta, window_size, MALLOC_CAP_8BIT);
+                }
+                if (window_ == nullptr) {
+                    ESP_LOGE(TAG, "Failed to allocate LZ window");
+                    state_ = kStateError;
+                    break;
+                }
+                window_mask_ = window_size - 1;
+                image_size_ = ReadU32(header_ + 8);
+                ESP_LOGI(TAG, "LZ stream: window %zu, image size %zu", window_size, image_size_);
+                state_ = image_size_ == 0 ? kStateDone : kStateToken;
+            }
+            break;
+        case kStateToken: {
+            uint8_t token = data[i++];
+            literal_length_ = token >> 4;
+            match_length_ = (token & 0x0f) + LZ_MIN_MATCH;
+            state_ = literal_length_ == 15 ? kStateLiteralLength : kStateLiterals;
+            break;
+        }
+        case kStateLiteralLength:
+            literal_length_ += data[i];
+            if (data[i++] != 255) {
+                state_ = kStateLiterals;
+            }
+            break;
+        case kStateLiterals: {
+            size_t count = std::min(literal_length_, length - i);
+            if (position_ + count > image_size_) {
+                ESP_LOGE(TAG, "Literals overflow the image");
+                state_ = kStateError;
+                break;
+            }
+            for (size_t j = 0; j < count; j++) {
+                Emit(data[i + j]);
+            }
+            i += count;
+            literal_length_ -= count;
+            break;
+        }
+        case kStateOffsetLow:
+            offset_ = data[i++];
+            state_ = kStateOffsetHigh;
+            break;
+        case kStateOffsetHigh:
+            offset_ |= data[i++] << 8;
+            if (match_length_ == 15 + LZ_MIN_MATCH) {
+                state_ = kStateMatchLength;
+            } else {
+                CopyMatch(sink);
+            }
+            break;
+        case kStateMatchLength:
+            match_length_ += data[i];
+            if (data[i++] != 255) {
+                CopyMatch(sink);
+            }
+            break;
+        case kStateDone:
+            ESP_LOGE(TAG, "Unexpected data after the end of the LZ stream");
+            state_ = kStateError;
+            break;
+        default:
+            break;
+        }
+
+        // A sequence may end with literals only, the last one always does
+        if (state_ == kStateLiterals && literal_length_ == 0) {
+            state_ = position_ >= image_size_ ? kStateDone : kStateOffsetLow;
+        }
+        if (output_.size() >= LZ_OUTPUT_SIZE) {
+            Flush(sink);
+        }
+    }
+    return state_ != kStateError && Flush(sink);
+}
+
+bool LzDecoder::Finish(const Sink& sink) {
+    if (state_ == kStateError || !Flush(sink)) {
+        return false;
+    }
+    if (state_ != kStateDone) {
+        ESP_LOGE(TAG, "LZ stream truncated at %zu/%zu", position_, image_size_);
+        return false;
+    }
+    return true;
+}
+
+DeltaDecoder::DeltaDecoder(const esp_partition_t* base_partition) : base_partition_(base_partition) {
+}
+
+bool DeltaDecoder::VerifyBase() {
+    if (base_partition_ == nullptr || base_size_ > base_partition_->size) {
+        ESP_LOGE(TAG, "Delta base does not fit the running partition");
+        return false;
+    }
+
+    mbedtls_sha256_context sha256;
+    mbedtls_sha256_init(&sha256);
+    mbedtls_sha256_starts(&sha256, 0);
+    copy_buffer_.resize(DELTA_COPY_SIZE);
+    bool ok = true;
+    for (size_t position = 0; position < base_size_ && ok; position += copy_buffer_.size()) {
+        size_t count = std::min(copy_buffer_.size(), base_size_ - position);
+        ok = esp_partition_read(base_partition_, position, copy_buffer_.data(), count) == ESP_OK;
+        mbedtls_sha256_update(&sha256, copy_buffer_.data(), count);
+    }
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha256, digest);
+    mbedtls_sha256_free(&sha256);
+
+    if (!ok || memcmp(digest, base_sha256_, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "Delta base mismatch, the patch was not made for the running firmware");
+        return false;
+    }
+    ESP_LOGI(TAG, "Delta base verified: %zu bytes from %s, image size %zu", base_size_, base_partition_->label, image_size_);
+    return true;
+}
+
+bool DeltaDecoder::CopyFromBase(size_t offset, size_t length, const Sink& sink) {
+    while (length > 0) {
+        size_t count = std::min(copy_buffer_.size(), length);
+        if (esp_partition_read(base_partition_, offset, copy_buffer_.data(), count) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read base partition at %zu", offset);
+            return false;
+        }
+        if (!sink(copy_buffer_.data(), count)) {
+            return false;
+        }
+        offset += count;
+        length -= count;
+        written_ += count;
+    }
+    return true;
+}
+
+bool DeltaDecoder::Decode(const uint8_t* data, size_t length, const Sink& sink) {
+    size_t i = 0;
+    while (i < length && state_ != kStateError) {
+        switch (state_) {
+        case kStateHeader:
+        case kStateArguments: {
+            size_t count = std::min(arguments_needed_ - arguments_size_, length - i);
+            memcpy(arguments_ + arguments_size_, data + i, count);
+            arguments_size_ += count;
+            i += count;
+            if (arguments_size_ < arguments_needed_) {
+                break;
+            }
+
+            if (state_ == kStateHeader) {
+                if (memcmp(arguments_, "XZDP", 4) != 0 || arguments_[4] != 1) {
+                    ESP_LOGE(TAG, "Invalid delta header");
+                    state_ = kStateError;
+                    break;
+                }
+                base_size_ = ReadU32(arguments_ + 8);
+                memcpy(base_sha256_, arguments_ + 12, sizeof(base_sha256_));
+                image_size_ = ReadU32(arguments_ + 44);
+                state_ = VerifyBase() ? kStateOpcode : kStateError;
+            } else if (opcode_ == 'C') {
+                size_t offset = ReadU32(arguments_);
+                size_t count = ReadU32(arguments_ + 4);
+                if (offset + count > base_size_ || written_ + count > image_size_) {
+                    ESP_LOGE(TAG, "Invalid copy: offset %zu length %zu", offset, count);
+                    state_ = kStateError;
+                    break;
+                }
+                state_ = CopyFromBase(offset, count, sink) ? kStateOpcode : kStateError;
+            } else {
+                remaining_ = ReadU32(arguments_);
+                if (written_ + remaining_ > image_size_) {
+                    ESP_LOGE(TAG, "Invalid insert: length %zu", remaining_);
+                    state_ = kStateError;
+                    break;
+                }
+                state_ = remaining_ > 0 ? kStateInsert : kStateOpcode;
+            }
+            break;
+        }
+        case kStateOpcode:
+            opcode_ = data[i++];
+            arguments_size_ = 0;
+            if (opcode_ == 'C') {
+                arguments_needed_ = 8;
+                state_ = kStateArguments;
+            } else if (opcode_ == 'I') {
+                arguments_needed_ = 4;
+                state_ = kStateArguments;
+            } else if (opcode_ == 'E') {
+                state_ = kStateDone;
+            } else {
+                ESP_LOGE(TAG, "Invalid delta opcode: 0x%02x", opcode_);
+                state_ = kStateError;
+            }
+            break;
+        case kStateInsert: {
+            size_t count = std::min(remaining_, length - i);
+            if (!sink(data + i, count)) {
+                state_ = kStateError;
+                break;
+            }
+            i += count;
+            remaining_ -= count;
+            written_ += count;
+            if (remaining_ == 0) {
+                state_ = kStateOpcode;
+            }
+            break;
+        }
+        case kStateDone:
+            ESP_LOGE(TAG, "Unexpected data after the end of the delta patch");
+            state_ = kStateError;
+            break;
+        default:
+            break;
+        }
+    }
+    return state_ != kStateError;
+}
+
+bool DeltaDecoder::Finish(const Sink& sink) {
+    if (state_ != kStateDone || written_ != image_size_) {
+        ESP_LOGE(TAG, "Delta patch truncated at %zu/%zu", written_, image_size_);
+        return false;
+    }
+    return true;
+}
+
+bool ChainedDecoder::Decode(const uint8_t* data, size_t length, const Sink& sink) {
+    return outer_->Decode(data, length, [this, &sink](const uint8_t* data, size_t length) {
+        return inner_->Decode(data, length, sink);
+    });
+}
+
+bool ChainedDecoder::Finish(const Sink& sink) {
+    bool ok = outer_->Finish([this, &sink](const uint8_t* data, size_t length) {
+        return inner_->Decode(data, length, sink);
+    });
+    return ok && inner_->Finish(sink);
+}
+
+std::unique_ptr<OtaDecoder> CreateOtaDecoder(const std::string& encoding, const esp_partition_t* base_partition, bool& supported) {
+    supported = true;
+    if (encoding.empty() || encoding == "raw") {
+        return nullptr;
+    } else if (encoding == "lz") {
+        return std::make_unique<LzDecoder>();
+    } else if (encoding == "delta") {
+        return std::make_unique<DeltaDecoder>(base_partition);
+    } else if (encoding == "delta+lz") {
+        return std::make_unique<ChainedDecoder>(std::make_unique<LzDecoder>(), std::make_unique<DeltaDecoder>(base_partition));
+    }
+    supported = false;
+    return nullptr;
+}
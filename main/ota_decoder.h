@@ -0,0 +1,120 @@
+#ifndef _OTA_DECODER_H
+#define _OTA_DECODER_H
+
+#include <esp_partition.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 把下载到的固件流还原成应用镜像，数据可以任意分块输入
+// 输出的镜像数据通过 sink 回调交给写 flash 的一方，sink 返回 false 时中止解码
+class OtaDecoder {
+public:
+    using Sink = std::function<bool(const uint8_t* data, size_t length)>;
+
+    virtual ~OtaDecoder() = default;
+    virtual bool Decode(const uint8_t* data, size_t length, const Sink& sink) = 0;
+    // 输入已结束，返回数据流是否完整
+    virtual bool Finish(const Sink& sink) = 0;
+};
+
+// 小窗口 LZ77 压缩流，格式由 scripts/ota_pack.py 生成：
+//   header: "XZLZ" | u8 version | u8 window_bits | u16 reserved | u32 image_size
+//   序列与 LZ4 相同：token(高 4 位字面量长度, 低 4 位匹配长度 - 4) | 扩展长度 | 字面量 | u16 偏移 | 扩展长度
+class LzDecoder : public OtaDecoder {
+public:
+    LzDecoder();
+    ~LzDecoder();
+
+    bool Decode(const uint8_t* data, size_t length, const Sink& sink) override;
+    bool Finish(const Sink& sink) override;
+
+private:
+    enum State {
+        kStateHeader,
+        kStateToken,
+        kStateLiteralLength,
+        kStateLiterals,
+        kStateOffsetLow,
+        kStateOffsetHigh,
+        kStateMatchLength,
+        kStateDone,
+        kStateError
+    };
+
+    State state_ = kStateHeader;
+    uint8_t header_[12];
+    size_t header_size_ = 0;
+    uint8_t* window_ = nullptr;
+    size_t window_mask_ = 0;
+    size_t position_ = 0;
+    size_t image_size_ = 0;
+    size_t literal_length_ = 0;
+    size_t match_length_ = 0;
+    size_t offset_ = 0;
+    std::vector<uint8_t> output_;
+
+    void Emit(uint8_t byte);
+    bool Flush(const Sink& sink);
+    bool CopyMatch(const Sink& sink);
+};
+
+// 以当前运行分区为基准的差分补丁，格式由 scripts/ota_pack.py 生成：
+//   header: "XZDP" | u8 version | u8[3] reserved | u32 base_size | u8[32] base_sha256 | u32 image_size
+//   指令: 'C' u32 base_offset u32 length | 'I' u32 length bytes... | 'E'
+class DeltaDecoder : public OtaDecoder {
+public:
+    DeltaDecoder(const esp_partition_t* base_partition);
+
+    bool Decode(const uint8_t* data, size_t length, const Sink& sink) override;
+    bool Finish(const Sink& sink) override;
+
+private:
+    enum State {
+        kStateHeader,
+        kStateOpcode,
+        kStateArguments,
+        kStateInsert,
+        kStateDone,
+        kStateError
+    };
+
+    const esp_partition_t* base_partition_;
+    State state_ = kStateHeader;
+    uint8_t opcode_ = 0;
+    uint8_t arguments_[48];
+    size_t arguments_size_ = 0;
+    size_t arguments_needed_ = 48;
+    size_t remaining_ = 0;
+    size_t base_size_ = 0;
+    uint8_t base_sha256_[32];
+    size_t image_size_ = 0;
+    size_t written_ = 0;
+    std::vector<uint8_t> copy_buffer_;
+
+    bool VerifyBase();
+    bool CopyFromBase(size_t offset, size_t length, const Sink& sink);
+};
+
+// 串联两个解码器，例如 "delta+lz" 先解压再应用补丁
+class ChainedDecoder : public OtaDecoder {
+public:
+    ChainedDecoder(std::unique_ptr<OtaDecoder> outer, std::unique_ptr<OtaDecoder> inner)
+        : outer_(std::move(outer)), inner_(std::move(inner)) {}
+
+    bool Decode(const uint8_t* data, size_t length, const Sink& sink) override;
+    bool Finish(const Sink& sink) override;
+
+private:
+    std::unique_ptr<OtaDecoder> outer_;
+    std::unique_ptr<OtaDecoder> inner_;
+};
+
+// encoding 为版本检查返回的 firmware.encoding："raw" / "lz" / "delta" / "delta+lz"
+// raw 返回空指针；无法识别的编码 supported 置为 false
+std::unique_ptr<OtaDecoder> CreateOtaDecoder(const std::string& encoding, const esp_partition_t* base_partition, bool& supported);
+
+#endif // _OTA_DECODER_H
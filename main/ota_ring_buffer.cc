@@ -0,0 +1,92 @@
+#include "ota_ring_buffer.h"
+#include "memory_tracker.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#include <cstring>
+#include <algorithm>
+
+#define TAG "OtaRingBuffer"
+
+OtaRingBuffer::OtaRingBuffer(size_t size) : size_(size) {
+    auto& tracker = MemoryTracker::GetInstance();
+    buffer_ = (uint8_t*)tracker.Malloc(kMemoryTagOta, size, MALLOC_CAP_SPIRAM);
+    if (buffer_ == nullptr) {
+        ESP_LOGW(TAG, "Failed to allocate %zu bytes in PSRAM, fallback to internal memory", size);
+        buffer_ = (uint8_t*)tracker.Malloc(kMemoryTagOta, size, MALLOC_CAP_8BIT);
+    }
+}
+
+OtaRingBuffer::~OtaRingBuffer() {
+    MemoryTracker::GetInstance().Free(buffer_);
+}
+
+bool OtaRingBuffer::Write(const char* data, size_t length) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (length > 0) {
+        if (used_ == size_ && !cancelled_) {
+            auto start_time = esp_timer_get_time();
+            condition_variable_.wait(lock, [this]() { return used_ < size_ || cancelled_; });
+            producer_wait_us_ += esp_timer_get_time() - start_time;
+        }
+        if (cancelled_) {
+            return false;
+        }
+
+        size_t count = std::min(length, size_ - used_);
+        count = std::min(count, size_ - head_);
+        memcpy(buffer_ + head_, data, count);
+        head_ = (head_ + count) % size_;
+        used_ += count;
+        data += count;
+        length -= count;
+        condition_variable_.notify_all();
+    }
+    return true;
+}
+
+size_t OtaRingBuffer::Read(char* data, size_t length) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t total = 0;
+    while (total < length) {
+        if (used_ == 0 && !finished_ && !cancelled_) {
+            auto start_time = esp_timer_get_time();
+            condition_variable_.wait(lock, [this]() { return used_ > 0 || finished_ || cancelled_; });
+            consumer_wait_us_ += esp_timer_get_time() - start_time;
+        }
+        if (cancelled_) {
+            return 0;
+        }
+        if (used_ == 0 && finished_) {
+            break;
+        }
+
+        size_t count = std::min(length - total, used_);
+        count = std::min(count, size_ - tail_);
+        memcpy(data + total, buffer_ + tail_, count);
+        tail_ = (tail_ + count) % size_;
+        used_ -= count;
+        total += count;
+        condition_variable_.notify_all();
+    }
+    return total;
+}
+
+void OtaRingBuffer::Finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    condition_variable_.notify_all();
+}
+
+void OtaRingBuffer::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    condition_variable_.notify_all();
+}
+
+bool OtaRingBuffer::cancelled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
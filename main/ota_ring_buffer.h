@@ -0,0 +1,45 @@
+#ifndef _OTA_RING_BUFFER_H
+#define _OTA_RING_BUFFER_H
+
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+// 下载任务与写 flash 任务之间的单生产者/单消费者环形缓冲区，优先分配在 PSRAM
+class OtaRingBuffer {
+public:
+    OtaRingBuffer(size_t size);
+    ~OtaRingBuffer();
+
+    bool valid() const { return buffer_ != nullptr; }
+    size_t size() const { return size_; }
+
+    // 阻塞直到全部写入，缓冲区被取消时返回 false
+    bool Write(const char* data, size_t length);
+    // 阻塞直到读满 length 字节或输入结束，返回实际读取的字节数，取消时返回 0
+    size_t Read(char* data, size_t length);
+    // 生产者数据已全部写入
+    void Finish();
+    // 任意一端出错时调用，唤醒并终止另一端
+    void Cancel();
+    bool cancelled();
+
+    int64_t producer_wait_us() const { return producer_wait_us_; }
+    int64_t consumer_wait_us() const { return consumer_wait_us_; }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    uint8_t* buffer_ = nullptr;
+    size_t size_ = 0;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    size_t used_ = 0;
+    bool finished_ = false;
+    bool cancelled_ = false;
+    int64_t producer_wait_us_ = 0;
+    int64_t consumer_wait_us_ = 0;
+};
+
+#endif // _OTA_RING_BUFFER_H
@@ -4,6 +4,7 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <ml307_mqtt.h>
 #include <ml307_udp.h>
 #include <cstring>
@@ -118,7 +119,9 @@ void MqttProtocol::SendAudio(const std::vector<uint8_t>& data) {
 
     std::string nonce(aes_nonce_);
     *(uint16_t*)&nonce[2] = htons(data.size());
+    *(uint32_t*)&nonce[8] = htonl(local_timestamp_);
     *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
+    local_timestamp_ += uplink_frame_duration_;
 
     std::string encrypted;
     encrypted.resize(aes_nonce_.size() + data.size());
@@ -131,7 +134,15 @@ void MqttProtocol::SendAudio(const std::vector<uint8_t>& data) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return;
     }
+    auto start_time = esp_timer_get_time();
     udp_->Send(encrypted);
+    send_time_us_ += esp_timer_get_time() - start_time;
+    sent_packets_++;
+}
+
+void MqttProtocol::SkipAudio(int duration_ms) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    local_timestamp_ += duration_ms;
 }
 
 void MqttProtocol::CloseAudioChannel() {
@@ -164,6 +175,7 @@ bool MqttProtocol::OpenAudioChannel() {
 
     error_occurred_ = false;
     session_id_ = "";
+    uplink_frame_duration_ = OPUS_FRAME_DURATION_MS;
     xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 
     // 发送 hello 消息申请 UDP 通道
@@ -171,9 +183,8 @@ bool MqttProtocol::OpenAudioChannel() {
     message += "\"type\":\"hello\",";
     message += "\"version\": 3,";
     message += "\"transport\":\"udp\",";
-    message += "\"audio_params\":{";
-    message += "\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" + std::to_string(OPUS_FRAME_DURATION_MS);
-    message += "}}";
+    message += "\"audio_params\":" + GetAudioParamsJson();
+    message += "}";
     SendText(message);
 
     // 等待服务器响应
@@ -199,13 +210,18 @@ bool MqttProtocol::OpenAudioChannel() {
             return;
         }
         uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
-        if (sequence < remote_sequence_) {
-            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
+        // 重复和乱序到达的旧包直接丢弃，只有跳过的序号才计为丢包
+        if (sequence <= remote_sequence_) {
+            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
             return;
         }
-        if (sequence != remote_sequence_ + 1) {
+        if (sequence > remote_sequence_ + 1) {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            if (remote_sequence_ != 0) {
+                lost_packets_ += sequence - remote_sequence_ - 1;
+            }
         }
+        received_packets_++;
 
         std::vector<uint8_t> decrypted;
         size_t decrypted_size = data.size() - aes_nonce_.size();
@@ -276,6 +292,7 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
     mbedtls_aes_init(&aes_ctx_);
     mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
     local_sequence_ = 0;
+    local_timestamp_ = 0;
     remote_sequence_ = 0;
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
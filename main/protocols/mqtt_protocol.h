@@ -30,6 +30,8 @@ public:
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
+    bool CanSkipAudio() const override { return true; }
+    void SkipAudio(int duration_ms) override;
 
 private:
     EventGroupHandle_t event_group_handle_;
@@ -48,6 +50,8 @@ private:
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
+    // 上行音频的时间戳（毫秒），静音跳过的时长也计入，服务器据此识别空缺
+    uint32_t local_timestamp_;
     uint32_t remote_sequence_;
 
     bool StartMqttClient(bool report_error=false);
@@ -31,6 +31,38 @@ void Protocol::SetError(const std::string& message) {
     }
 }
 
+std::string Protocol::GetAudioParamsJson() const {
+    return "{\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" +
+        std::to_string(uplink_frame_duration_) + "}";
+}
+
+void Protocol::SetUplinkFrameDuration(int frame_duration) {
+    if (frame_duration == uplink_frame_duration_) {
+        return;
+    }
+    uplink_frame_duration_ = frame_duration;
+    if (IsAudioChannelOpened()) {
+        std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"audio_params\"";
+        message += ",\"audio_params\":" + GetAudioParamsJson() + "}";
+        SendText(message);
+    }
+}
+
+LinkStats Protocol::TakeLinkStats() {
+    LinkStats stats;
+    uint32_t received = received_packets_.exchange(0);
+    uint32_t lost = lost_packets_.exchange(0);
+    uint32_t sent = sent_packets_.exchange(0);
+    uint32_t send_time = send_time_us_.exchange(0);
+    if (received + lost > 0) {
+        stats.loss_percent = (uint64_t)lost * 100 / ((uint64_t)received + lost);
+    }
+    if (sent > 0) {
+        stats.send_latency_ms = send_time / sent / 1000;
+    }
+    return stats;
+}
+
 void Protocol::SendAbortSpeaking(AbortReason reason) {
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"abort\"";
     if (reason == kAbortReasonWakeWordDetected) {
@@ -115,6 +147,12 @@ void Protocol::SendIotStates(const std::string& states) {
     SendText(message);
 }
 
+// data 为 JSON 对象，例如内存统计报告
+void Protocol::SendDiagnostics(const std::string& name, const std::string& data) {
+    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"diagnostics\",\"name\":\"" + name + "\",\"data\":" + data + "}";
+    SendText(message);
+}
+
 bool Protocol::IsTimeout() const {
     const int kTimeoutSeconds = 120;
     auto now = std::chrono::steady_clock::now();
@@ -5,6 +5,10 @@
 #include <string>
 #include <functional>
 #include <chrono>
+#include <atomic>
+
+// 上行 Opus 的默认帧长，每次打开音频通道时从这个帧长开始
+#define OPUS_FRAME_DURATION_MS 60
 
 struct BinaryProtocol3 {
     uint8_t type;
@@ -18,6 +22,13 @@ enum AbortReason {
     kAbortReasonWakeWordDetected
 };
 
+struct LinkStats {
+    // 下行 UDP 包按序号统计的丢包率，WebSocket 为 0
+    int loss_percent = 0;
+    // 每个上行音频包的平均发送耗时
+    int send_latency_ms = 0;
+};
+
 enum ListeningMode {
     kListeningModeAutoStop,
     kListeningModeManualStop,
@@ -37,6 +48,15 @@ public:
     inline const std::string& session_id() const {
         return session_id_;
     }
+    inline int uplink_frame_duration() const {
+        return uplink_frame_duration_;
+    }
+
+    // 会话中修改上行帧长时通过 audio_params 消息通知服务器；打开新的音频通道时恢复为默认帧长，
+    // 唤醒词音频总是按默认帧长编码，要和 hello 中的帧长、UDP 时间戳的步长一致
+    void SetUplinkFrameDuration(int frame_duration);
+    // 取出当前统计窗口的链路统计并开始新的窗口
+    LinkStats TakeLinkStats();
 
     void OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
@@ -49,12 +69,17 @@ public:
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual void SendAudio(const std::vector<uint8_t>& data) = 0;
+    // 传输层能否表示上行音频中的空缺（静音期间不发送），不能时调用方应继续发送 DTX 帧
+    virtual bool CanSkipAudio() const { return false; }
+    // 跳过 duration_ms 的上行音频，后续音频包的时间戳相应后移
+    virtual void SkipAudio(int duration_ms) {}
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendIotDescriptors(const std::string& descriptors);
     virtual void SendIotStates(const std::string& states);
+    virtual void SendDiagnostics(const std::string& name, const std::string& data);
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
@@ -65,11 +90,17 @@ protected:
 
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
+    int uplink_frame_duration_ = OPUS_FRAME_DURATION_MS;
+    std::atomic<uint32_t> received_packets_ = 0;
+    std::atomic<uint32_t> lost_packets_ = 0;
+    std::atomic<uint32_t> sent_packets_ = 0;
+    std::atomic<uint32_t> send_time_us_ = 0;
     bool error_occurred_ = false;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
 
     virtual void SendText(const std::string& text) = 0;
+    std::string GetAudioParamsJson() const;
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
 };
@@ -0,0 +1,268 @@
+#include "replay_protocol.h"
+#include "debug_console.h"
+#include "settings.h"
+#include "fs_manager.h"
+#include "memory_tracker.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#define TAG "ReplayProtocol"
+
+// 下行数据都处理完后，最多再等待麦克风数据读完的时间
+#define REPLAY_INPUT_DRAIN_MS 5000
+
+static constexpr SettingKey<std::string> kReplayFileSetting("replay", "file");
+static constexpr SettingKey<int32_t> kReplaySpeedSetting("replay", "speed");
+
+ReplayProtocol* ReplayProtocol::CreateFromSettings() {
+    auto path = kReplayFileSetting.Get();
+    if (path.empty()) {
+        return nullptr;
+    }
+    int speed = kReplaySpeedSetting.Get(1);
+    // 只回放一次，立即提交，回放中途重启后恢复正常启动
+    Settings("replay", true).EraseAll();
+    Settings::Flush();
+
+    // 启动阶段 SPIFFS 可能还没有挂载，使用 assets 分区播放时根本不会挂载
+    if (fs_manager_prepare_path(path.c_str()) != ESP_OK) {
+        ESP_LOGE(TAG, "Storage partition is not available, cannot replay %s", path.c_str());
+        return nullptr;
+    }
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+        return nullptr;
+    }
+    fseek(fp, 0, SEEK_END);
+    size_t size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    auto data = (uint8_t*)MemoryTracker::GetInstance().Malloc(kMemoryTagProtocol, size, MALLOC_CAP_SPIRAM);
+    if (data == nullptr || fread(data, 1, size, fp) != size) {
+        ESP_LOGE(TAG, "Failed to load %s (%u bytes)", path.c_str(), (unsigned)size);
+        MemoryTracker::GetInstance().Free(data);
+        fclose(fp);
+        return nullptr;
+    }
+    fclose(fp);
+
+    if (!SessionLogReader(data, size).valid()) {
+        ESP_LOGE(TAG, "%s is not a session log", path.c_str());
+        MemoryTracker::GetInstance().Free(data);
+        return nullptr;
+    }
+    return new ReplayProtocol(path, data, size, speed);
+}
+
+ReplayProtocol::ReplayProtocol(const std::string& path, uint8_t* data, size_t size, int speed)
+    : path_(path), data_(data), size_(size), speed_(speed), log_(data, size), mic_(log_) {
+    input_sample_rate_ = log_.header().input_sample_rate;
+    input_channels_ = log_.header().input_channels;
+
+    auto summary = log_.Summarize();
+    server_sample_rate_ = summary.server_sample_rate;
+    server_frame_duration_ = summary.server_frame_duration;
+    recorded_ms_ = summary.recorded_ms;
+    ESP_LOGI(TAG, "Replaying %s: %lu ms, input %d Hz x %d, server %d Hz / %d ms, speed %d", path_.c_str(),
+        (unsigned long)recorded_ms_, input_sample_rate_, input_channels_, server_sample_rate_,
+        server_frame_duration_, speed_);
+}
+
+ReplayProtocol::~ReplayProtocol() {
+    MemoryTracker::GetInstance().Free(data_);
+}
+
+void ReplayProtocol::Start() {
+}
+
+bool ReplayProtocol::OpenAudioChannel() {
+    if (opened_) {
+        return true;
+    }
+    start_time_us_ = esp_timer_get_time();
+    last_incoming_time_ = std::chrono::steady_clock::now();
+    opened_ = true;
+    if (on_audio_channel_opened_ != nullptr) {
+        on_audio_channel_opened_();
+    }
+
+    xTaskCreate([](void* arg) {
+        auto protocol = (ReplayProtocol*)arg;
+        protocol->DownlinkTask();
+        vTaskDelete(NULL);
+    }, "replay", 4096 * 2, this, 5, &downlink_task_);
+    return true;
+}
+
+void ReplayProtocol::CloseAudioChannel() {
+    if (!opened_.exchange(false)) {
+        return;
+    }
+    if (on_audio_channel_closed_ != nullptr) {
+        on_audio_channel_closed_();
+    }
+}
+
+bool ReplayProtocol::IsAudioChannelOpened() const {
+    return opened_;
+}
+
+void ReplayProtocol::SendAudio(const std::vector<uint8_t>& data) {
+    uplink_packets_++;
+    uplink_bytes_ += data.size();
+    int64_t last_input = last_input_time_us_;
+    if (last_input != 0) {
+        int64_t latency = esp_timer_get_time() - last_input;
+        uplink_latency_total_us_ += latency;
+        if (latency > uplink_latency_max_us_) {
+            uplink_latency_max_us_ = latency;
+        }
+    }
+}
+
+void ReplayProtocol::SendText(const std::string& text) {
+    ESP_LOGD(TAG, ">> %s", text.c_str());
+}
+
+// timestamp_us 为录制时间，按倍速换算成回放开始后的时间
+void ReplayProtocol::WaitUntil(int64_t timestamp_us) {
+    if (speed_ <= 0) {
+        return;
+    }
+    int64_t delay_us = start_time_us_ + timestamp_us / speed_ - esp_timer_get_time();
+    if (delay_us >= 1000) {
+        vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS(delay_us / 1000)));
+    }
+}
+
+bool ReplayProtocol::ReadInput(std::vector<int16_t>& data) {
+    if (!opened_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(input_mutex_);
+    // 和 I2S 读取一样，等到这段数据按录制时间已经采集完才返回
+    WaitUntil((int64_t)(input_consumed_ + data.size()) * 1000000 / (input_sample_rate_ * input_channels_));
+
+    mic_.Read(data.data(), data.size());
+    input_done_ = mic_.done();
+    input_consumed_ += data.size();
+    last_input_time_us_ = esp_timer_get_time();
+    return true;
+}
+
+bool ReplayProtocol::WriteOutput(const std::vector<int16_t>& data) {
+    if (!opened_) {
+        return false;
+    }
+    output_samples_ += data.size();
+    int64_t tts_start = tts_start_time_us_.exchange(0);
+    if (tts_start != 0) {
+        tts_latency_total_us_ += esp_timer_get_time() - tts_start;
+        tts_latency_count_++;
+    }
+    // 按录制时间回放时照常播放，倍速回放时丢弃
+    return speed_ != 1;
+}
+
+void ReplayProtocol::DownlinkTask() {
+    size_t offset = sizeof(SessionLogHeader);
+    const SessionRecordHeader* record;
+    while (opened_ && (record = log_.NextRecord(offset)) != nullptr) {
+        if (record->type == kSessionRecordChannelClosed) {
+            break;
+        }
+        if (record->type != kSessionRecordDownlinkAudio && record->type != kSessionRecordDownlinkJson) {
+            continue;
+        }
+        WaitUntil((int64_t)record->timestamp_ms * 1000);
+        last_incoming_time_ = std::chrono::steady_clock::now();
+
+        auto payload = (const uint8_t*)(record + 1);
+        if (record->type == kSessionRecordDownlinkAudio) {
+            downlink_packets_++;
+            if (on_incoming_audio_ != nullptr) {
+                on_incoming_audio_(std::vector<uint8_t>(payload, payload + record->size));
+            }
+            continue;
+        }
+
+        json_messages_++;
+        auto root = cJSON_ParseWithLength((const char*)payload, record->size);
+        if (root == nullptr) {
+            ESP_LOGW(TAG, "Invalid JSON at %lu ms", (unsigned long)record->timestamp_ms);
+            continue;
+        }
+        // 统计从 tts start 到第一帧输出的时间
+        auto type = cJSON_GetObjectItem(root, "type");
+        auto state = cJSON_GetObjectItem(root, "state");
+        if (cJSON_IsString(type) && strcmp(type->valuestring, "tts") == 0 &&
+            cJSON_IsString(state) && strcmp(state->valuestring, "start") == 0) {
+            tts_start_time_us_ = esp_timer_get_time();
+        }
+        if (on_incoming_json_ != nullptr) {
+            on_incoming_json_(root);
+        }
+        cJSON_Delete(root);
+    }
+
+    int64_t deadline = esp_timer_get_time() + REPLAY_INPUT_DRAIN_MS * 1000;
+    if (speed_ > 0) {
+        deadline += (int64_t)recorded_ms_ * 1000 / speed_;
+    }
+    while (opened_ && !input_done_ && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    PrintReport();
+    downlink_task_ = nullptr;
+    CloseAudioChannel();
+}
+
+void ReplayProtocol::PrintReport() {
+    long long elapsed_ms = (esp_timer_get_time() - start_time_us_) / 1000;
+    uint32_t uplink_packets = uplink_packets_;
+    uint32_t tts_count = tts_latency_count_;
+    long long uplink_latency_avg_ms = uplink_packets > 0 ? uplink_latency_total_us_ / uplink_packets / 1000 : 0;
+    long long tts_latency_avg_ms = tts_count > 0 ? tts_latency_total_us_ / tts_count / 1000 : 0;
+    printf("REPLAY {\"file\":\"%s\",\"speed\":%d,\"recorded_ms\":%lu,\"elapsed_ms\":%lld,"
+        "\"mic_records\":%lu,\"downlink_packets\":%lu,\"json_messages\":%lu,\"uplink_packets\":%lu,\"uplink_bytes\":%lu,"
+        "\"uplink_latency_avg_ms\":%lld,\"uplink_latency_max_ms\":%lld,\"tts_first_audio_avg_ms\":%lld,\"output_samples\":%llu}\n",
+        path_.c_str(), speed_, (unsigned long)recorded_ms_, elapsed_ms,
+        (unsigned long)mic_.records(), (unsigned long)downlink_packets_, (unsigned long)json_messages_,
+        (unsigned long)uplink_packets, (unsigned long)uplink_bytes_.load(),
+        uplink_latency_avg_ms, (long long)(uplink_latency_max_us_ / 1000), tts_latency_avg_ms,
+        (unsigned long long)output_samples_.load());
+}
+
+void ReplayProtocol::RegisterConsoleCommand() {
+    DebugConsole::GetInstance().RegisterCommand("replay",
+        "Reboot and replay a recorded session: 'replay <path> [speed]', speed 0 runs as fast as possible",
+        [](int argc, char** argv) {
+            if (argc < 2) {
+                printf("Usage: replay <path> [speed]\n");
+                return 1;
+            }
+            if (fs_manager_prepare_path(argv[1]) != ESP_OK) {
+                printf("Storage partition is not available, cannot replay %s\n", argv[1]);
+                return 1;
+            }
+            FILE* fp = fopen(argv[1], "rb");
+            if (fp == nullptr) {
+                printf("Failed to open %s\n", argv[1]);
+                return 1;
+            }
+            fclose(fp);
+            kReplayFileSetting.Set(argv[1]);
+            kReplaySpeedSetting.Set(argc > 2 ? atoi(argv[2]) : 1);
+            Settings::Flush();
+            printf("Rebooting to replay %s\n", argv[1]);
+            esp_restart();
+            return 0;
+        });
+}
@@ -0,0 +1,78 @@
+#ifndef _REPLAY_PROTOCOL_H_
+#define _REPLAY_PROTOCOL_H_
+
+#include "protocol.h"
+#include "session_log.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// 回放 SessionRecorder 录制的会话：代替网络协议按录制的时间下发 Opus 包和 JSON，
+// 同时代替 codec 输入按顺序提供录制的麦克风数据，上行音频只计数，结束后输出一行 "REPLAY {...}" 统计
+// 回放在重启后的干净状态下进行：replay 命令保存文件路径后重启，启动时由 CreateFromSettings 接管
+// speed 为时间倍速，1 为按录制时间，0 为不等待、尽可能快
+class ReplayProtocol : public Protocol {
+public:
+    // 读取并清除回放设置，设置了回放文件且加载成功时返回回放协议，否则返回 nullptr
+    static ReplayProtocol* CreateFromSettings();
+    static void RegisterConsoleCommand();
+
+    ~ReplayProtocol();
+
+    void Start() override;
+    bool OpenAudioChannel() override;
+    void CloseAudioChannel() override;
+    bool IsAudioChannelOpened() const override;
+    void SendAudio(const std::vector<uint8_t>& data) override;
+
+    // 代替 codec->InputData：音频通道打开后返回录制的麦克风数据，返回 false 时调用方读取 codec
+    bool ReadInput(std::vector<int16_t>& data);
+    // 代替 codec->OutputData：倍速回放时只计数，返回 false 时调用方照常播放
+    bool WriteOutput(const std::vector<int16_t>& data);
+
+private:
+    std::string path_;
+    uint8_t* data_;
+    size_t size_;
+    int speed_;
+    int input_sample_rate_;
+    int input_channels_;
+    uint32_t recorded_ms_ = 0;
+
+    std::atomic<bool> opened_ = false;
+    int64_t start_time_us_ = 0;
+    TaskHandle_t downlink_task_ = nullptr;
+
+    SessionLogReader log_;
+    // 麦克风数据按样本连续读取，跨越记录边界
+    std::mutex input_mutex_;
+    SessionMicReader mic_;
+    uint64_t input_consumed_ = 0;
+    std::atomic<bool> input_done_ = false;
+    std::atomic<int64_t> last_input_time_us_ = 0;
+
+    uint32_t downlink_packets_ = 0;
+    uint32_t json_messages_ = 0;
+    std::atomic<uint32_t> uplink_packets_ = 0;
+    std::atomic<uint32_t> uplink_bytes_ = 0;
+    std::atomic<int64_t> uplink_latency_total_us_ = 0;
+    std::atomic<int64_t> uplink_latency_max_us_ = 0;
+    std::atomic<int64_t> tts_start_time_us_ = 0;
+    std::atomic<int64_t> tts_latency_total_us_ = 0;
+    std::atomic<uint32_t> tts_latency_count_ = 0;
+    std::atomic<uint64_t> output_samples_ = 0;
+
+    ReplayProtocol(const std::string& path, uint8_t* data, size_t size, int speed);
+
+    void WaitUntil(int64_t timestamp_us);
+    void DownlinkTask();
+    void PrintReport();
+    void SendText(const std::string& text) override;
+    bool IsTimeout() const override { return false; }
+};
+
+#endif // _REPLAY_PROTOCOL_H_
@@ -0,0 +1,63 @@
+#include "uplink_adapter.h"
+
+#include <esp_log.h>
+
+#define TAG "UplinkAdapter"
+
+// 链路分级阈值
+#define UPLINK_BAD_LOSS_PERCENT 5
+#define UPLINK_BAD_LATENCY_MS 150
+#define UPLINK_FAIR_LOSS_PERCENT 1
+#define UPLINK_FAIR_LATENCY_MS 60
+// 编码占用超过上限时降低复杂度，低于下限时逐步恢复；超过 20ms 帧上限时不使用 20ms 帧
+#define UPLINK_ENCODE_LOAD_HIGH 60
+#define UPLINK_ENCODE_LOAD_LOW 25
+#define UPLINK_ENCODE_LOAD_SHORT_FRAME 40
+
+UplinkAdapter::UplinkAdapter(int frame_duration, int max_complexity)
+    : initial_frame_duration_(frame_duration), frame_duration_(frame_duration), complexity_(max_complexity),
+      max_complexity_(max_complexity) {
+}
+
+void UplinkAdapter::Reset() {
+    frame_duration_ = initial_frame_duration_;
+    pending_frame_duration_ = 0;
+}
+
+bool UplinkAdapter::Update(int loss_percent, int send_latency_ms, int encode_load_percent, Decision& decision) {
+    int target = 20;
+    if (loss_percent >= UPLINK_BAD_LOSS_PERCENT || send_latency_ms >= UPLINK_BAD_LATENCY_MS) {
+        target = 60;
+    } else if (loss_percent >= UPLINK_FAIR_LOSS_PERCENT || send_latency_ms >= UPLINK_FAIR_LATENCY_MS) {
+        target = 40;
+    }
+    // 短帧的编码开销更大，CPU 紧张时不切到 20ms
+    if (target == 20 && encode_load_percent >= UPLINK_ENCODE_LOAD_SHORT_FRAME) {
+        target = 40;
+    }
+
+    bool changed = false;
+    if (target == frame_duration_) {
+        pending_frame_duration_ = 0;
+    } else if (target == pending_frame_duration_) {
+        ESP_LOGI(TAG, "Frame duration %d -> %d ms (loss %d%%, latency %d ms, load %d%%)",
+            frame_duration_, target, loss_percent, send_latency_ms, encode_load_percent);
+        frame_duration_ = target;
+        pending_frame_duration_ = 0;
+        changed = true;
+    } else {
+        pending_frame_duration_ = target;
+    }
+
+    if (encode_load_percent >= UPLINK_ENCODE_LOAD_HIGH && complexity_ > 0) {
+        complexity_--;
+        changed = true;
+    } else if (encode_load_percent < UPLINK_ENCODE_LOAD_LOW && complexity_ < max_complexity_) {
+        complexity_++;
+        changed = true;
+    }
+
+    decision.frame_duration = frame_duration_;
+    decision.complexity = complexity_;
+    return changed;
+}
@@ -0,0 +1,37 @@
+#ifndef _UPLINK_ADAPTER_H_
+#define _UPLINK_ADAPTER_H_
+
+// 上行编码参数的自适应控制：根据链路丢包、发送耗时和编码 CPU 占用，周期性地选择 Opus 帧长和复杂度
+// 链路好时用 20ms 帧降低延迟，链路差时用 60ms 帧减少包数；编码占用高时降低复杂度
+// 连续两个统计窗口得到相同的结论才切换帧长，避免来回抖动；复杂度每个窗口最多调整 1 级
+//
+// 协议里没有上行的接收回执，loss_percent 实际是下行（服务器到设备）UDP 序号的丢包率，
+// 这里假设上下行经过同一段无线链路、丢包程度相近，用它近似上行丢包。WebSocket 没有序号，只能依据发送耗时
+class UplinkAdapter {
+public:
+    struct Decision {
+        int frame_duration;
+        int complexity;
+    };
+
+    UplinkAdapter(int frame_duration, int max_complexity);
+
+    // loss_percent: 下行丢包率（近似上行），send_latency_ms: 每帧平均发送耗时，encode_load_percent: 编码耗时占音频时长的比例
+    // 返回 true 表示需要应用新的参数
+    bool Update(int loss_percent, int send_latency_ms, int encode_load_percent, Decision& decision);
+
+    // 新会话回到初始帧长，复杂度反映的是 CPU 负载，保持不变
+    void Reset();
+
+    int frame_duration() const { return frame_duration_; }
+    int complexity() const { return complexity_; }
+
+private:
+    int initial_frame_duration_;
+    int frame_duration_;
+    int complexity_;
+    int max_complexity_;
+    int pending_frame_duration_ = 0;
+};
+
+#endif // _UPLINK_ADAPTER_H_
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <cJSON.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
@@ -30,7 +31,10 @@ void WebsocketProtocol::SendAudio(const std::vector<uint8_t>& data) {
         return;
     }
 
+    auto start_time = esp_timer_get_time();
     websocket_->Send(data.data(), data.size(), true);
+    send_time_us_ += esp_timer_get_time() - start_time;
+    sent_packets_++;
 }
 
 void WebsocketProtocol::SendText(const std::string& text) {
@@ -61,6 +65,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
     }
 
     error_occurred_ = false;
+    uplink_frame_duration_ = OPUS_FRAME_DURATION_MS;
     std::string url = CONFIG_WEBSOCKET_URL;
     std::string token = "Bearer " + std::string(CONFIG_WEBSOCKET_ACCESS_TOKEN);
     websocket_ = Board::GetInstance().CreateWebSocket();
@@ -113,9 +118,8 @@ bool WebsocketProtocol::OpenAudioChannel() {
     message += "\"type\":\"hello\",";
     message += "\"version\": 1,";
     message += "\"transport\":\"websocket\",";
-    message += "\"audio_params\":{";
-    message += "\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" + std::to_string(OPUS_FRAME_DURATION_MS);
-    message += "}}";
+    message += "\"audio_params\":" + GetAudioParamsJson();
+    message += "}";
     websocket_->Send(message);
 
     // Wait for server hello
@@ -0,0 +1,165 @@
+#include "session_log.h"
+#include "debug_console.h"
+#include "fs_manager.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <mbedtls/base64.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#define TAG "SessionRecorder"
+
+// 串口导出时每行的原始字节数，base64 后为 64 个字符
+#define SESSION_DUMP_LINE_BYTES 48
+
+bool SessionRecorder::Arm() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recording_) {
+        return false;
+    }
+    if (buffer_ == nullptr) {
+        capacity_ = CONFIG_SESSION_RECORD_BUFFER_KB * 1024;
+        buffer_ = (uint8_t*)heap_caps_malloc(capacity_, MALLOC_CAP_SPIRAM);
+        if (buffer_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate %u KB record buffer", CONFIG_SESSION_RECORD_BUFFER_KB);
+            return false;
+        }
+    }
+    size_ = 0;
+    truncated_ = false;
+    armed_ = true;
+    return true;
+}
+
+void SessionRecorder::OnChannelOpened(int input_sample_rate, int input_channels, int server_sample_rate,
+    int server_frame_duration) {
+    if (!armed_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    SessionLogHeader header = {};
+    header.magic = SESSION_LOG_MAGIC;
+    header.version = SESSION_LOG_VERSION;
+    header.input_channels = input_channels;
+    header.input_sample_rate = input_sample_rate;
+    memcpy(buffer_, &header, sizeof(header));
+    size_ = sizeof(header);
+    start_time_us_ = esp_timer_get_time();
+    armed_ = false;
+    recording_ = true;
+
+    uint32_t params[2] = {(uint32_t)server_sample_rate, (uint32_t)server_frame_duration};
+    Append(kSessionRecordChannelOpened, params, sizeof(params));
+    ESP_LOGI(TAG, "Recording started");
+}
+
+void SessionRecorder::OnChannelClosed() {
+    if (!recording_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Append(kSessionRecordChannelClosed, nullptr, 0);
+    recording_ = false;
+    ESP_LOGI(TAG, "Recording stopped, %u bytes%s", (unsigned)size_, truncated_ ? " (truncated)" : "");
+}
+
+void SessionRecorder::Record(SessionRecordType type, const void* data, size_t size) {
+    if (!recording_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recording_) {
+        Append(type, data, size);
+    }
+}
+
+// 调用方持有 mutex_；记录按 4 字节对齐，缓冲区满了之后丢弃后续记录，回放时按截断处理
+void SessionRecorder::Append(SessionRecordType type, const void* data, size_t size) {
+    size_t padded_size = (size + 3) & ~3u;
+    if (size_ + sizeof(SessionRecordHeader) + padded_size > capacity_) {
+        if (!truncated_) {
+            ESP_LOGW(TAG, "Record buffer full, dropping the rest of the session");
+            truncated_ = true;
+        }
+        return;
+    }
+    SessionRecordHeader header = {};
+    header.type = type;
+    header.timestamp_ms = (esp_timer_get_time() - start_time_us_) / 1000;
+    header.size = size;
+    memcpy(buffer_ + size_, &header, sizeof(header));
+    size_ += sizeof(header);
+    if (size > 0) {
+        memcpy(buffer_ + size_, data, size);
+    }
+    memset(buffer_ + size_ + size, 0, padded_size - size);
+    size_ += padded_size;
+}
+
+bool SessionRecorder::Save(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recording_ || size_ == 0) {
+        printf("Nothing to save\n");
+        return false;
+    }
+    if (fs_manager_prepare_path(path.c_str()) != ESP_OK) {
+        printf("Storage partition is not available, cannot save %s\n", path.c_str());
+        return false;
+    }
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        printf("Failed to open %s\n", path.c_str());
+        return false;
+    }
+    size_t written = fwrite(buffer_, 1, size_, fp);
+    fclose(fp);
+    printf("Saved %u/%u bytes to %s\n", (unsigned)written, (unsigned)size_, path.c_str());
+    return written == size_;
+}
+
+// 以 "RECORD <base64>" 行输出，主机上用 scripts/session_log.py --serial 从串口日志还原
+void SessionRecorder::Dump() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recording_ || size_ == 0) {
+        printf("Nothing to dump\n");
+        return;
+    }
+    unsigned char line[SESSION_DUMP_LINE_BYTES * 4 / 3 + 4];
+    for (size_t offset = 0; offset < size_; offset += SESSION_DUMP_LINE_BYTES) {
+        size_t length = std::min((size_t)SESSION_DUMP_LINE_BYTES, size_ - offset);
+        size_t encoded = 0;
+        mbedtls_base64_encode(line, sizeof(line), &encoded, buffer_ + offset, length);
+        printf("RECORD %.*s\n", (int)encoded, line);
+    }
+    printf("RECORD END %u\n", (unsigned)size_);
+}
+
+void SessionRecorder::PrintStatus() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const char* state = recording_ ? "recording" : (armed_ ? "armed" : "idle");
+    printf("%s, %u/%u bytes%s\n", state, (unsigned)size_, (unsigned)capacity_, truncated_ ? ", truncated" : "");
+}
+
+void SessionRecorder::RegisterConsoleCommand() {
+    DebugConsole::GetInstance().RegisterCommand("record",
+        "Record the next voice session: 'record start', 'record save <path>', 'record dump', 'record status'",
+        [this](int argc, char** argv) {
+            if (argc > 1 && strcmp(argv[1], "start") == 0) {
+                if (!Arm()) {
+                    return 1;
+                }
+                printf("Armed, recording starts when the audio channel opens\n");
+            } else if (argc > 2 && strcmp(argv[1], "save") == 0) {
+                return Save(argv[2]) ? 0 : 1;
+            } else if (argc > 1 && strcmp(argv[1], "dump") == 0) {
+                Dump();
+            } else {
+                PrintStatus();
+            }
+            return 0;
+        });
+}
@@ -0,0 +1,130 @@
+#ifndef _SESSION_LOG_H_
+#define _SESSION_LOG_H_
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+// 会话日志格式（小端），scripts/session_log.py 在主机上解析：
+//   文件头 SessionLogHeader，之后是一串记录，每条记录为 SessionRecordHeader + payload，payload 补齐到 4 字节
+//   时间戳为自音频通道打开起的毫秒数
+#define SESSION_LOG_MAGIC 0x43455258 // "XREC"
+#define SESSION_LOG_VERSION 1
+
+enum SessionRecordType : uint8_t {
+    // 音频通道打开，payload 为 uint32 server_sample_rate, uint32 server_frame_duration
+    kSessionRecordChannelOpened = 1,
+    kSessionRecordChannelClosed = 2,
+    // codec 输入的原始 PCM，交错的 input_channels 声道
+    kSessionRecordMicPcm = 3,
+    // 下行 Opus 包
+    kSessionRecordDownlinkAudio = 4,
+    // 下行 JSON 文本
+    kSessionRecordDownlinkJson = 5,
+};
+
+struct SessionLogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t input_channels;
+    uint32_t input_sample_rate;
+    uint32_t reserved;
+};
+
+struct SessionRecordHeader {
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t timestamp_ms;
+    uint32_t size;
+};
+
+// 按顺序读取内存中的会话日志，回放和主机测试共用，不依赖 ESP-IDF
+class SessionLogReader {
+public:
+    struct Summary {
+        uint32_t recorded_ms = 0;
+        int server_sample_rate = 0;
+        int server_frame_duration = 0;
+        uint32_t mic_records = 0;
+        uint64_t mic_samples = 0;
+        uint32_t downlink_packets = 0;
+        uint32_t json_messages = 0;
+        bool closed = false;
+    };
+
+    SessionLogReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    // 文件头的 magic 和版本正确
+    bool valid() const;
+    const SessionLogHeader& header() const { return *(const SessionLogHeader*)data_; }
+    // offset 从 sizeof(SessionLogHeader) 开始，读完或遇到截断的记录时返回 nullptr
+    const SessionRecordHeader* NextRecord(size_t& offset) const;
+    // 遍历全部记录统计
+    Summary Summarize() const;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+};
+
+// 跨越记录边界连续读取麦克风数据
+class SessionMicReader {
+public:
+    explicit SessionMicReader(const SessionLogReader& log) : log_(log) {}
+
+    // 填满 samples 个样本，录制的数据读完后补静音；返回录制数据的样本数
+    size_t Read(int16_t* data, size_t samples);
+    bool done() const { return done_; }
+    uint32_t records() const { return records_; }
+
+private:
+    const SessionLogReader& log_;
+    size_t offset_ = sizeof(SessionLogHeader);
+    const int16_t* samples_ = nullptr;
+    size_t remaining_ = 0;
+    uint32_t records_ = 0;
+    bool done_ = false;
+};
+
+// 录制一次语音会话的输入：record start 之后的下一个音频通道从打开录到关闭，
+// 数据先写入 PSRAM 缓冲区，不在音频路径上访问 flash，结束后再保存到文件或通过串口导出
+class SessionRecorder {
+public:
+    static SessionRecorder& GetInstance() {
+        static SessionRecorder instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    // 没有在录制时各调用点只读取一个原子变量
+    bool IsRecording() const { return recording_; }
+
+    void OnChannelOpened(int input_sample_rate, int input_channels, int server_sample_rate, int server_frame_duration);
+    void OnChannelClosed();
+    void Record(SessionRecordType type, const void* data, size_t size);
+
+    void RegisterConsoleCommand();
+
+private:
+    SessionRecorder() = default;
+
+    std::mutex mutex_;
+    std::atomic<bool> armed_ = false;
+    std::atomic<bool> recording_ = false;
+    uint8_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    int64_t start_time_us_ = 0;
+    bool truncated_ = false;
+
+    bool Arm();
+    void Append(SessionRecordType type, const void* data, size_t size);
+    bool Save(const std::string& path);
+    void Dump();
+    void PrintStatus();
+};
+
+#endif // _SESSION_LOG_H_
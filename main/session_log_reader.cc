@@ -0,0 +1,80 @@
+#include "session_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool SessionLogReader::valid() const {
+    return size_ >= sizeof(SessionLogHeader) && header().magic == SESSION_LOG_MAGIC &&
+        header().version == SESSION_LOG_VERSION;
+}
+
+// 记录按 4 字节对齐存放，payload 可以直接按 int16 / uint32 访问
+const SessionRecordHeader* SessionLogReader::NextRecord(size_t& offset) const {
+    if (offset + sizeof(SessionRecordHeader) > size_) {
+        return nullptr;
+    }
+    auto record = (const SessionRecordHeader*)(data_ + offset);
+    if (offset + sizeof(SessionRecordHeader) + record->size > size_) {
+        return nullptr;
+    }
+    offset += sizeof(SessionRecordHeader) + ((record->size + 3) & ~3u);
+    return record;
+}
+
+SessionLogReader::Summary SessionLogReader::Summarize() const {
+    Summary summary;
+    size_t offset = sizeof(SessionLogHeader);
+    const SessionRecordHeader* record;
+    while ((record = NextRecord(offset)) != nullptr) {
+        switch (record->type) {
+        case kSessionRecordChannelOpened:
+            if (record->size >= 2 * sizeof(uint32_t)) {
+                auto params = (const uint32_t*)(record + 1);
+                summary.server_sample_rate = params[0];
+                summary.server_frame_duration = params[1];
+            }
+            break;
+        case kSessionRecordChannelClosed:
+            summary.closed = true;
+            break;
+        case kSessionRecordMicPcm:
+            summary.mic_records++;
+            summary.mic_samples += record->size / sizeof(int16_t);
+            break;
+        case kSessionRecordDownlinkAudio:
+            summary.downlink_packets++;
+            break;
+        case kSessionRecordDownlinkJson:
+            summary.json_messages++;
+            break;
+        }
+        summary.recorded_ms = record->timestamp_ms;
+    }
+    return summary;
+}
+
+size_t SessionMicReader::Read(int16_t* data, size_t samples) {
+    size_t filled = 0;
+    while (filled < samples) {
+        if (remaining_ == 0) {
+            const SessionRecordHeader* record;
+            while ((record = log_.NextRecord(offset_)) != nullptr && record->type != kSessionRecordMicPcm) {
+            }
+            if (record == nullptr) {
+                std::fill(data + filled, data + samples, 0);
+                done_ = true;
+                break;
+            }
+            samples_ = (const int16_t*)(record + 1);
+            remaining_ = record->size / sizeof(int16_t);
+            records_++;
+            continue;
+        }
+        size_t count = std::min(remaining_, samples - filled);
+        memcpy(data + filled, samples_, count * sizeof(int16_t));
+        samples_ += count;
+        remaining_ -= count;
+        filled += count;
+    }
+    return filled;
+}
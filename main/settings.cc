@@ -1,67 +1,268 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_system.h>
 #include <nvs_flash.h>
 
+#include <map>
+#include <mutex>
+
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
-}
+namespace {
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+struct CachedValue {
+    nvs_type_t type = NVS_TYPE_ANY; // NVS_TYPE_ANY 表示已删除，提交时擦除
+    int32_t number = 0;
+    std::string text;
+    bool dirty = false;
+};
+
+struct CachedNamespace {
+    std::map<std::string, CachedValue> values;
+    bool erase_all = false;
+    bool dirty = false;
+};
+
+class SettingsCache {
+public:
+    static SettingsCache& GetInstance() {
+        static SettingsCache instance;
+        return instance;
+    }
+
+    std::string GetString(const std::string& ns, const std::string& key, const std::string& default_value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto value = Find(Load(ns), key);
+        return value != nullptr && value->type == NVS_TYPE_STR ? value->text : default_value;
+    }
+
+    int32_t GetInt(const std::string& ns, const std::string& key, int32_t default_value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto value = Find(Load(ns), key);
+        return value != nullptr && value->type == NVS_TYPE_I32 ? value->number : default_value;
+    }
+
+    void SetString(const std::string& ns, const std::string& key, const std::string& text) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& cached = Load(ns);
+        auto& value = cached.values[key];
+        if (value.type == NVS_TYPE_STR && value.text == text) {
+            return;
         }
-        nvs_close(nvs_handle_);
+        value.type = NVS_TYPE_STR;
+        value.text = text;
+        MarkDirty(cached, value);
     }
-}
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+    void SetInt(const std::string& ns, const std::string& key, int32_t number) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& cached = Load(ns);
+        auto& value = cached.values[key];
+        if (value.type == NVS_TYPE_I32 && value.number == number) {
+            return;
+        }
+        value.type = NVS_TYPE_I32;
+        value.number = number;
+        value.text.clear();
+        MarkDirty(cached, value);
     }
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+    void EraseKey(const std::string& ns, const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& cached = Load(ns);
+        auto it = cached.values.find(key);
+        if (it == cached.values.end() || it->second.type == NVS_TYPE_ANY) {
+            return;
+        }
+        it->second.type = NVS_TYPE_ANY;
+        it->second.text.clear();
+        MarkDirty(cached, it->second);
     }
 
-    std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    void EraseAll(const std::string& ns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& cached = Load(ns);
+        cached.values.clear();
+        cached.erase_all = true;
+        cached.dirty = true;
+        ScheduleCommit();
     }
-    return value;
+
+    void Flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (commit_timer_ != nullptr) {
+            esp_timer_stop(commit_timer_);
+        }
+
+        int committed = 0;
+        for (auto& [ns, cached] : namespaces_) {
+            if (!cached.dirty) {
+                continue;
+            }
+
+            nvs_handle_t handle;
+            esp_err_t err = nvs_open(ns.c_str(), NVS_READWRITE, &handle);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+                continue;
+            }
+
+            if (cached.erase_all) {
+                ESP_ERROR_CHECK(nvs_erase_all(handle));
+                cached.erase_all = false;
+            }
+            for (auto it = cached.values.begin(); it != cached.values.end();) {
+                auto& value = it->second;
+                if (value.dirty) {
+                    if (value.type == NVS_TYPE_I32) {
+                        ESP_ERROR_CHECK(nvs_set_i32(handle, it->first.c_str(), value.number));
+                    } else if (value.type == NVS_TYPE_STR) {
+                        ESP_ERROR_CHECK(nvs_set_str(handle, it->first.c_str(), value.text.c_str()));
+                    } else {
+                        err = nvs_erase_key(handle, it->first.c_str());
+                        if (err != ESP_ERR_NVS_NOT_FOUND) {
+                            ESP_ERROR_CHECK(err);
+                        }
+                    }
+                    value.dirty = false;
+                }
+                if (value.type == NVS_TYPE_ANY) {
+                    it = cached.values.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            ESP_ERROR_CHECK(nvs_commit(handle));
+            nvs_close(handle);
+            cached.dirty = false;
+            committed++;
+        }
+
+        if (committed > 0) {
+            ESP_LOGI(TAG, "Committed %d namespace(s)", committed);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, CachedNamespace> namespaces_;
+    esp_timer_handle_t commit_timer_ = nullptr;
+
+    SettingsCache() {
+        esp_timer_create_args_t timer_args = {
+            .callback = [](void* arg) {
+                static_cast<SettingsCache*>(arg)->Flush();
+            },
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "settings_commit",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &commit_timer_));
+
+        // esp_restart() 和深度睡眠前提交未保存的修改
+        esp_register_shutdown_handler([]() {
+            SettingsCache::GetInstance().Flush();
+        });
+    }
+
+    // 命名空间只在第一次使用时从 NVS 载入，之后的读取都在内存中完成
+    CachedNamespace& Load(const std::string& ns) {
+        auto it = namespaces_.find(ns);
+        if (it != namespaces_.end()) {
+            return it->second;
+        }
+
+        auto& cached = namespaces_[ns];
+        nvs_handle_t handle;
+        if (nvs_open(ns.c_str(), NVS_READONLY, &handle) != ESP_OK) {
+            // 命名空间还没有创建
+            return cached;
+        }
+
+        nvs_iterator_t iterator = nullptr;
+        esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns.c_str(), NVS_TYPE_ANY, &iterator);
+        while (err == ESP_OK) {
+            nvs_entry_info_t info;
+            nvs_entry_info(iterator, &info);
+
+            CachedValue value;
+            value.type = info.type;
+            if (info.type == NVS_TYPE_I32) {
+                err = nvs_get_i32(handle, info.key, &value.number);
+            } else if (info.type == NVS_TYPE_STR) {
+                size_t length = 0;
+                err = nvs_get_str(handle, info.key, nullptr, &length);
+                if (err == ESP_OK) {
+                    value.text.resize(length);
+                    err = nvs_get_str(handle, info.key, value.text.data(), &length);
+                }
+                while (!value.text.empty() && value.text.back() == '\0') {
+                    value.text.pop_back();
+                }
+            } else {
+                // Settings 只管理整数和字符串
+                err = ESP_ERR_NOT_SUPPORTED;
+            }
+            if (err == ESP_OK) {
+                cached.values[info.key] = std::move(value);
+            }
+            err = nvs_entry_next(&iterator);
+        }
+        nvs_release_iterator(iterator);
+        nvs_close(handle);
+        ESP_LOGI(TAG, "Loaded namespace %s: %u entries", ns.c_str(), (unsigned)cached.values.size());
+        return cached;
+    }
+
+    const CachedValue* Find(const CachedNamespace& cached, const std::string& key) {
+        auto it = cached.values.find(key);
+        return it == cached.values.end() ? nullptr : &it->second;
+    }
+
+    void MarkDirty(CachedNamespace& cached, CachedValue& value) {
+        value.dirty = true;
+        cached.dirty = true;
+        ScheduleCommit();
+    }
+
+    // 第一次修改时启动定时器，窗口内的后续修改合并到同一次提交
+    void ScheduleCommit() {
+        if (!esp_timer_is_active(commit_timer_)) {
+            esp_timer_start_once(commit_timer_, CONFIG_SETTINGS_COMMIT_DELAY_MS * 1000);
+        }
+    }
+};
+
+} // namespace
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+Settings::~Settings() {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    return SettingsCache::GetInstance().GetString(ns_, key, default_value);
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        SettingsCache::GetInstance().SetString(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
-    int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
-        return default_value;
-    }
-    return value;
+    return SettingsCache::GetInstance().GetInt(ns_, key, default_value);
 }
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        SettingsCache::GetInstance().SetInt(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -69,10 +270,7 @@ void Settings::SetInt(const std::string& key, int32_t value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsCache::GetInstance().EraseKey(ns_, key);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -80,8 +278,12 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsCache::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
+
+void Settings::Flush() {
+    SettingsCache::GetInstance().Flush();
+}
@@ -4,6 +4,9 @@
 #include <string>
 #include <nvs_flash.h>
 
+// 配置读写走进程内的缓存：命名空间首次使用时从 NVS 整体载入，读取只访问内存，
+// 写入先标记为脏，延迟 CONFIG_SETTINGS_COMMIT_DELAY_MS 后合并提交，
+// 也可以调用 Flush() 立即提交，进入省电模式和重启前会自动提交
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -16,11 +19,56 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // 把所有未提交的修改写入 NVS
+    static void Flush();
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
+// 带类型的配置项，命名空间和键名集中定义，避免各处拼写不一致
+template <typename T>
+class SettingKey {
+public:
+    constexpr SettingKey(const char* ns, const char* key) : ns_(ns), key_(key) {}
+
+    T Get(const T& default_value = T()) const;
+    void Set(const T& value) const;
+
+private:
+    const char* ns_;
+    const char* key_;
+};
+
+template <>
+inline int32_t SettingKey<int32_t>::Get(const int32_t& default_value) const {
+    return Settings(ns_).GetInt(key_, default_value);
+}
+
+template <>
+inline void SettingKey<int32_t>::Set(const int32_t& value) const {
+    Settings(ns_, true).SetInt(key_, value);
+}
+
+template <>
+inline bool SettingKey<bool>::Get(const bool& default_value) const {
+    return Settings(ns_).GetInt(key_, default_value ? 1 : 0) != 0;
+}
+
+template <>
+inline void SettingKey<bool>::Set(const bool& value) const {
+    Settings(ns_, true).SetInt(key_, value ? 1 : 0);
+}
+
+template <>
+inline std::string SettingKey<std::string>::Get(const std::string& default_value) const {
+    return Settings(ns_).GetString(key_, default_value);
+}
+
+template <>
+inline void SettingKey<std::string>::Set(const std::string& value) const {
+    Settings(ns_, true).SetString(key_, value);
+}
+
 #endif
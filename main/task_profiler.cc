@@ -0,0 +1,183 @@
+#include "task_profiler.h"
+#include "debug_console.h"
+
+#include <esp_log.h>
+#include <cJSON.h>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "TaskProfiler"
+
+void TaskProfiler::Start() {
+    if (task_handle_ != nullptr) {
+        return;
+    }
+
+    history_.resize(CONFIG_TASK_PROFILER_HISTORY);
+    xTaskCreate([](void* arg) {
+        auto profiler = (TaskProfiler*)arg;
+        profiler->ProfilerTask();
+        vTaskDelete(NULL);
+    }, "task_profiler", 4096, this, 1, &task_handle_);
+}
+
+void TaskProfiler::ProfilerTask() {
+    while (true) {
+        Sample();
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_TASK_PROFILER_INTERVAL_MS));
+    }
+}
+
+void TaskProfiler::Sample() {
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 5;
+    auto status = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * capacity);
+    if (status == nullptr) {
+        ESP_LOGW(TAG, "Failed to allocate task status array");
+        return;
+    }
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, capacity, &total);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 运行时间计数器是 32 位微秒，按无符号差值计算可以跨过回绕
+    configRUN_TIME_COUNTER_TYPE elapsed = total - last_total_;
+    bool first_sample = last_total_ == 0;
+    last_total_ = total;
+
+    for (auto& task : tasks_) {
+        task.alive = false;
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        auto it = std::find_if(tasks_.begin(), tasks_.end(), [&](const TaskStats& task) {
+            return task.handle == status[i].xHandle;
+        });
+        if (it == tasks_.end()) {
+            TaskStats task = {};
+            task.handle = status[i].xHandle;
+            strncpy(task.name, status[i].pcTaskName, sizeof(task.name) - 1);
+            task.last_counter = status[i].ulRunTimeCounter;
+            tasks_.push_back(task);
+            it = tasks_.end() - 1;
+        } else if (!first_sample && elapsed > 0) {
+            configRUN_TIME_COUNTER_TYPE delta = status[i].ulRunTimeCounter - it->last_counter;
+            it->cpu_permille = std::min<uint64_t>((uint64_t)delta * 1000 / elapsed, 1000);
+            it->cpu_permille_avg = (it->cpu_permille_avg * 7 + it->cpu_permille) / 8;
+            it->cpu_permille_peak = std::max(it->cpu_permille_peak, it->cpu_permille);
+            it->last_counter = status[i].ulRunTimeCounter;
+        }
+
+        BaseType_t core = xTaskGetCoreID(status[i].xHandle);
+        it->core = core == tskNO_AFFINITY ? -1 : core;
+        it->priority = status[i].uxCurrentPriority;
+        // ESP-IDF 的 StackType_t 是 uint8_t，高水位即剩余字节数
+        it->stack_high_water_mark = status[i].usStackHighWaterMark * sizeof(StackType_t);
+        it->alive = true;
+    }
+    free(status);
+
+    tasks_.erase(std::remove_if(tasks_.begin(), tasks_.end(), [](const TaskStats& task) {
+        return !task.alive;
+    }), tasks_.end());
+
+    if (first_sample || history_.empty()) {
+        return;
+    }
+
+    // 核心负载 = 1 - 该核心 IDLE 任务的占用
+    CoreSample sample = {};
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        auto idle = xTaskGetIdleTaskHandleForCore(core);
+        auto it = std::find_if(tasks_.begin(), tasks_.end(), [idle](const TaskStats& task) {
+            return task.handle == idle;
+        });
+        sample.load_permille[core] = it == tasks_.end() ? 0 : 1000 - it->cpu_permille;
+    }
+    history_[history_head_] = sample;
+    history_head_ = (history_head_ + 1) % history_.size();
+    history_count_ = std::min(history_count_ + 1, history_.size());
+}
+
+std::string TaskProfiler::GetReportJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "interval_ms", CONFIG_TASK_PROFILER_INTERVAL_MS);
+
+    cJSON* cores = cJSON_CreateArray();
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        uint32_t sum = 0, peak = 0, last = 0;
+        for (size_t i = 0; i < history_count_; i++) {
+            uint32_t load = history_[(history_head_ + history_.size() - 1 - i) % history_.size()].load_permille[core];
+            if (i == 0) {
+                last = load;
+            }
+            sum += load;
+            peak = std::max(peak, load);
+        }
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "core", core);
+        cJSON_AddNumberToObject(item, "load", last / 10.0);
+        cJSON_AddNumberToObject(item, "load_avg", history_count_ > 0 ? sum / 10.0 / history_count_ : 0);
+        cJSON_AddNumberToObject(item, "load_peak", peak / 10.0);
+        cJSON_AddItemToArray(cores, item);
+    }
+    cJSON_AddItemToObject(root, "cores", cores);
+
+    cJSON* tasks = cJSON_CreateArray();
+    for (auto& task : tasks_) {
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", task.name);
+        cJSON_AddNumberToObject(item, "core", task.core);
+        cJSON_AddNumberToObject(item, "priority", task.priority);
+        cJSON_AddNumberToObject(item, "cpu", task.cpu_permille / 10.0);
+        cJSON_AddNumberToObject(item, "cpu_avg", task.cpu_permille_avg / 10.0);
+        cJSON_AddNumberToObject(item, "cpu_peak", task.cpu_permille_peak / 10.0);
+        cJSON_AddNumberToObject(item, "stack_free", task.stack_high_water_mark);
+        cJSON_AddItemToArray(tasks, item);
+    }
+    cJSON_AddItemToObject(root, "tasks", tasks);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
+void TaskProfiler::PrintReport() {
+    std::vector<TaskStats> tasks;
+    CoreSample last = {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks = tasks_;
+        if (history_count_ > 0) {
+            last = history_[(history_head_ + history_.size() - 1) % history_.size()];
+        }
+    }
+    std::sort(tasks.begin(), tasks.end(), [](const TaskStats& a, const TaskStats& b) {
+        return a.cpu_permille_avg > b.cpu_permille_avg;
+    });
+
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        printf("Core %d: %u.%u%%\n", core, last.load_permille[core] / 10, last.load_permille[core] % 10);
+    }
+    printf("| Task             | Core | Prio | CPU    | Avg    | Peak   | Stack Free\n");
+    for (auto& task : tasks) {
+        printf("| %-16s | %4d | %4u | %5.1f%% | %5.1f%% | %5.1f%% | %6lu\n", task.name, task.core, (unsigned)task.priority,
+            task.cpu_permille / 10.0, task.cpu_permille_avg / 10.0, task.cpu_permille_peak / 10.0,
+            (unsigned long)task.stack_high_water_mark);
+    }
+}
+
+void TaskProfiler::RegisterConsoleCommand() {
+    DebugConsole::GetInstance().RegisterCommand("tasks", "Print CPU usage and free stack per task, 'tasks json' for JSON",
+        [this](int argc, char** argv) {
+            if (argc > 1 && strcmp(argv[1], "json") == 0) {
+                printf("%s\n", GetReportJson().c_str());
+            } else {
+                PrintReport();
+            }
+            return 0;
+        });
+}
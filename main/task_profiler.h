@@ -0,0 +1,62 @@
+#ifndef _TASK_PROFILER_H_
+#define _TASK_PROFILER_H_
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 后台周期采样 FreeRTOS 运行时间计数器，统计每个任务的 CPU 占用和栈剩余
+// 调用方只读取最近的统计结果，不会像 SystemInfo::PrintRealTimeStats 那样阻塞等待采样窗口
+class TaskProfiler {
+public:
+    static TaskProfiler& GetInstance() {
+        static TaskProfiler instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    TaskProfiler(const TaskProfiler&) = delete;
+    TaskProfiler& operator=(const TaskProfiler&) = delete;
+
+    void Start();
+    std::string GetReportJson();
+    void PrintReport();
+    void RegisterConsoleCommand();
+
+private:
+    TaskProfiler() = default;
+
+    struct TaskStats {
+        TaskHandle_t handle;
+        char name[configMAX_TASK_NAME_LEN];
+        configRUN_TIME_COUNTER_TYPE last_counter;
+        int core;
+        UBaseType_t priority;
+        uint32_t stack_high_water_mark;
+        // 单位 0.1%，相对单个核心
+        uint16_t cpu_permille;
+        uint16_t cpu_permille_avg;
+        uint16_t cpu_permille_peak;
+        bool alive;
+    };
+
+    // 环形缓冲区只保存每个核心的负载，任务明细只保留最新值和滑动平均
+    struct CoreSample {
+        uint16_t load_permille[CONFIG_FREERTOS_NUMBER_OF_CORES];
+    };
+
+    std::mutex mutex_;
+    std::vector<TaskStats> tasks_;
+    std::vector<CoreSample> history_;
+    size_t history_head_ = 0;
+    size_t history_count_ = 0;
+    configRUN_TIME_COUNTER_TYPE last_total_ = 0;
+    TaskHandle_t task_handle_ = nullptr;
+
+    void ProfilerTask();
+    void Sample();
+};
+
+#endif // _TASK_PROFILER_H_
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+把 TTF 字体按指定字号预先光栅化成 4bpp 字形数据，设备端由 main/display/flash_font.cc 按需读取
+
+  # 20px，ASCII + 常用标点 + GB2312 一级汉字，打包时放进 assets 分区
+  python scripts/gen_font_blob.py DingTalk-JinBuTi.ttf --size 20 -o build/text_font.bin
+  python scripts/pack_assets.py --lang zh-CN --font text.bin=build/text_font.bin -o build/assets.bin
+
+TTF 本身放不进 assets 分区，设备端也不做矢量光栅化，所以在构建时一次性生成位图。
+数据格式（小端）：
+  头部 32 字节：magic, version, bpp, glyph_count, line_height, base_line,
+                underline_position, underline_thickness, glyph_table_offset, bitmap_offset
+  字形表按 unicode 升序，每项 16 字节：unicode, bitmap_offset, adv_w, box_w, box_h, ofs_x, ofs_y
+  位图每行按字节对齐，高 4 位在前
+
+依赖 freetype-py：pip install freetype-py
+"""
+import argparse
+import struct
+import sys
+
+import freetype
+
+FONT_MAGIC = 0x544E4658  # "XFNT"
+FONT_VERSION = 1
+FONT_BPP = 4
+HEADER_FORMAT = '<IHHIhhhhII4x'
+GLYPH_FORMAT = '<IIHBBbbH'
+
+
+def default_charset():
+    chars = set(range(0x20, 0x7F))
+    # 中文标点、全角符号
+    chars.update(range(0x3000, 0x3020))
+    chars.update(range(0xFF01, 0xFF5F))
+    chars.update((0x2018, 0x2019, 0x201C, 0x201D, 0x2026, 0x2014, 0x00B7))
+    # GB2312 一级汉字 0xB0A1-0xD7F9
+    for high in range(0xB0, 0xD8):
+        for low in range(0xA1, 0xFF):
+            try:
+                chars.add(ord(bytes((high, low)).decode('gb2312')))
+            except UnicodeDecodeError:
+                pass
+    return chars
+
+
+def render_glyph(face, codepoint):
+    face.load_char(chr(codepoint), freetype.FT_LOAD_RENDER | freetype.FT_LOAD_TARGET_NORMAL)
+    glyph = face.glyph
+    bitmap = glyph.bitmap
+    width, rows = bitmap.width, bitmap.rows
+    stride = (width + 1) // 2
+    data = bytearray(stride * rows)
+    for y in range(rows):
+        for x in range(width):
+            value = bitmap.buffer[y * bitmap.pitch + x] >> 4
+            if x & 1:
+                data[y * stride + x // 2] |= value
+            else:
+                data[y * stride + x // 2] |= value << 4
+    adv_w = (glyph.advance.x + 32) >> 6
+    return adv_w, width, rows, glyph.bitmap_left, glyph.bitmap_top - rows, bytes(data)
+
+
+def build(face, size, chars):
+    face.set_pixel_sizes(0, size)
+    glyphs = []
+    bitmaps = bytearray()
+    for codepoint in sorted(chars):
+        if face.get_char_index(codepoint) == 0:
+            continue
+        adv_w, width, rows, ofs_x, ofs_y, data = render_glyph(face, codepoint)
+        if width > 255 or rows > 255:
+            raise ValueError(f'glyph U+{codepoint:04X} too large: {width}x{rows}')
+        glyphs.append(struct.pack(GLYPH_FORMAT, codepoint, len(bitmaps), adv_w, width, rows, ofs_x, ofs_y, 0))
+        bitmaps += data
+
+    ascender = face.size.ascender >> 6
+    descender = face.size.descender >> 6
+    scale = size / face.units_per_EM
+    underline_position = round(face.underline_position * scale)
+    underline_thickness = max(1, round(face.underline_thickness * scale))
+
+    glyph_table_offset = struct.calcsize(HEADER_FORMAT)
+    bitmap_offset = glyph_table_offset + len(glyphs) * struct.calcsize(GLYPH_FORMAT)
+    header = struct.pack(HEADER_FORMAT, FONT_MAGIC, FONT_VERSION, FONT_BPP, len(glyphs),
+                         ascender - descender, -descender, underline_position, underline_thickness,
+                         glyph_table_offset, bitmap_offset)
+    return header + b''.join(glyphs) + bitmaps, len(glyphs)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Rasterize a TTF into a flash font blob')
+    parser.add_argument('ttf')
+    parser.add_argument('--size', type=int, default=20, help='pixel size')
+    parser.add_argument('--charset', help='UTF-8 text file, every character in it is included '
+                                          '(default: ASCII, CJK punctuation and GB2312 level 1)')
+    parser.add_argument('-o', '--output', required=True)
+    args = parser.parse_args()
+
+    if args.charset:
+        with open(args.charset, encoding='utf-8') as f:
+            chars = {ord(c) for c in f.read() if c >= ' '}
+    else:
+        chars = default_charset()
+
+    blob, count = build(freetype.Face(args.ttf), args.size, chars)
+    missing = len(chars) - count
+    if missing:
+        print(f'{missing} characters not in {args.ttf}', file=sys.stderr)
+    with open(args.output, 'wb') as f:
+        f.write(blob)
+    print(f'{count} glyphs, {len(blob)} bytes -> {args.output}')
+
+
+if __name__ == '__main__':
+    main()
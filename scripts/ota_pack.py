@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""
+生成压缩 / 差分固件，供 OTA 使用（设备端解码见 main/ota_decoder.cc）
+
+  # 压缩完整固件，版本检查返回 "encoding": "lz"
+  python scripts/ota_pack.py lz build/xiaozhi.bin -o xiaozhi.lz
+
+  # 以旧固件为基准生成差分补丁，"encoding": "delta"，加 --compress 时为 "delta+lz"
+  python scripts/ota_pack.py delta old/xiaozhi.bin build/xiaozhi.bin -o xiaozhi.patch --compress
+
+版本检查返回的 firmware.sha256 始终是还原后完整镜像的 SHA-256
+"""
+import argparse
+import hashlib
+import struct
+import sys
+
+LZ_MAGIC = b'XZLZ'
+LZ_MIN_MATCH = 4
+DELTA_MAGIC = b'XZDP'
+DELTA_BLOCK = 16
+DELTA_STEP = 8
+DELTA_MIN_COPY = 32
+
+
+def _write_length(out, value):
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+
+
+def _match_length(a, ai, b, bi, limit):
+    length = 0
+    # 先按块比较，再逐字节比较
+    while length + 256 <= limit and a[ai + length:ai + length + 256] == b[bi + length:bi + length + 256]:
+        length += 256
+    while length < limit and a[ai + length] == b[bi + length]:
+        length += 1
+    return length
+
+
+def lz_compress(data, window_bits):
+    window = 1 << window_bits
+    out = bytearray(LZ_MAGIC + bytes([1, window_bits, 0, 0]) + struct.pack('<I', len(data)))
+    table = {}
+    anchor = 0
+    i = 0
+    n = len(data)
+    while i + LZ_MIN_MATCH <= n:
+        key = data[i:i + LZ_MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate >= window:
+            i += 1
+            continue
+
+        length = LZ_MIN_MATCH + _match_length(data, i + LZ_MIN_MATCH, data, candidate + LZ_MIN_MATCH, n - i - LZ_MIN_MATCH)
+        literals = data[anchor:i]
+        literal_code = min(len(literals), 15)
+        match_code = min(length - LZ_MIN_MATCH, 15)
+        out.append((literal_code << 4) | match_code)
+        if literal_code == 15:
+            _write_length(out, len(literals) - 15)
+        out += literals
+        out += struct.pack('<H', i - candidate)
+        if match_code == 15:
+            _write_length(out, length - LZ_MIN_MATCH - 15)
+
+        # 只登记匹配末尾附近的位置，保持编码速度
+        for j in range(max(i + 1, i + length - 8), min(i + length, n - LZ_MIN_MATCH + 1)):
+            table[data[j:j + LZ_MIN_MATCH]] = j
+        i += length
+        anchor = i
+
+    if anchor < n:
+        literals = data[anchor:]
+        literal_code = min(len(literals), 15)
+        out.append(literal_code << 4)
+        if literal_code == 15:
+            _write_length(out, len(literals) - 15)
+        out += literals
+    return bytes(out)
+
+
+def lz_decompress(data):
+    if data[:4] != LZ_MAGIC or data[4] != 1:
+        raise ValueError('invalid LZ header')
+    size = struct.unpack_from('<I', data, 8)[0]
+    out = bytearray()
+    i = 12
+
+    def read_length(value):
+        nonlocal i
+        while True:
+            byte = data[i]
+            i += 1
+            value += byte
+            if byte != 255:
+                return value
+
+    while len(out) < size:
+        token = data[i]
+        i += 1
+        literal_length = token >> 4
+        if literal_length == 15:
+            literal_length = read_length(literal_length)
+        out += data[i:i + literal_length]
+        i += literal_length
+        if len(out) >= size:
+            break
+        offset = struct.unpack_from('<H', data, i)[0]
+        i += 2
+        match_length = (token & 0x0f) + LZ_MIN_MATCH
+        if match_length == 15 + LZ_MIN_MATCH:
+            match_length = read_length(match_length)
+        for _ in range(match_length):
+            out.append(out[-offset])
+    if i != len(data) or len(out) != size:
+        raise ValueError('corrupted LZ stream')
+    return bytes(out)
+
+
+def make_delta(old, new):
+    index = {}
+    for p in range(0, len(old) - DELTA_BLOCK + 1, DELTA_STEP):
+        index.setdefault(old[p:p + DELTA_BLOCK], p)
+
+    out = bytearray(DELTA_MAGIC + bytes([1, 0, 0, 0]))
+    out += struct.pack('<I', len(old)) + hashlib.sha256(old).digest() + struct.pack('<I', len(new))
+
+    def insert(data):
+        if data:
+            out.extend(b'I' + struct.pack('<I', len(data)) + data)
+
+    copied = 0
+    pending = 0
+    i = 0
+    while i + DELTA_BLOCK <= len(new):
+        p = index.get(new[i:i + DELTA_BLOCK])
+        if p is None:
+            i += 1
+            continue
+
+        # 向前、向后扩展匹配
+        start, base = i, p
+        while start > pending and base > 0 and new[start - 1] == old[base - 1]:
+            start -= 1
+            base -= 1
+        end = i + DELTA_BLOCK + _match_length(new, i + DELTA_BLOCK, old, p + DELTA_BLOCK,
+                                              min(len(new) - i, len(old) - p) - DELTA_BLOCK)
+        if end - start < DELTA_MIN_COPY:
+            i += 1
+            continue
+
+        insert(new[pending:start])
+        out += b'C' + struct.pack('<II', base, end - start)
+        copied += end - start
+        i = pending = end
+
+    insert(new[pending:])
+    out += b'E'
+    return bytes(out), copied
+
+
+def apply_delta(old, patch):
+    if patch[:4] != DELTA_MAGIC or patch[4] != 1:
+        raise ValueError('invalid delta header')
+    base_size = struct.unpack_from('<I', patch, 8)[0]
+    if hashlib.sha256(old[:base_size]).digest() != patch[12:44]:
+        raise ValueError('delta base mismatch')
+    size = struct.unpack_from('<I', patch, 44)[0]
+    out = bytearray()
+    i = 48
+    while True:
+        op = patch[i:i + 1]
+        i += 1
+        if op == b'C':
+            offset, length = struct.unpack_from('<II', patch, i)
+            i += 8
+            out += old[offset:offset + length]
+        elif op == b'I':
+            length = struct.unpack_from('<I', patch, i)[0]
+            i += 4
+            out += patch[i:i + length]
+            i += length
+        elif op == b'E':
+            break
+        else:
+            raise ValueError('invalid delta opcode')
+    if len(out) != size:
+        raise ValueError('corrupted delta patch')
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate compressed or delta OTA images')
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    lz_parser = subparsers.add_parser('lz', help='compress a full application image')
+    lz_parser.add_argument('image')
+    lz_parser.add_argument('-o', '--output', required=True)
+    lz_parser.add_argument('--window-bits', type=int, default=12, help='decoder RAM window, 2^bits bytes (8-16)')
+
+    delta_parser = subparsers.add_parser('delta', help='make a patch against the currently running image')
+    delta_parser.add_argument('base')
+    delta_parser.add_argument('image')
+    delta_parser.add_argument('-o', '--output', required=True)
+    delta_parser.add_argument('--compress', action='store_true', help='compress the patch (encoding "delta+lz")')
+    delta_parser.add_argument('--window-bits', type=int, default=12, help='decoder RAM window, 2^bits bytes (8-16)')
+
+    args = parser.parse_args()
+    if not 8 <= args.window_bits <= 16:
+        parser.error('--window-bits must be between 8 and 16')
+
+    with open(args.image, 'rb') as f:
+        image = f.read()
+
+    if args.command == 'lz':
+        output = lz_compress(image, args.window_bits)
+        assert lz_decompress(output) == image
+        encoding = 'lz'
+    else:
+        with open(args.base, 'rb') as f:
+            base = f.read()
+        output, copied = make_delta(base, image)
+        assert apply_delta(base, output) == image
+        print(f'copied from base: {copied}/{len(image)} bytes')
+        encoding = 'delta'
+        if args.compress:
+            output = lz_compress(output, args.window_bits)
+            assert apply_delta(base, lz_decompress(output)) == image
+            encoding = 'delta+lz'
+
+    with open(args.output, 'wb') as f:
+        f.write(output)
+
+    print(f'{args.output}: {len(output)} bytes ({len(output) * 100 / max(len(image), 1):.1f}% of {len(image)})')
+    print(f'"encoding": "{encoding}", "sha256": "{hashlib.sha256(image).hexdigest()}"')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
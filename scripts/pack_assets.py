@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+把提示音、动画、字体等资源打包成 assets 分区镜像（设备端读取见 main/assets.cc）
+
+  # 打包中文提示音和 spiffs 目录下的动画
+  python scripts/pack_assets.py --lang zh-CN --anim spiffs -o build/assets.bin
+
+  # 额外加入字体数据，设备端以 "fonts/puhui_20_4.bin" 查找
+  python scripts/pack_assets.py --lang zh-CN --font puhui_20_4.bin=path/to/font.bin -o build/assets.bin
+
+  # 烧录到 assets 分区
+  parttool.py write_partition --partition-name assets --input build/assets.bin
+
+资源按名字排序建立索引，设备端二分查找；数据块 16 字节对齐，映射后可直接访问
+"""
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+ASSETS_MAGIC = 0x54534158  # "XAST"
+ASSETS_VERSION = 1
+ASSETS_ALIGNMENT = 16
+NAME_SIZE = 40
+HEADER_FORMAT = '<IHHII16s'
+ENTRY_FORMAT = '<%dsII' % NAME_SIZE
+
+
+def _align(value):
+    return (value + ASSETS_ALIGNMENT - 1) // ASSETS_ALIGNMENT * ASSETS_ALIGNMENT
+
+
+def collect_files(directory, prefix, extensions):
+    assets = {}
+    for file in sorted(os.listdir(directory)):
+        if os.path.splitext(file)[1] in extensions:
+            assets[f'{prefix}/{file}'] = os.path.join(directory, file)
+    return assets
+
+
+def pack(assets, language):
+    names = sorted(assets, key=lambda name: name.encode('utf-8'))
+    index_end = struct.calcsize(HEADER_FORMAT) + len(names) * struct.calcsize(ENTRY_FORMAT)
+
+    index = bytearray()
+    data = bytearray()
+    offset = _align(index_end)
+    for name in names:
+        encoded = name.encode('utf-8')
+        if len(encoded) > NAME_SIZE:
+            raise ValueError(f'asset name too long (max {NAME_SIZE} bytes): {name}')
+        with open(assets[name], 'rb') as f:
+            blob = f.read()
+        index += struct.pack(ENTRY_FORMAT, encoded, offset, len(blob))
+        data += blob
+        data += bytes(_align(len(blob)) - len(blob))
+        offset += _align(len(blob))
+
+    header = struct.pack(HEADER_FORMAT, ASSETS_MAGIC, ASSETS_VERSION, len(names), offset,
+                         zlib.crc32(index), language.encode('utf-8'))
+    padding = bytes(_align(index_end) - index_end)
+    return header + index + padding + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build the assets partition image')
+    parser.add_argument('--lang', required=True, help='language directory under main/assets, e.g. zh-CN')
+    parser.add_argument('--assets-dir', default=os.path.join(os.path.dirname(__file__), '..', 'main', 'assets'),
+                        help='directory that contains common/ and the language directories')
+    parser.add_argument('--anim', action='append', default=[], help='directory of .avi clips, stored as anim/<file>')
+    parser.add_argument('--font', action='append', default=[], help='NAME=PATH, stored as fonts/NAME')
+    parser.add_argument('--partition-size', type=lambda x: int(x, 0), help='fail if the image does not fit')
+    parser.add_argument('-o', '--output', required=True)
+    args = parser.parse_args()
+
+    # 语言目录中的同名音效覆盖公共音效
+    assets = collect_files(os.path.join(args.assets_dir, 'common'), 'sounds', ('.p3',))
+    assets.update(collect_files(os.path.join(args.assets_dir, args.lang), 'sounds', ('.p3',)))
+    for directory in args.anim:
+        assets.update(collect_files(directory, 'anim', ('.avi',)))
+    for font in args.font:
+        name, _, path = font.partition('=')
+        if not path:
+            parser.error(f'--font expects NAME=PATH: {font}')
+        assets[f'fonts/{name}'] = path
+
+    image = pack(assets, args.lang)
+    if args.partition_size is not None and len(image) > args.partition_size:
+        print(f'assets image is {len(image)} bytes, partition is {args.partition_size} bytes', file=sys.stderr)
+        # 按目录汇总，方便判断该缩小字体字符集/字号还是在分区表中扩大 assets 分区
+        totals = {}
+        for name, path in assets.items():
+            kind = name.split('/')[0]
+            totals[kind] = totals.get(kind, 0) + os.path.getsize(path)
+        for kind, size in sorted(totals.items()):
+            print(f'  {kind}: {size} bytes', file=sys.stderr)
+        print('shrink the font (charset or --size) or enlarge the assets partition in the partition table',
+              file=sys.stderr)
+        sys.exit(1)
+
+    with open(args.output, 'wb') as f:
+        f.write(image)
+    print(f'{len(assets)} assets, {len(image)} bytes -> {args.output}')
+
+
+if __name__ == '__main__':
+    main()
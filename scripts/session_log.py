@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+解析设备 record 命令录制的会话日志，格式见 main/session_log.h
+
+  # 设备上 record dump 输出到串口，保存串口日志后还原成二进制
+  python scripts/session_log.py --serial monitor.txt -o session.bin
+  # 打印概要和 JSON 时间线，并把麦克风数据导出成 wav
+  python scripts/session_log.py session.bin --wav mic.wav
+
+还原出的文件可以放到设备文件系统上，用 replay <path> [speed] 回放
+"""
+import argparse
+import base64
+import json
+import struct
+import sys
+import wave
+
+SESSION_LOG_MAGIC = 0x43455258  # "XREC"
+SESSION_LOG_VERSION = 1
+HEADER_FORMAT = '<IHHII'
+RECORD_FORMAT = '<B3xII'
+
+RECORD_CHANNEL_OPENED = 1
+RECORD_CHANNEL_CLOSED = 2
+RECORD_MIC_PCM = 3
+RECORD_DOWNLINK_AUDIO = 4
+RECORD_DOWNLINK_JSON = 5
+
+
+def from_serial(path):
+    chunks = []
+    expected = None
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        for line in f:
+            # 串口日志里可能混有 ESP_LOG 前缀，从 RECORD 开始截取
+            pos = line.find('RECORD ')
+            if pos < 0:
+                continue
+            value = line[pos + len('RECORD '):].strip()
+            if value.startswith('END'):
+                expected = int(value.split()[1])
+                break
+            chunks.append(base64.b64decode(value))
+    data = b''.join(chunks)
+    if expected is None:
+        sys.exit('No "RECORD END" line found, the dump is incomplete')
+    if len(data) != expected:
+        sys.exit(f'Dump size mismatch: got {len(data)} bytes, expected {expected}')
+    return data
+
+
+def parse(data):
+    header_size = struct.calcsize(HEADER_FORMAT)
+    if len(data) < header_size:
+        sys.exit('File too small')
+    magic, version, channels, sample_rate, _ = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != SESSION_LOG_MAGIC or version != SESSION_LOG_VERSION:
+        sys.exit('Not a session log')
+
+    records = []
+    record_size = struct.calcsize(RECORD_FORMAT)
+    offset = header_size
+    while offset + record_size <= len(data):
+        type_, timestamp, size = struct.unpack_from(RECORD_FORMAT, data, offset)
+        offset += record_size
+        if offset + size > len(data):
+            print(f'Truncated record at offset {offset - record_size}', file=sys.stderr)
+            break
+        records.append((type_, timestamp, data[offset:offset + size]))
+        offset += (size + 3) & ~3
+    return channels, sample_rate, records
+
+
+def summarize(channels, sample_rate, records):
+    """和设备上 SessionLogReader::Summarize 的统计一致，replay 输出的 REPLAY 统计以此为准"""
+    summary = {
+        'recorded_ms': records[-1][1] if records else 0,
+        'server_sample_rate': 0,
+        'server_frame_duration': 0,
+        'mic_records': 0,
+        'mic_samples': 0,
+        'downlink_packets': 0,
+        'downlink_bytes': 0,
+        'json_messages': 0,
+        'closed': False,
+    }
+    for type_, _, payload in records:
+        if type_ == RECORD_CHANNEL_OPENED and len(payload) >= 8:
+            summary['server_sample_rate'], summary['server_frame_duration'] = struct.unpack_from('<II', payload)
+        elif type_ == RECORD_CHANNEL_CLOSED:
+            summary['closed'] = True
+        elif type_ == RECORD_MIC_PCM:
+            summary['mic_records'] += 1
+            summary['mic_samples'] += len(payload) // 2
+        elif type_ == RECORD_DOWNLINK_AUDIO:
+            summary['downlink_packets'] += 1
+            summary['downlink_bytes'] += len(payload)
+        elif type_ == RECORD_DOWNLINK_JSON:
+            summary['json_messages'] += 1
+    summary['mic_ms'] = summary['mic_samples'] * 1000 // (sample_rate * channels) if sample_rate and channels else 0
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Inspect a recorded voice session')
+    parser.add_argument('input', help='session log, or serial capture with --serial')
+    parser.add_argument('--serial', action='store_true', help='input is a serial log containing "record dump" output')
+    parser.add_argument('-o', '--output', help='write the binary session log (with --serial)')
+    parser.add_argument('--wav', help='export the microphone PCM as wav')
+    args = parser.parse_args()
+
+    if args.serial:
+        data = from_serial(args.input)
+        if args.output:
+            with open(args.output, 'wb') as f:
+                f.write(data)
+            print(f'Wrote {len(data)} bytes to {args.output}')
+    else:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+
+    channels, sample_rate, records = parse(data)
+    mic = bytearray()
+    for type_, timestamp, payload in records:
+        if type_ == RECORD_CHANNEL_OPENED:
+            server_rate, frame_duration = struct.unpack_from('<II', payload)
+            print(f'{timestamp:8d} ms  channel opened, server {server_rate} Hz / {frame_duration} ms')
+        elif type_ == RECORD_CHANNEL_CLOSED:
+            print(f'{timestamp:8d} ms  channel closed')
+        elif type_ == RECORD_MIC_PCM:
+            mic += payload
+        elif type_ == RECORD_DOWNLINK_JSON:
+            text = payload.decode('utf-8', errors='replace')
+            try:
+                text = json.dumps(json.loads(text), ensure_ascii=False)
+            except ValueError:
+                pass
+            print(f'{timestamp:8d} ms  {text}')
+
+    summary = summarize(channels, sample_rate, records)
+    print(f'input {sample_rate} Hz x {channels}, {summary["recorded_ms"]} ms, {len(records)} records')
+    print(f'mic {len(mic)} bytes ({summary["mic_ms"]} ms), '
+          f'downlink {summary["downlink_packets"]} packets / {summary["downlink_bytes"]} bytes')
+    if not summary['closed']:
+        print('warning: no channel closed record, the recording was truncated')
+
+    if args.wav:
+        with wave.open(args.wav, 'wb') as w:
+            w.setnchannels(channels)
+            w.setsampwidth(2)
+            w.setframerate(sample_rate)
+            w.writeframes(bytes(mic))
+        print(f'Wrote {args.wav}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,240 @@
+// AecReference 的回声测试：模拟扬声器播放、带延迟和混响的回声路径以及麦克风采集，
+// 按 AudioCodec 的方式写入带播放时间的参考信号、按采集时间取出对齐的参考，
+// 再用一个 NLMS 自适应滤波器消除回声，测量回声回损 (ERL) 和回声消除量 (ERLE)
+#include "audio_codecs/aec_reference.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int kSampleRate = 16000;
+// 和 AudioCodec 一样：播放按 60ms 一帧写入，采集按 32ms 一帧读取
+const int kPlayFrame = kSampleRate * 60 / 1000;
+const int kCaptureFrame = 512;
+// 写入时数据进入 DMA 队列，大约 90ms 后才从扬声器播出
+const int64_t kQueueLatencyUs = 90000;
+
+struct EchoPath {
+    // 声学延迟和衰减，以及两条较弱的反射
+    double delay_ms = 3.0;
+    double gain = 0.3;
+    // 播放时间估计的固定偏差。AudioCodec 在 DMA 队列未满时把每块接在上一块之后，估计误差表现为整体偏移
+    double bias_ms = 0.0;
+    // 播放中间的一段静音（样本区间），验证空隙处参考信号为 0
+    int pause_begin = 0;
+    int pause_end = 0;
+};
+
+struct Capture {
+    std::vector<int16_t> mic;
+    std::vector<int16_t> reference;
+    std::vector<double> echo;
+};
+
+// 带限噪声，频谱大致落在语音频段
+std::vector<int16_t> MakePlayback(int samples, const EchoPath& path) {
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0, 6000);
+    std::vector<int16_t> playback(samples);
+    double low = 0, high = 0;
+    for (int i = 0; i < samples; i++) {
+        double x = noise(rng);
+        low += 0.3 * (x - low);
+        high += 0.02 * (low - high);
+        double value = (low - high) * 1.5;
+        if (i >= path.pause_begin && i < path.pause_end) {
+            value = 0;
+        }
+        playback[i] = (int16_t)std::clamp(value, -32768.0, 32767.0);
+    }
+    return playback;
+}
+
+Capture Simulate(const std::vector<int16_t>& playback, const EchoPath& path) {
+    const int64_t start_us = 1000000;
+    const int samples = playback.size();
+    AecReference reference(kSampleRate, 500);
+    std::mt19937 rng(99);
+    std::normal_distribution<double> mic_noise(0, 3);
+
+    // 回声 = 延迟后的直达声 + 两条反射，麦克风叠加底噪
+    Capture capture;
+    capture.echo.resize(samples);
+    capture.mic.resize(samples);
+    int delay = path.delay_ms * kSampleRate / 1000;
+    for (int i = 0; i < samples; i++) {
+        double echo = 0;
+        if (i - delay >= 0) {
+            echo += path.gain * playback[i - delay];
+        }
+        if (i - delay - 16 >= 0) {
+            echo += path.gain * 0.4 * playback[i - delay - 16];
+        }
+        if (i - delay - 40 >= 0) {
+            echo -= path.gain * 0.2 * playback[i - delay - 40];
+        }
+        capture.echo[i] = echo;
+        capture.mic[i] = (int16_t)std::clamp(echo + mic_noise(rng), -32768.0, 32767.0);
+    }
+
+    // 按事件时间交替写入和读取：播放帧在播出前 kQueueLatencyUs 写入，采集帧在采集完成后读取
+    int next_play = 0;
+    capture.reference.resize(samples);
+    for (int offset = 0; offset + kCaptureFrame <= samples; offset += kCaptureFrame) {
+        int64_t capture_end_us = start_us + (int64_t)(offset + kCaptureFrame) * 1000000 / kSampleRate;
+        while (next_play < samples) {
+            int64_t play_us = start_us + (int64_t)next_play * 1000000 / kSampleRate;
+            if (play_us - kQueueLatencyUs > capture_end_us) {
+                break;
+            }
+            int length = std::min(kPlayFrame, samples - next_play);
+            bool silent = next_play >= path.pause_begin && next_play + length <= path.pause_end;
+            if (!silent) {
+                int64_t estimate_us = play_us + (int64_t)(path.bias_ms * 1000);
+                reference.Write(playback.data() + next_play, length, estimate_us);
+            }
+            next_play += length;
+        }
+        int64_t capture_start_us = start_us + (int64_t)offset * 1000000 / kSampleRate;
+        reference.Read(capture.reference.data() + offset, kCaptureFrame, capture_start_us);
+    }
+    return capture;
+}
+
+double Power(const std::vector<double>& signal, int begin, int end) {
+    double sum = 0;
+    for (int i = begin; i < end; i++) {
+        sum += signal[i] * signal[i];
+    }
+    return sum / std::max(end - begin, 1);
+}
+
+// 参考信号与回声的功率比
+double MeasureErlDb(const Capture& capture, int begin, int end) {
+    std::vector<double> reference(capture.reference.begin(), capture.reference.end());
+    return 10 * std::log10(Power(reference, begin, end) / std::max(Power(capture.echo, begin, end), 1e-9));
+}
+
+// 256 抽头 (16ms) 的 NLMS，回声路径和对齐误差都落在窗口内时可以收敛，返回后半段的回声消除量
+double MeasureErleDb(const Capture& capture) {
+    const int taps = 256;
+    const double mu = 0.5;
+    int samples = capture.mic.size();
+    std::vector<double> weights(taps, 0), history(taps, 0);
+    std::vector<double> mic(samples), residual(samples);
+    double energy = 0;
+    for (int i = 0; i < samples; i++) {
+        double x = capture.reference[i];
+        energy += x * x - history[taps - 1] * history[taps - 1];
+        std::move_backward(history.begin(), history.end() - 1, history.end());
+        history[0] = x;
+
+        double estimate = 0;
+        for (int k = 0; k < taps; k++) {
+            estimate += weights[k] * history[k];
+        }
+        mic[i] = capture.mic[i];
+        residual[i] = mic[i] - estimate;
+        double step = mu * residual[i] / (energy + 1e3);
+        for (int k = 0; k < taps; k++) {
+            weights[k] += step * history[k];
+        }
+    }
+    return 10 * std::log10(Power(mic, samples / 2, samples) / std::max(Power(residual, samples / 2, samples), 1e-9));
+}
+
+// 参考信号相对麦克风信号的超前量（毫秒），正值表示参考先于回声，自适应滤波器可以覆盖
+double MeasureLeadMs(const Capture& capture, int begin, int end) {
+    int best_lag = 0;
+    double best = -1;
+    for (int lag = -160; lag <= 160; lag++) {
+        double sum = 0;
+        for (int i = begin; i < end; i++) {
+            if (i - lag >= 0 && i - lag < (int)capture.reference.size()) {
+                sum += (double)capture.mic[i] * capture.reference[i - lag];
+            }
+        }
+        if (sum > best) {
+            best = sum;
+            best_lag = lag;
+        }
+    }
+    return best_lag * 1000.0 / kSampleRate;
+}
+
+}  // namespace
+
+TEST(AecReferenceTest, AlignedReferenceCancelsEcho) {
+    EchoPath path;
+    auto playback = MakePlayback(kSampleRate * 6, path);
+    auto capture = Simulate(playback, path);
+
+    int begin = kSampleRate, end = capture.mic.size() - kSampleRate;
+    double erl = MeasureErlDb(capture, begin, end);
+    double lead = MeasureLeadMs(capture, begin, begin + kSampleRate);
+    double erle = MeasureErleDb(capture);
+    printf("AEC {\"case\":\"aligned\",\"erl_db\":%.1f,\"lead_ms\":%.2f,\"erle_db\":%.1f}\n", erl, lead, erle);
+
+    // 0.3 倍直达声加两条反射，ERL 约 10dB
+    EXPECT_NEAR(erl, 10, 2);
+    EXPECT_GE(lead, 0);
+    EXPECT_LE(lead, 8);
+    EXPECT_GE(erle, 20);
+}
+
+TEST(AecReferenceTest, EarlyEstimateStaysWithinFilter) {
+    // 播放时间估计早了 4ms，参考更加超前，仍在滤波器窗口内
+    EchoPath path;
+    path.bias_ms = -4;
+    auto playback = MakePlayback(kSampleRate * 6, path);
+    auto capture = Simulate(playback, path);
+
+    double lead = MeasureLeadMs(capture, kSampleRate, kSampleRate * 2);
+    double erle = MeasureErleDb(capture);
+    printf("AEC {\"case\":\"early_4ms\",\"lead_ms\":%.2f,\"erle_db\":%.1f}\n", lead, erle);
+    EXPECT_NEAR(lead, 7, 0.5);
+    EXPECT_GE(erle, 20);
+}
+
+TEST(AecReferenceTest, MisalignedReferenceDoesNotCancel) {
+    // 播放时间估计晚了 40ms，参考落后于回声，超出滤波器能覆盖的范围
+    EchoPath path;
+    path.bias_ms = 40;
+    auto playback = MakePlayback(kSampleRate * 6, path);
+    auto capture = Simulate(playback, path);
+
+    double erle = MeasureErleDb(capture);
+    printf("AEC {\"case\":\"late_40ms\",\"erle_db\":%.1f}\n", erle);
+    EXPECT_LT(erle, 6);
+}
+
+TEST(AecReferenceTest, PlaybackGapReadsSilence) {
+    EchoPath path;
+    path.pause_begin = kSampleRate * 2;
+    path.pause_end = kSampleRate * 3;
+    auto playback = MakePlayback(kSampleRate * 5, path);
+    auto capture = Simulate(playback, path);
+
+    // 间隙内（留出对齐误差和回声延迟的余量）参考全为 0，间隙后恢复
+    int nonzero = 0;
+    for (int i = path.pause_begin + kSampleRate / 20; i < path.pause_end - kSampleRate / 20; i++) {
+        nonzero += capture.reference[i] != 0;
+    }
+    EXPECT_EQ(nonzero, 0);
+    double erl = MeasureErlDb(capture, path.pause_end + kSampleRate / 10, path.pause_end + kSampleRate);
+    EXPECT_NEAR(erl, 10, 2);
+}
+
+TEST(AecReferenceTest, ReadBeforeAnyWriteIsSilent) {
+    AecReference reference(kSampleRate, 500);
+    std::vector<int16_t> data(kCaptureFrame, 1);
+    reference.Read(data.data(), data.size(), 123456);
+    for (auto sample : data) {
+        ASSERT_EQ(sample, 0);
+    }
+}
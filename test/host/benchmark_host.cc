@@ -0,0 +1,67 @@
+// 在主机上运行 main/benchmark.cc 中的通用测试组，参数和设备上的 bench 命令相同：
+//   benchmark_host list
+//   benchmark_host [-n iterations] [suite...]
+// 主机上按纳秒计时，只用于对比同一台机器上的修改前后
+#include "benchmark.h"
+#include "iot/thing_manager.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace iot {
+
+// 和 Speaker、Lamp 规模相当的设备，让 thing 测试组有内容可以序列化
+class BenchLamp : public Thing {
+public:
+    BenchLamp(const std::string& name) : Thing(name, "测试用的灯") {
+        properties_.AddBooleanProperty("power", "灯是否打开", [this]() -> bool {
+            return power_;
+        });
+        properties_.AddNumberProperty("brightness", "当前亮度", [this]() -> int {
+            return brightness_;
+        });
+        methods_.AddMethod("TurnOn", "打开灯", ParameterList(), [this](const ParameterList& parameters) {
+            power_ = true;
+        });
+        methods_.AddMethod("SetBrightness", "设置亮度", ParameterList({
+            Parameter("brightness", "0到100之间的整数", kValueTypeNumber, true)
+        }), [this](const ParameterList& parameters) {
+            brightness_ = parameters["brightness"].number();
+        });
+    }
+
+private:
+    bool power_ = false;
+    int brightness_ = 50;
+};
+
+} // namespace iot
+
+int main(int argc, char** argv) {
+    auto& thing_manager = iot::ThingManager::GetInstance();
+    for (auto name : {"Lamp", "DeskLamp", "Nightlight"}) {
+        thing_manager.AddThing(new iot::BenchLamp(name));
+    }
+
+    auto& bench = Benchmark::GetInstance();
+    bench.RegisterDefaultSuites();
+    if (argc > 1 && strcmp(argv[1], "list") == 0) {
+        for (auto& name : bench.GetSuiteNames()) {
+            printf("%s\n", name.c_str());
+        }
+        return 0;
+    }
+
+    std::vector<std::string> names;
+    int iterations = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    bench.Run(names, iterations);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// OtaRingBuffer 的生产者/消费者测试：生产者模拟按不定长度到达的 HTTP 数据，
+// 消费者按整块写入一个内存中的假分区，校验数据完整以及取消时两端都能退出
+#include "ota_ring_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<char> MakeImage(size_t size) {
+    std::vector<char> image(size);
+    std::mt19937 rng(1234);
+    for (auto& byte : image) {
+        byte = (char)rng();
+    }
+    return image;
+}
+
+// 按 1..max_read 的随机长度写入，偶尔停顿，模拟不稳定的网络
+void FeedImage(OtaRingBuffer& ring, const std::vector<char>& image, size_t max_read, bool finish) {
+    std::mt19937 rng(42);
+    size_t offset = 0;
+    while (offset < image.size()) {
+        size_t length = std::min<size_t>(rng() % max_read + 1, image.size() - offset);
+        if (!ring.Write(image.data() + offset, length)) {
+            return;
+        }
+        offset += length;
+        if (rng() % 64 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    if (finish) {
+        ring.Finish();
+    }
+}
+
+}  // namespace
+
+TEST(OtaRingBufferTest, PipelineDeliversImageInWholeChunks) {
+    const size_t kChunkSize = 16384;
+    // 不是块大小的整数倍，最后一块不满
+    auto image = MakeImage(kChunkSize * 37 + 1234);
+    OtaRingBuffer ring(48 * 1024 + 100);
+    ASSERT_TRUE(ring.valid());
+
+    std::thread producer(FeedImage, std::ref(ring), std::cref(image), 4096, true);
+
+    std::vector<char> partition;
+    std::vector<char> chunk(kChunkSize);
+    size_t partial_chunks = 0;
+    while (true) {
+        size_t length = ring.Read(chunk.data(), chunk.size());
+        if (length == 0) {
+            break;
+        }
+        if (length != kChunkSize) {
+            partial_chunks++;
+        }
+        partition.insert(partition.end(), chunk.begin(), chunk.begin() + length);
+        // 模拟擦写扇区的耗时，让生产者有机会把缓冲区写满
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+    }
+    producer.join();
+
+    EXPECT_EQ(partial_chunks, 1u);
+    EXPECT_EQ(partition, image);
+    EXPECT_FALSE(ring.cancelled());
+}
+
+TEST(OtaRingBufferTest, ReadReturnsRemainderAfterFinish) {
+    OtaRingBuffer ring(1024);
+    ASSERT_TRUE(ring.Write("abcdef", 6));
+    ring.Finish();
+
+    char data[16];
+    EXPECT_EQ(ring.Read(data, sizeof(data)), 6u);
+    EXPECT_EQ(std::string(data, 6), "abcdef");
+    EXPECT_EQ(ring.Read(data, sizeof(data)), 0u);
+}
+
+TEST(OtaRingBufferTest, ConsumerCancelReleasesBlockedProducer) {
+    auto image = MakeImage(64 * 1024);
+    OtaRingBuffer ring(4096);
+
+    // 消费者不读取，生产者写满后阻塞，取消后 Write 返回 false
+    bool result = true;
+    std::thread producer([&]() {
+        result = ring.Write(image.data(), image.size());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ring.Cancel();
+    producer.join();
+
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(ring.cancelled());
+    EXPECT_GT(ring.producer_wait_us(), 0);
+}
+
+TEST(OtaRingBufferTest, ProducerCancelReleasesBlockedConsumer) {
+    OtaRingBuffer ring(4096);
+
+    size_t length = 1;
+    std::thread consumer([&]() {
+        char data[512];
+        length = ring.Read(data, sizeof(data));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ring.Cancel();
+    consumer.join();
+
+    EXPECT_EQ(length, 0u);
+    EXPECT_GT(ring.consumer_wait_us(), 0);
+}
+
+TEST(OtaRingBufferTest, WritesAfterCancelAreRejected) {
+    OtaRingBuffer ring(1024);
+    ring.Cancel();
+    EXPECT_FALSE(ring.Write("x", 1));
+
+    char data[4];
+    EXPECT_EQ(ring.Read(data, sizeof(data)), 0u);
+}
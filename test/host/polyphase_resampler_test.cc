@@ -0,0 +1,184 @@
+// PolyphaseResampler 的质量和速度测试：正弦波 SNR、阻带混叠、分帧与整段处理一致、立体声与单声道一致，
+// 并打印每 60ms 帧的处理耗时，便于和设备上的 bench resampler 对比
+#include "audio_processing/polyphase_resampler.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+std::vector<int16_t> MakeTone(int sample_rate, double frequency, double seconds, double amplitude = 16384) {
+    std::vector<int16_t> samples(sample_rate * seconds);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = (int16_t)std::lround(amplitude * std::sin(2 * M_PI * frequency * i / sample_rate));
+    }
+    return samples;
+}
+
+// 按 60ms 一帧处理，和设备上的调用方式一致
+template <typename Resampler>
+std::vector<int16_t> ResampleInFrames(Resampler& resampler, const std::vector<int16_t>& input, int frame_samples) {
+    std::vector<int16_t> output;
+    for (size_t offset = 0; offset < input.size(); offset += frame_samples) {
+        int length = std::min<size_t>(frame_samples, input.size() - offset);
+        size_t position = output.size();
+        output.resize(position + resampler.GetOutputSamples(length));
+        int written = resampler.Process(input.data() + offset, length, output.data() + position);
+        output.resize(position + written);
+    }
+    return output;
+}
+
+// 在已知频率上最小二乘拟合 a*sin + b*cos + c，残差视为噪声
+double MeasureSnrDb(const std::vector<int16_t>& samples, size_t skip, int sample_rate, double frequency) {
+    double ss = 0, sc = 0, cc = 0, s1 = 0, c1 = 0, n = 0, ys = 0, yc = 0, y1 = 0;
+    for (size_t i = skip; i < samples.size(); i++) {
+        double s = std::sin(2 * M_PI * frequency * i / sample_rate);
+        double c = std::cos(2 * M_PI * frequency * i / sample_rate);
+        double y = samples[i];
+        ss += s * s; sc += s * c; cc += c * c; s1 += s; c1 += c; n += 1;
+        ys += y * s; yc += y * c; y1 += y;
+    }
+    // 3x3 正规方程，用克拉默法则求解
+    double m[3][3] = {{ss, sc, s1}, {sc, cc, c1}, {s1, c1, n}};
+    double v[3] = {ys, yc, y1};
+    auto det = [](double a[3][3]) {
+        return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+            a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    };
+    double d = det(m);
+    double coefficients[3];
+    for (int k = 0; k < 3; k++) {
+        double t[3][3];
+        for (int r = 0; r < 3; r++) {
+            for (int col = 0; col < 3; col++) {
+                t[r][col] = col == k ? v[r] : m[r][col];
+            }
+        }
+        coefficients[k] = det(t) / d;
+    }
+
+    double signal = 0, noise = 0;
+    for (size_t i = skip; i < samples.size(); i++) {
+        double fit = coefficients[0] * std::sin(2 * M_PI * frequency * i / sample_rate) +
+            coefficients[1] * std::cos(2 * M_PI * frequency * i / sample_rate) + coefficients[2];
+        signal += fit * fit;
+        noise += (samples[i] - fit) * (samples[i] - fit);
+    }
+    return 10 * std::log10(signal / std::max(noise, 1e-9));
+}
+
+double RmsDbfs(const std::vector<int16_t>& samples, size_t skip) {
+    double sum = 0;
+    for (size_t i = skip; i < samples.size(); i++) {
+        sum += (double)samples[i] * samples[i];
+    }
+    double rms = std::sqrt(sum / std::max<size_t>(samples.size() - skip, 1));
+    return 20 * std::log10(std::max(rms, 1e-3) / 32768);
+}
+
+template <int InputRate, int OutputRate, int Taps>
+double MeasureSpeedUs() {
+    PolyphaseResampler<InputRate, OutputRate, 1, Taps> resampler;
+    auto input = MakeTone(InputRate, 1000, 0.06);
+    std::vector<int16_t> output(resampler.GetOutputSamples(input.size()) + 8);
+    const int iterations = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        resampler.Process(input.data(), input.size(), output.data());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+}
+
+// 1kHz 正弦的 SNR 和（降采样时）阻带中一个音的残留电平
+template <int InputRate, int OutputRate, int Taps>
+void CheckQuality(double min_snr_db, double stopband_frequency, double max_alias_db) {
+    const int frame_samples = InputRate * 60 / 1000;
+    const size_t skip = OutputRate / 10;
+
+    PolyphaseResampler<InputRate, OutputRate, 1, Taps> resampler;
+    auto output = ResampleInFrames(resampler, MakeTone(InputRate, 1000, 2), frame_samples);
+    ASSERT_NEAR((double)output.size(), OutputRate * 2.0, Taps);
+    double snr = MeasureSnrDb(output, skip, OutputRate, 1000);
+
+    double alias = 0;
+    if (stopband_frequency > 0) {
+        PolyphaseResampler<InputRate, OutputRate, 1, Taps> stopband;
+        alias = RmsDbfs(ResampleInFrames(stopband, MakeTone(InputRate, stopband_frequency, 2), frame_samples), skip) -
+            RmsDbfs(MakeTone(InputRate, stopband_frequency, 2), 0);
+    }
+
+    char alias_text[16] = "null";
+    if (stopband_frequency > 0) {
+        snprintf(alias_text, sizeof(alias_text), "%.1f", alias);
+    }
+    printf("RESAMPLER {\"input\":%d,\"output\":%d,\"taps\":%d,\"snr_db\":%.1f,\"alias_db\":%s,\"us_per_frame\":%.2f}\n",
+        InputRate, OutputRate, Taps, snr, alias_text, MeasureSpeedUs<InputRate, OutputRate, Taps>());
+    EXPECT_GE(snr, min_snr_db);
+    if (stopband_frequency > 0) {
+        EXPECT_LE(alias, max_alias_db);
+    }
+}
+
+}  // namespace
+
+// 抽头数与 audio_resampler.cc 中 CreatePolyphase 的选择一致
+TEST(PolyphaseResamplerTest, Upsample16kTo24k) {
+    CheckQuality<16000, 24000, 32>(74, 0, 0);
+}
+
+TEST(PolyphaseResamplerTest, Downsample24kTo16k) {
+    CheckQuality<24000, 16000, 32>(70, 10000, -70);
+}
+
+TEST(PolyphaseResamplerTest, Downsample48kTo16k) {
+    CheckQuality<48000, 16000, 64>(67, 12000, -75);
+}
+
+TEST(PolyphaseResamplerTest, Downsample44k1To16k) {
+    CheckQuality<44100, 16000, 64>(74, 12000, -70);
+}
+
+TEST(PolyphaseResamplerTest, FrameSizeDoesNotChangeOutput) {
+    auto input = MakeTone(24000, 440, 0.5);
+    PolyphaseResampler<24000, 16000, 1, 32> whole, split;
+    auto expected = ResampleInFrames(whole, input, input.size());
+    // 奇数长度的帧，相位在帧之间延续
+    auto actual = ResampleInFrames(split, input, 997);
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(PolyphaseResamplerTest, StereoMatchesMonoPerChannel) {
+    auto left = MakeTone(16000, 700, 0.3);
+    auto right = MakeTone(16000, 2100, 0.3, 8000);
+    std::vector<int16_t> interleaved(left.size() * 2);
+    for (size_t i = 0; i < left.size(); i++) {
+        interleaved[i * 2] = left[i];
+        interleaved[i * 2 + 1] = right[i];
+    }
+
+    PolyphaseResampler<16000, 24000, 2, 32> stereo;
+    PolyphaseResampler<16000, 24000, 1, 32> mono_left, mono_right;
+    auto output = ResampleInFrames(stereo, interleaved, 960 * 2);
+    auto expected_left = ResampleInFrames(mono_left, left, 960);
+    auto expected_right = ResampleInFrames(mono_right, right, 960);
+    ASSERT_EQ(output.size(), expected_left.size() * 2);
+    for (size_t i = 0; i < expected_left.size(); i++) {
+        ASSERT_EQ(output[i * 2], expected_left[i]);
+        ASSERT_EQ(output[i * 2 + 1], expected_right[i]);
+    }
+}
+
+TEST(PolyphaseResamplerTest, ResetClearsHistory) {
+    auto input = MakeTone(48000, 1000, 0.06);
+    PolyphaseResampler<48000, 16000, 1, 64> resampler, fresh;
+    auto first = ResampleInFrames(resampler, input, input.size());
+    resampler.Reset();
+    EXPECT_EQ(ResampleInFrames(resampler, input, input.size()), ResampleInFrames(fresh, input, input.size()));
+    EXPECT_FALSE(first.empty());
+}
@@ -0,0 +1,217 @@
+// SessionLogReader / SessionMicReader 的测试：按 SessionRecorder 的格式构造会话日志，
+// 校验记录遍历、统计、跨记录读取麦克风数据和截断处理。
+// 设置 SESSION_LOG_SAMPLE_DIR 时 WritesSampleForScript 导出样例，供 session_log_test.py 与 scripts/session_log.py 对照
+#include "session_log.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kInputSampleRate = 16000;
+const int kInputChannels = 2;
+
+// 和 SessionRecorder::Append 一样写入记录，payload 补齐到 4 字节
+class LogWriter {
+public:
+    LogWriter() {
+        SessionLogHeader header = {};
+        header.magic = SESSION_LOG_MAGIC;
+        header.version = SESSION_LOG_VERSION;
+        header.input_channels = kInputChannels;
+        header.input_sample_rate = kInputSampleRate;
+        Append(&header, sizeof(header));
+    }
+
+    void Add(SessionRecordType type, uint32_t timestamp_ms, const void* data, size_t size) {
+        SessionRecordHeader header = {};
+        header.type = type;
+        header.timestamp_ms = timestamp_ms;
+        header.size = size;
+        Append(&header, sizeof(header));
+        Append(data, size);
+        data_.resize((data_.size() + 3) & ~3u, 0);
+    }
+
+    std::vector<uint8_t>& data() { return data_; }
+
+private:
+    std::vector<uint8_t> data_;
+
+    void Append(const void* data, size_t size) {
+        auto bytes = (const uint8_t*)data;
+        data_.insert(data_.end(), bytes, bytes + size);
+    }
+};
+
+struct Session {
+    std::vector<uint8_t> log;
+    std::vector<int16_t> mic;
+};
+
+// 一次典型的会话：打开通道，麦克风数据和下行交错，最后关闭通道。
+// 麦克风记录长度不是读取帧长的整数倍，下行 Opus 包长度为奇数，都需要补齐
+Session MakeSession() {
+    Session session;
+    LogWriter writer;
+    uint32_t params[2] = {24000, 60};
+    writer.Add(kSessionRecordChannelOpened, 0, params, sizeof(params));
+
+    uint32_t timestamp = 0;
+    for (int i = 0; i < 7; i++) {
+        std::vector<int16_t> pcm(321 * kInputChannels + i * 2);
+        for (auto& sample : pcm) {
+            sample = (int16_t)(session.mic.size() * 7 + 1);
+            session.mic.push_back(sample);
+        }
+        timestamp += 20;
+        writer.Add(kSessionRecordMicPcm, timestamp, pcm.data(), pcm.size() * sizeof(int16_t));
+        if (i % 2 == 1) {
+            std::vector<uint8_t> opus(37 + i, (uint8_t)i);
+            writer.Add(kSessionRecordDownlinkAudio, timestamp, opus.data(), opus.size());
+        }
+    }
+    const char* json = "{\"type\":\"tts\",\"state\":\"start\"}";
+    writer.Add(kSessionRecordDownlinkJson, timestamp, json, strlen(json));
+    writer.Add(kSessionRecordChannelClosed, timestamp + 5, nullptr, 0);
+    session.log = std::move(writer.data());
+    return session;
+}
+
+std::string Base64(const uint8_t* data, size_t size) {
+    static const char kTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t value = data[i] << 16;
+        if (i + 1 < size) {
+            value |= data[i + 1] << 8;
+        }
+        if (i + 2 < size) {
+            value |= data[i + 2];
+        }
+        text += kTable[(value >> 18) & 63];
+        text += kTable[(value >> 12) & 63];
+        text += i + 1 < size ? kTable[(value >> 6) & 63] : '=';
+        text += i + 2 < size ? kTable[value & 63] : '=';
+    }
+    return text;
+}
+
+}  // namespace
+
+TEST(SessionLogReaderTest, HeaderLayoutMatchesScript) {
+    // scripts/session_log.py 中的 HEADER_FORMAT '<IHHII' 和 RECORD_FORMAT '<B3xII'
+    EXPECT_EQ(sizeof(SessionLogHeader), 16u);
+    EXPECT_EQ(sizeof(SessionRecordHeader), 12u);
+}
+
+TEST(SessionLogReaderTest, SummarizeCountsRecords) {
+    auto session = MakeSession();
+    SessionLogReader log(session.log.data(), session.log.size());
+    ASSERT_TRUE(log.valid());
+    EXPECT_EQ(log.header().input_sample_rate, (uint32_t)kInputSampleRate);
+    EXPECT_EQ(log.header().input_channels, kInputChannels);
+
+    auto summary = log.Summarize();
+    EXPECT_EQ(summary.server_sample_rate, 24000);
+    EXPECT_EQ(summary.server_frame_duration, 60);
+    EXPECT_EQ(summary.mic_records, 7u);
+    EXPECT_EQ(summary.mic_samples, session.mic.size());
+    EXPECT_EQ(summary.downlink_packets, 3u);
+    EXPECT_EQ(summary.json_messages, 1u);
+    EXPECT_EQ(summary.recorded_ms, 145u);
+    EXPECT_TRUE(summary.closed);
+}
+
+TEST(SessionLogReaderTest, MicReaderCrossesRecordsAndPadsSilence) {
+    auto session = MakeSession();
+    SessionLogReader log(session.log.data(), session.log.size());
+    SessionMicReader mic(log);
+
+    // 和 AudioCodec 一样按固定帧长读取，帧跨越多条记录
+    const size_t frame = 512 * kInputChannels;
+    std::vector<int16_t> output;
+    size_t recorded = 0;
+    while (!mic.done()) {
+        std::vector<int16_t> data(frame, -1);
+        recorded += mic.Read(data.data(), data.size());
+        output.insert(output.end(), data.begin(), data.end());
+        ASSERT_LE(output.size(), session.mic.size() + frame);
+    }
+
+    EXPECT_EQ(recorded, session.mic.size());
+    EXPECT_EQ(mic.records(), log.Summarize().mic_records);
+    ASSERT_GE(output.size(), session.mic.size());
+    EXPECT_TRUE(std::equal(session.mic.begin(), session.mic.end(), output.begin()));
+    for (size_t i = session.mic.size(); i < output.size(); i++) {
+        ASSERT_EQ(output[i], 0);
+    }
+}
+
+TEST(SessionLogReaderTest, TruncatedRecordEndsIteration) {
+    auto session = MakeSession();
+    SessionLogReader full(session.log.data(), session.log.size());
+    auto expected = full.Summarize();
+
+    // 截掉关闭记录和 JSON 记录的后半部分，和录制缓冲区写满时一样
+    size_t size = session.log.size() - sizeof(SessionRecordHeader) - 10;
+    SessionLogReader log(session.log.data(), size);
+    auto summary = log.Summarize();
+    EXPECT_FALSE(summary.closed);
+    EXPECT_EQ(summary.json_messages, 0u);
+    EXPECT_EQ(summary.mic_records, expected.mic_records);
+    EXPECT_EQ(summary.downlink_packets, expected.downlink_packets);
+}
+
+TEST(SessionLogReaderTest, RejectsForeignData) {
+    std::vector<uint8_t> data(64, 0x5a);
+    EXPECT_FALSE(SessionLogReader(data.data(), data.size()).valid());
+    EXPECT_FALSE(SessionLogReader(data.data(), sizeof(SessionLogHeader) - 1).valid());
+
+    auto session = MakeSession();
+    session.log[4] = SESSION_LOG_VERSION + 1;
+    EXPECT_FALSE(SessionLogReader(session.log.data(), session.log.size()).valid());
+}
+
+// 导出二进制日志、"record dump" 格式的串口日志和设备端的统计，由 session_log_test.py 调用
+TEST(SessionLogReaderTest, WritesSampleForScript) {
+    const char* directory = getenv("SESSION_LOG_SAMPLE_DIR");
+    if (directory == nullptr) {
+        GTEST_SKIP() << "SESSION_LOG_SAMPLE_DIR not set";
+    }
+    auto session = MakeSession();
+    SessionLogReader log(session.log.data(), session.log.size());
+    auto summary = log.Summarize();
+
+    std::string base = directory;
+    FILE* fp = fopen((base + "/session.bin").c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    fwrite(session.log.data(), 1, session.log.size(), fp);
+    fclose(fp);
+
+    // 和 SessionRecorder::Dump 一样每行 48 字节，前面混入 ESP_LOG 的输出
+    fp = fopen((base + "/serial.txt").c_str(), "w");
+    ASSERT_NE(fp, nullptr);
+    fprintf(fp, "I (1234) SessionRecorder: Recording stopped\n");
+    for (size_t offset = 0; offset < session.log.size(); offset += 48) {
+        size_t length = std::min<size_t>(48, session.log.size() - offset);
+        fprintf(fp, "RECORD %s\n", Base64(session.log.data() + offset, length).c_str());
+    }
+    fprintf(fp, "RECORD END %u\nesp32> \n", (unsigned)session.log.size());
+    fclose(fp);
+
+    fp = fopen((base + "/summary.json").c_str(), "w");
+    ASSERT_NE(fp, nullptr);
+    fprintf(fp, "{\"recorded_ms\":%u,\"server_sample_rate\":%d,\"server_frame_duration\":%d,\"mic_records\":%u,"
+        "\"mic_samples\":%llu,\"downlink_packets\":%u,\"json_messages\":%u,\"closed\":%s}\n",
+        (unsigned)summary.recorded_ms, summary.server_sample_rate, summary.server_frame_duration,
+        (unsigned)summary.mic_records, (unsigned long long)summary.mic_samples, (unsigned)summary.downlink_packets,
+        (unsigned)summary.json_messages, summary.closed ? "true" : "false");
+    fclose(fp);
+}
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+scripts/session_log.py 的测试：串口导出还原、记录解析和统计。
+与设备端 SessionLogReader 对照时，调用 session_log_test 导出同一份样例：
+
+  python test/host/session_log_test.py <path to session_log_test>
+"""
+import base64
+import json
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', '..', 'scripts'))
+import session_log  # noqa: E402
+
+READER_TEST = None
+
+
+def make_log(records, channels=1, sample_rate=16000):
+    data = struct.pack(session_log.HEADER_FORMAT, session_log.SESSION_LOG_MAGIC, session_log.SESSION_LOG_VERSION,
+                       channels, sample_rate, 0)
+    for type_, timestamp, payload in records:
+        data += struct.pack(session_log.RECORD_FORMAT, type_, timestamp, len(payload))
+        data += payload + bytes(-len(payload) % 4)
+    return data
+
+
+def write_serial(directory, data, prefix='', end=True, size=None):
+    path = os.path.join(directory, 'serial.txt')
+    with open(path, 'w') as f:
+        f.write('I (100) main: boot\n')
+        for offset in range(0, len(data), 48):
+            f.write(f'{prefix}RECORD {base64.b64encode(data[offset:offset + 48]).decode()}\n')
+        if end:
+            f.write(f'RECORD END {len(data) if size is None else size}\n')
+    return path
+
+
+class SessionLogScriptTest(unittest.TestCase):
+    def test_record_layout(self):
+        self.assertEqual(struct.calcsize(session_log.HEADER_FORMAT), 16)
+        self.assertEqual(struct.calcsize(session_log.RECORD_FORMAT), 12)
+
+    def test_parse_skips_padding(self):
+        opus = bytes(range(5))
+        data = make_log([
+            (session_log.RECORD_CHANNEL_OPENED, 0, struct.pack('<II', 24000, 60)),
+            (session_log.RECORD_DOWNLINK_AUDIO, 10, opus),
+            (session_log.RECORD_MIC_PCM, 20, struct.pack('<3h', 1, -2, 3)),
+            (session_log.RECORD_CHANNEL_CLOSED, 30, b''),
+        ])
+        channels, sample_rate, records = session_log.parse(data)
+        self.assertEqual((channels, sample_rate), (1, 16000))
+        self.assertEqual([r[0] for r in records], [1, 4, 3, 2])
+        self.assertEqual(records[1][2], opus)
+
+        summary = session_log.summarize(channels, sample_rate, records)
+        self.assertEqual(summary['server_sample_rate'], 24000)
+        self.assertEqual(summary['server_frame_duration'], 60)
+        self.assertEqual(summary['mic_samples'], 3)
+        self.assertEqual(summary['downlink_bytes'], 5)
+        self.assertEqual(summary['recorded_ms'], 30)
+        self.assertTrue(summary['closed'])
+
+    def test_truncated_record_is_dropped(self):
+        data = make_log([
+            (session_log.RECORD_MIC_PCM, 20, bytes(64)),
+            (session_log.RECORD_MIC_PCM, 40, bytes(64)),
+        ])
+        _, _, records = session_log.parse(data[:-10])
+        self.assertEqual(len(records), 1)
+
+    def test_rejects_foreign_data(self):
+        with self.assertRaises(SystemExit):
+            session_log.parse(bytes(64))
+
+    def test_serial_round_trip_with_log_prefix(self):
+        data = make_log([(session_log.RECORD_MIC_PCM, 20, bytes(range(200)))])
+        with tempfile.TemporaryDirectory() as directory:
+            path = write_serial(directory, data, prefix='\x1b[0m')
+            self.assertEqual(session_log.from_serial(path), data)
+
+    def test_serial_incomplete_dump(self):
+        data = make_log([(session_log.RECORD_MIC_PCM, 20, bytes(200))])
+        with tempfile.TemporaryDirectory() as directory:
+            with self.assertRaises(SystemExit):
+                session_log.from_serial(write_serial(directory, data, end=False))
+            with self.assertRaises(SystemExit):
+                session_log.from_serial(write_serial(directory, data, size=len(data) + 1))
+
+    def test_matches_device_reader(self):
+        if READER_TEST is None:
+            self.skipTest('session_log_test binary not given')
+        with tempfile.TemporaryDirectory() as directory:
+            env = dict(os.environ, SESSION_LOG_SAMPLE_DIR=directory)
+            subprocess.run([READER_TEST, '--gtest_filter=SessionLogReaderTest.WritesSampleForScript'],
+                           env=env, check=True, stdout=subprocess.DEVNULL)
+            with open(os.path.join(directory, 'session.bin'), 'rb') as f:
+                data = f.read()
+            with open(os.path.join(directory, 'summary.json')) as f:
+                expected = json.load(f)
+
+            self.assertEqual(session_log.from_serial(os.path.join(directory, 'serial.txt')), data)
+            summary = session_log.summarize(*session_log.parse(data))
+            for key, value in expected.items():
+                self.assertEqual(summary[key], value, key)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) > 1 and not sys.argv[1].startswith('-'):
+        READER_TEST = sys.argv.pop(1)
+    unittest.main()
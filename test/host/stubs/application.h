@@ -0,0 +1,16 @@
+// 主机测试用的 application.h：iot::Thing 通过 Schedule 在主循环中执行方法，主机上直接执行
+#pragma once
+
+#include <functional>
+
+class Application {
+public:
+    static Application& GetInstance() {
+        static Application instance;
+        return instance;
+    }
+
+    void Schedule(std::function<void()> callback) {
+        callback();
+    }
+};
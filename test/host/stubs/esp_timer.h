@@ -0,0 +1,10 @@
+// 主机测试用的 esp_timer.h，只提供 esp_timer_get_time
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+inline int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
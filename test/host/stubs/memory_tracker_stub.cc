@@ -0,0 +1,13 @@
+// 主机测试不统计内存，MemoryTracker 直接转发到堆
+#include "memory_tracker.h"
+
+MemoryTracker::MemoryTracker() {
+}
+
+void* MemoryTracker::Malloc(MemoryTag tag, size_t size, uint32_t caps) {
+    return heap_caps_malloc(size, caps);
+}
+
+void MemoryTracker::Free(void* ptr) {
+    heap_caps_free(ptr);
+}
@@ -0,0 +1,23 @@
+// 主机测试用的 opus_resampler.h：主机上没有 esp-opus-encoder 组件，
+// 只让 AudioResampler 能编译，主机上只使用多相滤波覆盖的采样率组合，走到回退路径时直接退出
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+class OpusResampler {
+public:
+    void Configure(int input_sample_rate, int output_sample_rate) {
+        fprintf(stderr, "OpusResampler %d -> %d is not available on the host\n", input_sample_rate,
+            output_sample_rate);
+        abort();
+    }
+
+    int GetOutputSamples(int input_samples) const {
+        return 0;
+    }
+
+    void Process(const int16_t* input, int input_samples, int16_t* output) {
+    }
+};
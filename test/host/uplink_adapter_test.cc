@@ -0,0 +1,123 @@
+// UplinkAdapter 的分级、迟滞和步进测试
+#include "protocols/uplink_adapter.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+const int kMaxComplexity = 5;
+// 编码占用处于上下限之间，复杂度不变
+const int kSteadyLoad = 30;
+
+struct Window {
+    int loss_percent;
+    int send_latency_ms;
+    int encode_load_percent;
+};
+
+// 依次喂入多个统计窗口，返回最后一次 Update 的结果
+bool Feed(UplinkAdapter& adapter, std::initializer_list<Window> windows) {
+    UplinkAdapter::Decision decision;
+    bool changed = false;
+    for (auto& window : windows) {
+        changed = adapter.Update(window.loss_percent, window.send_latency_ms, window.encode_load_percent, decision);
+        EXPECT_EQ(decision.frame_duration, adapter.frame_duration());
+        EXPECT_EQ(decision.complexity, adapter.complexity());
+    }
+    return changed;
+}
+
+}  // namespace
+
+TEST(UplinkAdapterTest, GoodLinkSwitchesToShortFramesAfterTwoWindows) {
+    UplinkAdapter adapter(60, kMaxComplexity);
+    EXPECT_FALSE(Feed(adapter, {{0, 10, kSteadyLoad}}));
+    EXPECT_EQ(adapter.frame_duration(), 60);
+    EXPECT_TRUE(Feed(adapter, {{0, 10, kSteadyLoad}}));
+    EXPECT_EQ(adapter.frame_duration(), 20);
+}
+
+TEST(UplinkAdapterTest, ClassifiesLinkByLossAndLatency) {
+    struct Case {
+        int loss_percent;
+        int send_latency_ms;
+        int expected;
+    } cases[] = {
+        {0, 59, 20},
+        {0, 60, 40},
+        {1, 0, 40},
+        {4, 149, 40},
+        {5, 0, 60},
+        {0, 150, 60},
+    };
+    for (auto& c : cases) {
+        UplinkAdapter adapter(c.expected == 60 ? 20 : 60, kMaxComplexity);
+        Feed(adapter, {{c.loss_percent, c.send_latency_ms, kSteadyLoad}, {c.loss_percent, c.send_latency_ms, kSteadyLoad}});
+        EXPECT_EQ(adapter.frame_duration(), c.expected) << "loss " << c.loss_percent << " latency " << c.send_latency_ms;
+    }
+}
+
+TEST(UplinkAdapterTest, AlternatingWindowsDoNotFlap) {
+    UplinkAdapter adapter(40, kMaxComplexity);
+    UplinkAdapter::Decision decision;
+    for (int i = 0; i < 20; i++) {
+        bool bad = i % 2 == 0;
+        EXPECT_FALSE(adapter.Update(bad ? 10 : 0, 10, kSteadyLoad, decision));
+        EXPECT_EQ(adapter.frame_duration(), 40);
+    }
+}
+
+TEST(UplinkAdapterTest, WindowMatchingCurrentClearsPendingSwitch) {
+    UplinkAdapter adapter(40, kMaxComplexity);
+    // 一个坏窗口、一个与当前一致的窗口、再一个坏窗口：两次坏窗口不连续，不切换
+    EXPECT_FALSE(Feed(adapter, {{10, 10, kSteadyLoad}, {2, 10, kSteadyLoad}, {10, 10, kSteadyLoad}}));
+    EXPECT_EQ(adapter.frame_duration(), 40);
+    EXPECT_TRUE(Feed(adapter, {{10, 10, kSteadyLoad}}));
+    EXPECT_EQ(adapter.frame_duration(), 60);
+}
+
+TEST(UplinkAdapterTest, HighEncodeLoadBlocksShortFrames) {
+    UplinkAdapter adapter(60, kMaxComplexity);
+    Feed(adapter, {{0, 10, 40}, {0, 10, 40}});
+    EXPECT_EQ(adapter.frame_duration(), 40);
+}
+
+TEST(UplinkAdapterTest, ComplexityStepsOneLevelPerWindow) {
+    UplinkAdapter adapter(60, kMaxComplexity);
+    UplinkAdapter::Decision decision;
+    // 过载时每个窗口降 1 级，直到 0
+    for (int expected = kMaxComplexity - 1; expected >= 0; expected--) {
+        EXPECT_TRUE(adapter.Update(5, 200, 60, decision));
+        EXPECT_EQ(decision.complexity, expected);
+    }
+    EXPECT_FALSE(adapter.Update(5, 200, 60, decision));
+    EXPECT_EQ(decision.complexity, 0);
+
+    // 上下限之间保持不变
+    EXPECT_FALSE(adapter.Update(5, 200, 25, decision));
+    EXPECT_FALSE(adapter.Update(5, 200, 59, decision));
+    EXPECT_EQ(decision.complexity, 0);
+
+    // 空闲时每个窗口升 1 级，不超过上限
+    for (int expected = 1; expected <= kMaxComplexity; expected++) {
+        EXPECT_TRUE(adapter.Update(5, 200, 24, decision));
+        EXPECT_EQ(decision.complexity, expected);
+    }
+    EXPECT_FALSE(adapter.Update(5, 200, 0, decision));
+    EXPECT_EQ(decision.complexity, kMaxComplexity);
+}
+
+TEST(UplinkAdapterTest, ResetRestoresInitialFrameDurationOnly) {
+    UplinkAdapter adapter(60, kMaxComplexity);
+    Feed(adapter, {{0, 10, 70}, {0, 10, 70}});
+    ASSERT_EQ(adapter.frame_duration(), 40);
+    ASSERT_EQ(adapter.complexity(), kMaxComplexity - 2);
+
+    // 只走了一半的切换也一并清除
+    Feed(adapter, {{0, 10, 30}});
+    adapter.Reset();
+    EXPECT_EQ(adapter.frame_duration(), 60);
+    EXPECT_EQ(adapter.complexity(), kMaxComplexity - 2);
+    EXPECT_FALSE(Feed(adapter, {{10, 10, 30}}));
+    EXPECT_EQ(adapter.frame_duration(), 60);
+}
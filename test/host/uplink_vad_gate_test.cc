@@ -0,0 +1,96 @@
+// UplinkVadGate 的保持、预录和帧对齐测试。
+// 输入按 AFE 的 512 采样（32ms）分块，编码器帧长为 60ms（960 采样），两者不对齐
+#include "audio_processing/uplink_vad_gate.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+const int kChunkSamples = 512;
+const int kFrameSamples = 960;
+const int kHangoverMs = 600;
+const int kPrerollMs = 320;
+
+// 模拟 Application 中的编码器：只统计送入的采样数和未凑满一帧的采样数
+struct Uplink {
+    UplinkVadGate gate{kHangoverMs, kPrerollMs};
+    size_t input = 0;
+    size_t encoded = 0;
+    int pending = 0;
+    int skipped_ms = 0;
+    std::vector<std::vector<int16_t>> last_output;
+
+    Uplink() {
+        gate.Reset();
+    }
+
+    void Feed(bool voice, int chunks) {
+        for (int i = 0; i < chunks; i++) {
+            last_output.clear();
+            input += kChunkSamples;
+            skipped_ms += gate.Process(std::vector<int16_t>(kChunkSamples), voice, kFrameSamples, pending,
+                last_output);
+            for (auto& pcm : last_output) {
+                encoded += pcm.size();
+                pending = (pending + pcm.size()) % kFrameSamples;
+            }
+            if (gate.closed()) {
+                ASSERT_EQ(pending, 0);
+            }
+        }
+    }
+};
+
+}  // namespace
+
+TEST(UplinkVadGateTest, KeepsSendingDuringHangover) {
+    Uplink uplink;
+    uplink.Feed(true, 10);
+    uplink.Feed(false, kHangoverMs / 32);
+    EXPECT_FALSE(uplink.gate.closed());
+    EXPECT_EQ(uplink.encoded, uplink.input);
+    EXPECT_EQ(uplink.skipped_ms, 0);
+}
+
+TEST(UplinkVadGateTest, ClosesOnFrameBoundary) {
+    Uplink uplink;
+    uplink.Feed(true, 7);
+    uplink.Feed(false, kHangoverMs / 32 + 1);
+    ASSERT_NE(uplink.pending, 0);
+    EXPECT_FALSE(uplink.gate.closed());
+
+    // 补齐编码器中的半帧后才停止上传
+    uplink.Feed(false, 3);
+    EXPECT_TRUE(uplink.gate.closed());
+    EXPECT_EQ(uplink.pending, 0);
+    size_t encoded = uplink.encoded;
+    uplink.Feed(false, 40);
+    EXPECT_EQ(uplink.encoded, encoded);
+}
+
+TEST(UplinkVadGateTest, SkipsWholeFramesAndReplaysPreroll) {
+    Uplink uplink;
+    for (int round = 0; round < 3; round++) {
+        uplink.Feed(true, 5 + round);
+        uplink.Feed(false, 60 + round * 7);
+        ASSERT_TRUE(uplink.gate.closed());
+        ASSERT_GT(uplink.skipped_ms, 0);
+        ASSERT_EQ(uplink.skipped_ms % (kFrameSamples / 16), 0);
+
+        // 重新开口：先补发预录，之后上传和跳过的时长之和等于输入时长，时间戳没有漂移
+        uplink.Feed(true, 1);
+        ASSERT_EQ(uplink.last_output.size(), 2u);
+        EXPECT_GE(uplink.last_output[0].size(), (size_t)kPrerollMs * 16);
+        EXPECT_LT(uplink.last_output[0].size(), (size_t)(kPrerollMs * 16 + kFrameSamples));
+        EXPECT_EQ(uplink.encoded + uplink.skipped_ms * 16, uplink.input);
+    }
+}
+
+TEST(UplinkVadGateTest, ResetReopens) {
+    Uplink uplink;
+    uplink.Feed(true, 5);
+    uplink.Feed(false, 60);
+    ASSERT_TRUE(uplink.gate.closed());
+    uplink.gate.Reset();
+    EXPECT_FALSE(uplink.gate.closed());
+}